@@ -4,6 +4,11 @@ TARGET_NAMES_$(n) := $(TARGET_NAMES)
 ifdef STEST
 	TARGET_NAMES_$(n) += stest
 endif
+ifdef BENCH
+	TARGET_NAMES_$(n) += $(BENCH_NAMES)
+endif
+# Benchmarks are optional, so don't carry them over to the next problem.
+BENCH_NAMES :=
 
 PROBLEM_$(n)  := $(PROBLEMS_DIR)/$(n)
 _BIN_BUILD_$(n)   := $(OBJDIR_$(n))/%
@@ -0,0 +1,57 @@
+/** @file FunctionRef.hpp
+ *
+ * Contains the FunctionRef class, a non-owning reference to a callable object.
+ */
+#ifndef SOLVER_FUNCTIONREF_HPP_
+#define SOLVER_FUNCTIONREF_HPP_
+
+#include <memory>                       // for addressof
+#include <type_traits>                  // for decay, enable_if, is_same, remove_reference
+#include <utility>                      // for forward
+
+namespace tapir {
+template<typename Signature> class FunctionRef;
+
+/** A non-owning reference to a callable object with the given signature.
+ *
+ * Unlike std::function, a FunctionRef never copies the callable or allocates memory, which
+ * makes it suitable for passing a lambda to a virtual method that is called in a tight loop,
+ * e.g. to visit each of the entries in a mapping.
+ *
+ * The referenced callable must outlive the FunctionRef, so a FunctionRef should only be used as
+ * a function parameter.
+ */
+template<typename ReturnType, typename... Args>
+class FunctionRef<ReturnType(Args...)> {
+  public:
+    /** Makes a reference to the given callable object. */
+    template<typename Function, typename = typename std::enable_if<
+            !std::is_same<typename std::decay<Function>::type, FunctionRef>::value>::type>
+    FunctionRef(Function &&function) :
+        callable_(const_cast<void *>(static_cast<void const *>(std::addressof(function)))),
+        invoker_(&invoke<typename std::remove_reference<Function>::type>) {
+    }
+    FunctionRef(FunctionRef const &) = default;
+    FunctionRef &operator=(FunctionRef const &) = default;
+    ~FunctionRef() = default;
+
+    /** Calls the referenced callable object. */
+    ReturnType operator()(Args... args) const {
+        return invoker_(callable_, std::forward<Args>(args)...);
+    }
+
+  private:
+    /** Calls a callable object of the given type. */
+    template<typename Function>
+    static ReturnType invoke(void *callable, Args... args) {
+        return (*static_cast<Function *>(callable))(std::forward<Args>(args)...);
+    }
+
+    /** The referenced callable object. */
+    void *callable_;
+    /** The function that calls callable_ with the right type. */
+    ReturnType (*invoker_)(void *, Args...);
+};
+} /* namespace tapir */
+
+#endif /* SOLVER_FUNCTIONREF_HPP_ */
@@ -10,7 +10,10 @@
 #include <ctime>
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <functional>
+#include <limits>
 #include <locale>
 #include <memory>                       // for unique_ptr
 #include <random>                       // for default_random_engine
@@ -41,6 +44,70 @@ inline double clock_ms() {
     return std::clock() * 1000.0 / CLOCKS_PER_SEC;
 }
 
+/** Returns the elapsed wall-clock time (in ms) since an arbitrary fixed starting point.
+ *
+ * Unlike clock_ms(), this does not accumulate the CPU time of every running thread, so it is the
+ * one to use for deadlines when searching with multiple threads.
+ */
+inline double wall_clock_ms() {
+    return std::chrono::duration<double, std::milli>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+/** A deadline measured in wall-clock time (see wall_clock_ms()), which keeps running while the
+ * process is blocked and doesn't depend on the number of threads.
+ */
+class Deadline {
+public:
+    /** Makes a deadline the given number of milliseconds from now; by default it never expires. */
+    explicit Deadline(double budget = std::numeric_limits<double>::infinity()) :
+            endTime_(wall_clock_ms() + budget) {
+    }
+
+    /** Returns true iff this deadline can ever expire. */
+    bool isFinite() const {
+        return endTime_ != std::numeric_limits<double>::infinity();
+    }
+    /** Returns true iff this deadline has passed. */
+    bool hasExpired() const {
+        return isFinite() && wall_clock_ms() >= endTime_;
+    }
+    /** Returns the time (in ms) left before this deadline; negative once it has passed. */
+    double getRemainingTime() const {
+        return endTime_ - wall_clock_ms();
+    }
+
+private:
+    /** The wall-clock time at which this deadline expires. */
+    double endTime_;
+};
+
+/** A flag that any thread can set to ask a long-running operation (e.g. a search) to stop. */
+class StopToken {
+public:
+    StopToken() :
+            isStopRequested_(false) {
+    }
+    _NO_COPY_OR_MOVE(StopToken);
+
+    /** Asks the operation(s) using this token to stop. */
+    void requestStop() {
+        isStopRequested_ = true;
+    }
+    /** Clears any earlier request to stop, so that this token can be used again. */
+    void reset() {
+        isStopRequested_ = false;
+    }
+    /** Returns true iff a stop has been requested. */
+    bool isStopRequested() const {
+        return isStopRequested_;
+    }
+
+private:
+    /** True iff a stop has been requested. */
+    std::atomic<bool> isStopRequested_;
+};
+
 /** A template method to combine hash values - from boost::hash_combine */
 template<class T>
 inline void hash_combine(std::size_t &seed, T const &v) {
@@ -28,7 +28,7 @@
 #include "solver/changes/ChangeFlags.hpp"        // for ChangeFlags
 
 #include "solver/indexing/FlaggingVisitor.hpp"
-#include "solver/indexing/RTree.hpp"
+#include "solver/indexing/PackedRTree.hpp"
 #include "solver/indexing/SpatialIndexVisitor.hpp"             // for State, operator<<, operator==
 
 #include "solver/mappings/actions/enumerated_actions.hpp"
@@ -612,6 +612,18 @@ void HomecareModel::applyChanges(std::vector<std::unique_ptr<solver::ModelChange
         }
     }
 
+    // The states affected by all of the changes are flagged together, in a single query.
+    solver::PackedRTree *tree = nullptr;
+    if (pool != nullptr) {
+        tree = static_cast<solver::PackedRTree *>(pool->getStateIndex());
+        if (tree == nullptr) {
+            debug::show_message("ERROR: state index must be enabled to handle changes in Homecare!");
+            std::exit(4);
+        }
+    }
+    solver::FlaggingVisitor visitor(pool, solver::ChangeFlags::TRANSITION);
+    std::vector<solver::PackedRTree::QueryBox> boxes;
+
     for (auto const &change : changes) {
         HomecareChange const &homecareChange = static_cast<HomecareChange const &>(*change);
         if (options_->hasVerboseOutput) {
@@ -639,12 +651,6 @@ void HomecareModel::applyChanges(std::vector<std::unique_ptr<solver::ModelChange
             continue;
         }
 
-        solver::RTree *tree = static_cast<solver::RTree *>(pool->getStateIndex());
-        if (tree == nullptr) {
-            debug::show_message("ERROR: state index must be enabled to handle changes in Homecare!");
-            std::exit(4);
-        }
-
         double iLo = homecareChange.i0;
         double iHi = homecareChange.i1;
         double iMx = nRows_ - 1.0;
@@ -654,10 +660,12 @@ void HomecareModel::applyChanges(std::vector<std::unique_ptr<solver::ModelChange
         double jMx = nCols_ - 1.0;
 
         // Revise state transitions
-        solver::FlaggingVisitor visitor(pool, solver::ChangeFlags::TRANSITION);
-        tree->boxQuery(visitor,
-                {0.0, 0.0, iLo - 1, jLo - 1, 0.0},
-                {iMx, jMx, iHi + 1, jHi + 1, 0.0});
+        boxes.push_back({{0.0, 0.0, iLo - 1, jLo - 1, 0.0}, {iMx, jMx, iHi + 1, jHi + 1, 0.0},
+                &visitor});
+    }
+
+    if (tree != nullptr) {
+        tree->boxQueries(boxes);
     }
 
     // Check for heuristic changes.
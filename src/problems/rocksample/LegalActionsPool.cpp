@@ -7,6 +7,7 @@
 
 #include <iostream>
 #include <memory>
+#include <mutex>
 
 #include "solver/Solver.hpp"
 
@@ -17,7 +18,8 @@ namespace rocksample {
 LegalActionsPool::LegalActionsPool(RockSampleModel *model) :
         EnumeratedActionPool(model, model->getAllActionsInOrder()),
         model_(model),
-        mappings_() {
+        mappings_(),
+        mappingsMutex_() {
 }
 
 std::vector<long> LegalActionsPool::createBinSequence(solver::BeliefNode *node) {
@@ -38,15 +40,18 @@ std::unique_ptr<solver::ActionMapping> LegalActionsPool::createActionMapping(
 }
 
 void LegalActionsPool::addMapping(GridPosition position, LegalActionsMap *map) {
+    std::lock_guard<std::mutex> lock(mappingsMutex_);
     mappings_[position].insert(map);
 }
 
 void LegalActionsPool::removeMapping(GridPosition position, LegalActionsMap *map) {
+    std::lock_guard<std::mutex> lock(mappingsMutex_);
     mappings_[position].erase(mappings_[position].find(map));
 }
 
 void LegalActionsPool::setLegal(bool isLegal, GridPosition position,
         RockSampleAction const &action, solver::Solver *solver) {
+    std::lock_guard<std::mutex> lock(mappingsMutex_);
     for (solver::DiscretizedActionMap *discMap : mappings_[position]) {
         // Only change affected belief nodes.
         if (solver == nullptr || solver->isAffected(discMap->getOwner())) {
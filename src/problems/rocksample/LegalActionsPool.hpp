@@ -8,6 +8,7 @@
 #define ROCKSAMPLE_LEGALACTIONSPOOL_HPP_
 
 #include <memory>
+#include <mutex>
 #include <vector>
 
 #include "solver/mappings/actions/enumerated_actions.hpp"
@@ -59,6 +60,10 @@ class LegalActionsPool: public solver::EnumeratedActionPool {
     RockSampleModel *model_;
     /** A mapping of grid positions to the set of actionmap. */
     std::unordered_map<GridPosition, std::unordered_set<LegalActionsMap *>> mappings_;
+    /** Guards mappings_, since pruned mappings are removed in the background while the search
+     * creates new ones.
+     */
+    std::mutex mappingsMutex_;
 };
 
 /** A custom mapping class that keeps track of which actions are legal or illegal at each belief
@@ -14,6 +14,7 @@
 
 #include "solver/abstract-problem/Action.hpp"
 #include "solver/abstract-problem/DiscretizedPoint.hpp"             // for DiscretizedPoint
+#include "solver/abstract-problem/Recyclable.hpp"
 
 namespace rocksample {
 /** An enumeration of the possible action types in RockSample.
@@ -67,7 +68,8 @@ inline std::ostream &operator<<(std::ostream &os, ActionType const actionType) {
  * enumerated action mapping approach (EnumeratedActionPool) to store the available actions from
  * each belief node.
  */
-class RockSampleAction : public solver::DiscretizedPoint {
+class RockSampleAction : public solver::DiscretizedPoint,
+        public solver::Recyclable<RockSampleAction> {
     friend class RockSampleTextSerializer;
   public:
     /** Constructs a new action from the given ActionType. */
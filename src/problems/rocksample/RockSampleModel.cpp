@@ -32,7 +32,7 @@
 #include "solver/abstract-problem/Observation.hpp"       // for Observation
 #include "solver/abstract-problem/State.hpp"       // for State
 
-#include "solver/indexing/RTree.hpp"
+#include "solver/indexing/PackedRTree.hpp"
 #include "solver/indexing/FlaggingVisitor.hpp"
 
 #include "solver/mappings/actions/ActionMapping.hpp"
@@ -496,7 +496,7 @@ void RockSampleModel::applyChanges(std::vector<std::unique_ptr<solver::ModelChan
         }
 
         // If we're adding obstacles, we need to mark the invalid states as deleted.
-        solver::RTree *tree = static_cast<solver::RTree *>(pool->getStateIndex());
+        solver::PackedRTree *tree = static_cast<solver::PackedRTree *>(pool->getStateIndex());
         if (tree == nullptr) {
             debug::show_message("ERROR: state index must be enabled to handle changes in RockSample!");
             std::exit(4);
@@ -869,4 +869,14 @@ std::unique_ptr<solver::Serializer> RockSampleModel::createSerializer(solver::So
         return std::make_unique<RockSampleBasicTextSerializer>(solver);
     }
 }
+std::unique_ptr<solver::Model> RockSampleModel::createWorkerModel(RandomGenerator *randGen) {
+    std::unique_ptr<RockSampleOptions> options = std::make_unique<RockSampleOptions>(*options_);
+    options->hasVerboseOutput = false;
+    std::unique_ptr<RockSampleModel> model = std::make_unique<RockSampleModel>(randGen,
+            std::move(options));
+    // The map may have changed since it was read from the file.
+    model->envMap_ = envMap_;
+    model->recalculateAllDistances();
+    return std::move(model);
+}
 } /* namespace rocksample */
@@ -273,6 +273,8 @@ friend class RockSampleMdpSolver;
 
     virtual std::unique_ptr<solver::Serializer> createSerializer(solver::Solver *solver) override;
 
+    virtual std::unique_ptr<solver::Model> createWorkerModel(RandomGenerator *randGen) override;
+
 
     /* ----------- Non-virtual methods for RockSampleModel ------------- */
     /** Returns true iff the given position is a valid grid square for the robot to be in. */
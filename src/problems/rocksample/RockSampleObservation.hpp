@@ -12,6 +12,7 @@
 
 #include "solver/abstract-problem/DiscretizedPoint.hpp"
 #include "solver/abstract-problem/Observation.hpp"
+#include "solver/abstract-problem/Recyclable.hpp"
 
 #include "global.hpp"                     // for RandomGenerator
 
@@ -25,7 +26,8 @@ namespace rocksample {
  * enumerated observation mapping approach (EnumeratedObservationPool) to store the possible
  * observations from each ActionNode.
  */
-class RockSampleObservation : public solver::DiscretizedPoint {
+class RockSampleObservation : public solver::DiscretizedPoint,
+        public solver::Recyclable<RockSampleObservation> {
     friend class RockSampleTextSerializer;
 
   public:
@@ -13,6 +13,7 @@
 #include "problems/shared/GridPosition.hpp"  // for GridPosition
 #include "solver/abstract-problem/State.hpp"             // for State
 #include "solver/abstract-problem/VectorState.hpp"             // for VectorState
+#include "solver/abstract-problem/Recyclable.hpp"
 
 namespace rocksample {
 /** A class representing a state in the RockSample POMDP.
@@ -24,7 +25,8 @@ namespace rocksample {
  * converted to a vector<double>, which can then be used inside the standard R*-tree implementation
  * of StateIndex to allow spatial lookup of states.
  */
-class RockSampleState : public solver::VectorState {
+class RockSampleState : public solver::VectorState,
+        public solver::Recyclable<RockSampleState> {
     friend class RockSampleTextSerializer;
   public:
     /** Constructs a new RockSampleState with the given robot position, and the given goodness states
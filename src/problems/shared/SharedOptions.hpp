@@ -207,10 +207,30 @@ struct SharedOptions: public solver::Options {
 
         parser->addOptionWithDefault<double>("ABT", "stepTimeout", &Options::stepTimeout, 0.0);
         parser->addValueArg<double>("ABT", "stepTimeout", &Options::stepTimeout,
-                "t", "timeout", "step timeout in milliseconds; 0=>no timeout", "real");
+                "t", "timeout", "step timeout in wall-clock milliseconds; 0=>no timeout", "real");
+
+        parser->addOptionWithDefault<double>("ABT", "changeTimeout", &Options::changeTimeout, 0.0);
+        parser->addValueArg<double>("ABT", "changeTimeout", &Options::changeTimeout,
+                "", "change-timeout", "time limit in wall-clock milliseconds for revising histories"
+                " after changes; the rest are revised before later searches; 0=>no limit", "real");
 
         parser->addOption<long>("ABT", "maximumDepth", &Options::maximumDepth);
         parser->addOption<bool>("ABT", "isAbsoluteHorizon", &Options::isAbsoluteHorizon);
+        parser->addOptionWithDefault<double>("ABT", "backupTolerance", &Options::backupTolerance,
+                0.0);
+
+        parser->addOptionWithDefault<long>("ABT", "nThreads", &Options::nThreads, 1);
+        parser->addValueArg<long>("ABT", "nThreads", &Options::nThreads,
+                "", "threads", "number of threads to use for parallel search", "int");
+        parser->addOptionWithDefault<bool>("ABT", "useTreeParallelSearch",
+                &Options::useTreeParallelSearch, false);
+        parser->addSwitchArg("ABT", "useTreeParallelSearch", &Options::useTreeParallelSearch, "",
+                "tree-parallel", "have all threads search a single shared tree", true);
+
+        parser->addOptionWithDefault<bool>("ABT", "usePondering", &Options::usePondering, false);
+        parser->addSwitchArg("ABT", "usePondering", &Options::usePondering, "", "ponder",
+                "keep searching the likely next beliefs while each action is carried out"
+                " (not used in simulation)", true);
 
         parser->addOption<std::string>("ABT", "searchHeuristic", &SharedOptions::searchHeuristic);
         parser->addOption<std::string>("ABT", "searchStrategy", &SharedOptions::searchStrategy);
@@ -0,0 +1,200 @@
+/** @file bench_obsmap.hpp
+ *
+ * Contains a generic function for timing lookups in a DiscreteObservationMap against a
+ * std::unordered_map holding the same observations; this can be used to form the main method of a
+ * problem-specific "bench_obsmap" executable.
+ */
+#ifndef BENCH_OBSMAP_HPP_
+#define BENCH_OBSMAP_HPP_
+
+#include <cstddef>                      // for size_t
+#include <ctime>                        // for time
+
+#include <iomanip>                      // for setw
+#include <iostream>                     // for cout
+#include <memory>                       // for unique_ptr
+#include <random>                       // for uniform_int_distribution
+#include <string>                       // for string
+#include <unordered_map>                // for unordered_map
+#include <vector>                       // for vector
+
+#include "global.hpp"                     // for RandomGenerator, make_unique, wall_clock_ms
+#include "options/option_parser.hpp"        // for OptionParser, OptionParsingException
+#include "solver/ActionNode.hpp"            // for ActionNode
+#include "solver/BeliefNode.hpp"            // for BeliefNode
+#include "solver/BeliefTree.hpp"            // for BeliefTree
+#include "solver/Solver.hpp"                // for Solver
+#include "solver/abstract-problem/Action.hpp"            // for Action
+#include "solver/abstract-problem/Model.hpp"             // for Model::StepResult
+#include "solver/abstract-problem/Observation.hpp"       // for Observation
+#include "solver/abstract-problem/State.hpp"             // for State
+#include "solver/mappings/actions/ActionMapping.hpp"     // for ActionMapping
+#include "solver/mappings/observations/ObservationMapping.hpp"  // for ObservationMapping
+
+using std::cout;
+using std::endl;
+
+/** The number of steps that are sampled to find the distinct observations of the model. */
+long const BENCH_OBSMAP_SAMPLES = 100000;
+/** The number of lookups each benchmark run does. */
+long const BENCH_OBSMAP_LOOKUPS = 4000000;
+/** The number of times each sequence of lookups is timed. */
+long const BENCH_OBSMAP_REPEATS = 7;
+/** The numbers of entries in the mappings to time; sizes above the number of distinct
+ * observations are skipped.
+ */
+long const BENCH_OBSMAP_SIZES[] = { 1, 2, 4, 8, 16, 32, 64, 128, 256, 1024 };
+
+/** Hashes observations by calling their virtual hash() method. */
+struct BenchObsMapHash {
+    std::size_t operator()(solver::Observation const *obs) const {
+        return obs->hash();
+    }
+};
+
+/** Compares observations by calling their virtual equals() method. */
+struct BenchObsMapEqual {
+    bool operator()(solver::Observation const *o1, solver::Observation const *o2) const {
+        return o1->equals(*o2);
+    }
+};
+
+/** A template method to time DiscreteObservationMap::getEntry() for the given model and options
+ * classes; the model must use the default DiscreteObservationPool.
+ *
+ * The distinct observations are found by sampling steps from states given by
+ * sampleStateUninformed(). For each size, a belief node is then given that many observation
+ * children, and a random sequence of observations among them is looked up both in the mapping of
+ * that node and in a std::unordered_map that is keyed on the same observations, via their virtual
+ * hash() and equals() methods. This baseline doesn't copy the observation for each lookup, unlike
+ * the std::unordered_map the mapping used to be built on, which favours the baseline.
+ */
+template<typename ModelType, typename OptionsType>
+int bench_obsmap(int argc, char const *argv[]) {
+    std::unique_ptr<options::OptionParser> parser = OptionsType::makeParser(false);
+
+    OptionsType options;
+    std::string workingDir = tapir::get_current_directory();
+    try {
+        parser->setOptions(&options);
+        parser->parseCmdLine(argc, argv);
+        if (!options.baseConfigPath.empty()) {
+            tapir::change_directory(options.baseConfigPath);
+        }
+        if (!options.configPath.empty()) {
+            parser->parseCfgFile(options.configPath);
+        }
+        if (!options.baseConfigPath.empty()) {
+            tapir::change_directory(workingDir);
+        }
+        parser->finalize();
+    } catch (options::OptionParsingException const &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    RandomGenerator randGen;
+    unsigned long seed = options.seed;
+    if (seed == 0) {
+        seed = std::time(nullptr);
+    }
+    randGen.seed(seed);
+
+    if (!options.baseConfigPath.empty()) {
+        tapir::change_directory(options.baseConfigPath);
+    }
+    std::unique_ptr<ModelType> newModel = std::make_unique<ModelType>(&randGen,
+            std::make_unique<OptionsType>(options));
+    if (!options.baseConfigPath.empty()) {
+        tapir::change_directory(workingDir);
+    }
+    ModelType *model = newModel.get();
+
+    solver::Solver solver(std::move(newModel));
+    solver.initializeEmpty();
+    solver::BeliefNode *root = solver.getPolicy()->getRoot();
+    std::unique_ptr<solver::Action> action = root->getMapping()->getNextActionToTry();
+
+    // Find the distinct observations, in the order they first come up.
+    std::vector<std::unique_ptr<solver::Observation>> observations;
+    std::unordered_map<solver::Observation const *, long, BenchObsMapHash, BenchObsMapEqual> seen;
+    for (long i = 0; i < BENCH_OBSMAP_SAMPLES; i++) {
+        std::unique_ptr<solver::State> state = model->sampleStateUninformed();
+        solver::Model::StepResult result = model->generateStep(*state, *action);
+        if (seen.count(result.observation.get()) == 0) {
+            seen.emplace(result.observation.get(), observations.size());
+            observations.push_back(std::move(result.observation));
+        }
+    }
+    long nDistinct = observations.size();
+    cout << "Distinct observations: " << nDistinct << endl;
+
+    // Every lookup is a hit, using a copy of the observation that was stored.
+    std::vector<std::unique_ptr<solver::Observation>> queries;
+    for (std::unique_ptr<solver::Observation> const &obs : observations) {
+        queries.push_back(obs->copy());
+    }
+
+    cout << "Entries     Map (ms)    Baseline (ms)    Speedup" << endl;
+    for (long nEntries : BENCH_OBSMAP_SIZES) {
+        if (nEntries > nDistinct) {
+            break;
+        }
+        // Each size gets a new child of the root, so its mapping starts out empty.
+        solver::BeliefNode *node = root->createOrGetChild(*action, *observations[nEntries - 1]);
+        std::unordered_map<solver::Observation const *, long, BenchObsMapHash,
+                BenchObsMapEqual> baseline;
+        for (long i = 0; i < nEntries; i++) {
+            node->createOrGetChild(*action, *observations[i]);
+            baseline.emplace(observations[i].get(), i);
+        }
+        solver::ObservationMapping *mapping = (
+                node->getMapping()->getActionNode(*action)->getMapping());
+
+        std::vector<solver::Observation const *> sequence;
+        for (long i = 0; i < BENCH_OBSMAP_LOOKUPS; i++) {
+            sequence.push_back(queries[std::uniform_int_distribution<long>(
+                    0, nEntries - 1)(randGen)].get());
+        }
+
+        // Each lookup loop is timed several times, and the fastest time is kept.
+        double mapTime = 0;
+        double baselineTime = 0;
+        for (long repeat = 0; repeat < BENCH_OBSMAP_REPEATS; repeat++) {
+            long nFound = 0;
+            double startTime = tapir::wall_clock_ms();
+            for (solver::Observation const *obs : sequence) {
+                if (mapping->getEntry(*obs) != nullptr) {
+                    nFound++;
+                }
+            }
+            double time = tapir::wall_clock_ms() - startTime;
+            if (repeat == 0 || time < mapTime) {
+                mapTime = time;
+            }
+
+            long nBaselineFound = 0;
+            startTime = tapir::wall_clock_ms();
+            for (solver::Observation const *obs : sequence) {
+                if (baseline.find(obs) != baseline.end()) {
+                    nBaselineFound++;
+                }
+            }
+            time = tapir::wall_clock_ms() - startTime;
+            if (repeat == 0 || time < baselineTime) {
+                baselineTime = time;
+            }
+
+            if (nFound != BENCH_OBSMAP_LOOKUPS || nBaselineFound != BENCH_OBSMAP_LOOKUPS) {
+                std::cerr << "ERROR: " << nFound << " and " << nBaselineFound << " of ";
+                std::cerr << BENCH_OBSMAP_LOOKUPS << " lookups found an entry." << endl;
+                return 1;
+            }
+        }
+        cout << std::setw(7) << nEntries << std::setw(13) << mapTime;
+        cout << std::setw(17) << baselineTime << std::setw(11) << baselineTime / mapTime << endl;
+    }
+    return 0;
+}
+
+#endif /* BENCH_OBSMAP_HPP_ */
@@ -0,0 +1,223 @@
+/** @file bench_revision.hpp
+ *
+ * Contains a generic function for timing Solver::applyChanges() with serial revision against
+ * revision in parallel batches, and for checking that the batched revision is repeatable; this can
+ * be used to form the main method of a problem-specific "bench_revision" executable.
+ */
+#ifndef BENCH_REVISION_HPP_
+#define BENCH_REVISION_HPP_
+
+#include <algorithm>                    // for sort
+#include <cstddef>                      // for size_t
+#include <ctime>                        // for time
+
+#include <fstream>                      // for ifstream
+#include <functional>                   // for hash
+#include <iomanip>                      // for setw
+#include <iostream>                     // for cout
+#include <limits>                       // for numeric_limits
+#include <memory>                       // for unique_ptr
+#include <sstream>                      // for stringstream
+#include <string>                       // for string
+#include <utility>                      // for move
+#include <vector>                       // for vector
+
+#include "global.hpp"                     // for RandomGenerator, make_unique, wall_clock_ms
+#include "options/option_parser.hpp"        // for OptionParser, OptionParsingException
+#include "solver/ActionNode.hpp"            // for ActionNode
+#include "solver/BeliefNode.hpp"            // for BeliefNode
+#include "solver/BeliefTree.hpp"            // for BeliefTree
+#include "solver/Solver.hpp"                // for Solver
+#include "solver/abstract-problem/Action.hpp"            // for Action
+#include "solver/abstract-problem/ModelChange.hpp"       // for ChangeSequence
+#include "solver/abstract-problem/Observation.hpp"       // for Observation
+#include "solver/abstract-problem/State.hpp"             // for State
+#include "solver/mappings/actions/ActionMapping.hpp"     // for ActionMapping
+#include "solver/mappings/actions/ActionMappingEntry.hpp"    // for ActionMappingEntry
+#include "solver/mappings/observations/ObservationMapping.hpp"  // for ObservationMapping
+#include "solver/mappings/observations/ObservationMappingEntry.hpp"  // for ObservationMappingEntry
+#include "solver/serialization/Serializer.hpp"        // for Serializer
+
+using std::cout;
+using std::endl;
+
+/** The numbers of threads to time; one thread means serial revision. */
+long const BENCH_REVISION_THREADS[] = { 1, 2, 4, 8 };
+/** The number of times the changes are applied for each number of threads. */
+long const BENCH_REVISION_REPEATS = 3;
+
+/** Mixes the given value into the given digest. */
+inline void bench_revision_mix(std::size_t &digest, std::size_t value) {
+    digest ^= value + 0x9E3779B9 + (digest << 6) + (digest >> 2);
+}
+
+/** Returns a digest of the subtree rooted at the given belief node, covering the particles,
+ * values and visit counts of every node in it.
+ *
+ * The node IDs and the order of the children and particles aren't covered, since those depend on
+ * which thread created the nodes first.
+ */
+inline std::size_t bench_revision_digest(solver::BeliefNode const *node) {
+    std::size_t digest = 0;
+    bench_revision_mix(digest, node->getNumberOfParticles());
+    std::size_t stateSum = 0;
+    for (solver::State const *state : node->getStates()) {
+        stateSum += state->hash();
+    }
+    bench_revision_mix(digest, stateSum);
+    bench_revision_mix(digest, std::hash<double>()(node->getCachedValue()));
+
+    std::vector<std::size_t> actionDigests;
+    node->getMapping()->forEachChildEntry([&actionDigests] (
+            solver::ActionMappingEntry const *actionEntry) {
+        std::size_t actionDigest = 0;
+        bench_revision_mix(actionDigest, actionEntry->getAction()->hash());
+        bench_revision_mix(actionDigest, actionEntry->getVisitCount());
+        bench_revision_mix(actionDigest, std::hash<double>()(actionEntry->getTotalQValue()));
+
+        std::vector<std::size_t> childDigests;
+        actionEntry->getActionNode()->getMapping()->forEachChildEntry([&childDigests] (
+                solver::ObservationMappingEntry const *obsEntry) {
+            std::size_t childDigest = 0;
+            bench_revision_mix(childDigest, obsEntry->peekObservation().hash());
+            bench_revision_mix(childDigest, obsEntry->getVisitCount());
+            bench_revision_mix(childDigest, bench_revision_digest(obsEntry->getBeliefNode()));
+            childDigests.push_back(childDigest);
+        });
+        std::sort(childDigests.begin(), childDigests.end());
+        for (std::size_t childDigest : childDigests) {
+            bench_revision_mix(actionDigest, childDigest);
+        }
+        actionDigests.push_back(actionDigest);
+    });
+    std::sort(actionDigests.begin(), actionDigests.end());
+    for (std::size_t actionDigest : actionDigests) {
+        bench_revision_mix(digest, actionDigest);
+    }
+    return digest;
+}
+
+/** A template method to time Solver::applyChanges() for the given model and options classes.
+ *
+ * A policy is first generated from the root with a single thread, as for "solve", and then saved.
+ * For each number of threads, the policy is loaded into a new solver, and each step of the change
+ * sequence given by --changes is applied to it in turn, with the root as the change root; with more
+ * than one thread, tree-parallel search is switched on, so that the affected histories are revised
+ * in parallel batches. The total time spent in Solver::applyChanges() is shown; the worker models
+ * are updated beforehand, as the simulator does, so that isn't timed.
+ *
+ * Every run uses the same seed, and the batches only depend on the tree and the sequence IDs, so
+ * the batched revision must give the same tree each time with the same number of threads, however
+ * the threads are timed; a digest of the tree is shown, and the benchmark fails if the repeated
+ * runs don't agree. Serial revision isn't checked, since it goes through the affected sequences
+ * in the order of the hash set that holds them, which varies from run to run.
+ */
+template<typename ModelType, typename OptionsType>
+int bench_revision(int argc, char const *argv[]) {
+    // The changes are given in the same way as for "simulate".
+    std::unique_ptr<options::OptionParser> parser = OptionsType::makeParser(true);
+
+    OptionsType options;
+    std::string workingDir = tapir::get_current_directory();
+    try {
+        parser->setOptions(&options);
+        parser->parseCmdLine(argc, argv);
+        if (!options.baseConfigPath.empty()) {
+            tapir::change_directory(options.baseConfigPath);
+        }
+        if (!options.configPath.empty()) {
+            parser->parseCfgFile(options.configPath);
+        }
+        if (!options.baseConfigPath.empty()) {
+            tapir::change_directory(workingDir);
+        }
+        parser->finalize();
+    } catch (options::OptionParsingException const &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+    if (options.changesPath.empty()) {
+        std::cerr << "A change file must be given, e.g. --changes changes/mid-wall.txt" << endl;
+        return 2;
+    }
+
+    unsigned long seed = options.seed;
+    if (seed == 0) {
+        seed = std::time(nullptr);
+    }
+    // The revision must finish within applyChanges(), and the output would be swamped.
+    options.changeTimeout = 0;
+    options.hasVerboseOutput = false;
+
+    // The same policy is used for every run.
+    std::stringstream policy;
+    policy << std::setprecision(std::numeric_limits<double>::max_digits10);
+    {
+        RandomGenerator randGen;
+        randGen.seed(seed);
+        options.nThreads = 1;
+        if (!options.baseConfigPath.empty()) {
+            tapir::change_directory(options.baseConfigPath);
+        }
+        solver::Solver solver(std::make_unique<ModelType>(&randGen,
+                std::make_unique<OptionsType>(options)));
+        if (!options.baseConfigPath.empty()) {
+            tapir::change_directory(workingDir);
+        }
+        solver.initializeEmpty();
+        solver.improvePolicy();
+        solver.getSerializer()->save(policy);
+    }
+
+    cout << "Threads  Repeat    Time (ms)    Particles        Digest" << endl;
+    for (long nThreads : BENCH_REVISION_THREADS) {
+        std::size_t firstDigest = 0;
+        for (long repeat = 0; repeat < BENCH_REVISION_REPEATS; repeat++) {
+            RandomGenerator randGen;
+            randGen.seed(seed);
+            options.nThreads = nThreads;
+            options.useTreeParallelSearch = (nThreads > 1);
+            if (!options.baseConfigPath.empty()) {
+                tapir::change_directory(options.baseConfigPath);
+            }
+            std::unique_ptr<ModelType> newModel = std::make_unique<ModelType>(&randGen,
+                    std::make_unique<OptionsType>(options));
+            ModelType *model = newModel.get();
+            solver::Solver solver(std::move(newModel));
+            std::stringstream policyCopy(policy.str());
+            solver.getSerializer()->load(policyCopy);
+            std::ifstream changesFile(options.changesPath);
+            solver::ChangeSequence changeSequence = solver.getSerializer()->loadChangeSequence(
+                    changesFile);
+            if (!options.baseConfigPath.empty()) {
+                tapir::change_directory(workingDir);
+            }
+
+            double totalTime = 0;
+            for (auto const &step : changeSequence) {
+                solver.setChangeRoot(nullptr);
+                model->applyChanges(step.second, &solver);
+                solver.applyChangesToWorkers(step.second);
+                double startTime = tapir::wall_clock_ms();
+                solver.applyChanges();
+                totalTime += tapir::wall_clock_ms() - startTime;
+            }
+
+            std::size_t digest = bench_revision_digest(solver.getPolicy()->getRoot());
+            cout << std::setw(7) << nThreads << std::setw(8) << repeat;
+            cout << std::setw(13) << totalTime;
+            cout << std::setw(13) << solver.getPolicy()->getRoot()->getNumberOfParticles();
+            cout << std::setw(14) << std::hex << digest % 0x100000000UL << std::dec << endl;
+            if (repeat == 0) {
+                firstDigest = digest;
+            } else if (nThreads > 1 && digest != firstDigest) {
+                std::cerr << "ERROR: The tree differs between runs with " << nThreads;
+                std::cerr << " threads!" << endl;
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+#endif /* BENCH_REVISION_HPP_ */
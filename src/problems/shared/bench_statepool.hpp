@@ -0,0 +1,109 @@
+/** @file bench_statepool.hpp
+ *
+ * Contains a generic function for measuring how well StatePool::createOrGetInfo() scales with the
+ * number of threads; this can be used to form the main method of a problem-specific
+ * "bench_statepool" executable.
+ */
+#ifndef BENCH_STATEPOOL_HPP_
+#define BENCH_STATEPOOL_HPP_
+
+#include <ctime>                        // for time
+
+#include <iomanip>                      // for setw
+#include <iostream>                     // for cout
+#include <memory>                       // for unique_ptr
+#include <string>                       // for string
+#include <thread>                       // for thread
+#include <utility>                      // for move
+#include <vector>                       // for vector
+
+#include "global.hpp"                     // for RandomGenerator, make_unique, wall_clock_ms
+#include "options/option_parser.hpp"        // for OptionParser, OptionParsingException
+#include "solver/StatePool.hpp"            // for StatePool
+#include "solver/abstract-problem/State.hpp"             // for State
+
+using std::cout;
+using std::endl;
+
+/** The number of states each benchmark run looks up. */
+long const BENCH_STATEPOOL_LOOKUPS = 400000;
+/** The numbers of threads to time. */
+long const BENCH_STATEPOOL_THREADS[] = { 1, 2, 4, 8, 16, 32 };
+
+/** A template method to time StatePool::createOrGetInfo() for the given model and options classes.
+ *
+ * A fixed sequence of states is sampled from the model via sampleStateUninformed(), and then
+ * split evenly between 1, 2, 4, ..., 32 threads that all look up their states in the same empty
+ * pool; the first lookup of each state adds it to the pool, and the rest find it.
+ */
+template<typename ModelType, typename OptionsType>
+int bench_statepool(int argc, char const *argv[]) {
+    std::unique_ptr<options::OptionParser> parser = OptionsType::makeParser(false);
+
+    OptionsType options;
+    std::string workingDir = tapir::get_current_directory();
+    try {
+        parser->setOptions(&options);
+        parser->parseCmdLine(argc, argv);
+        if (!options.baseConfigPath.empty()) {
+            tapir::change_directory(options.baseConfigPath);
+        }
+        if (!options.configPath.empty()) {
+            parser->parseCfgFile(options.configPath);
+        }
+        if (!options.baseConfigPath.empty()) {
+            tapir::change_directory(workingDir);
+        }
+        parser->finalize();
+    } catch (options::OptionParsingException const &e) {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+
+    RandomGenerator randGen;
+    unsigned long seed = options.seed;
+    if (seed == 0) {
+        seed = std::time(nullptr);
+    }
+    randGen.seed(seed);
+
+    if (!options.baseConfigPath.empty()) {
+        tapir::change_directory(options.baseConfigPath);
+    }
+    std::unique_ptr<ModelType> model = std::make_unique<ModelType>(&randGen,
+            std::make_unique<OptionsType>(options));
+    if (!options.baseConfigPath.empty()) {
+        tapir::change_directory(workingDir);
+    }
+
+    std::vector<std::unique_ptr<solver::State>> states;
+    for (long i = 0; i < BENCH_STATEPOOL_LOOKUPS; i++) {
+        states.push_back(model->sampleStateUninformed());
+    }
+
+    cout << "Threads    Time (ms)    Lookups/ms    States" << endl;
+    for (long nThreads : BENCH_STATEPOOL_THREADS) {
+        solver::StatePool pool(nullptr);
+        std::vector<std::thread> threads;
+        double startTime = tapir::wall_clock_ms();
+        for (long t = 0; t < nThreads; t++) {
+            long begin = BENCH_STATEPOOL_LOOKUPS * t / nThreads;
+            long end = BENCH_STATEPOOL_LOOKUPS * (t + 1) / nThreads;
+            threads.emplace_back([&pool, &states, begin, end]() {
+                for (long i = begin; i < end; i++) {
+                    pool.createOrGetInfo(*states[i]);
+                }
+            });
+        }
+        for (std::thread &thread : threads) {
+            thread.join();
+        }
+        double totalTime = tapir::wall_clock_ms() - startTime;
+        cout << std::setw(7) << nThreads << std::setw(13) << totalTime;
+        cout << std::setw(14) << BENCH_STATEPOOL_LOOKUPS / totalTime;
+        cout << std::setw(10) << pool.getNumberOfStates() << endl;
+    }
+    return 0;
+}
+
+#endif /* BENCH_STATEPOOL_HPP_ */
@@ -72,7 +72,12 @@ std::unique_ptr<solver::StepGeneratorFactory> UcbParser::parse(solver::Solver *s
         std::vector<std::string> args) {
     double explorationCoefficient;
     std::istringstream(args[1]) >> explorationCoefficient;
-    return std::make_unique<solver::UcbStepGeneratorFactory>(solver, explorationCoefficient);
+    double virtualLoss = 0;
+    if (args.size() > 2) {
+        std::istringstream(args[2]) >> virtualLoss;
+    }
+    return std::make_unique<solver::UcbStepGeneratorFactory>(solver, explorationCoefficient,
+            virtualLoss);
 }
 
 std::unique_ptr<solver::StepGeneratorFactory> GpsParser::parse(solver::Solver *solver, std::vector<std::string> args) {
@@ -119,7 +124,11 @@ std::unique_ptr<solver::StepGeneratorFactory> DefaultRolloutParser::parse(solver
         std::vector<std::string> args) {
     long maxNSteps;
     std::istringstream(args[1]) >> maxNSteps;
-    return std::make_unique<solver::DefaultRolloutFactory>(solver, maxNSteps);
+    long nRollouts = 1;
+    if (args.size() > 2) {
+        std::istringstream(args[2]) >> nRollouts;
+    }
+    return std::make_unique<solver::DefaultRolloutFactory>(solver, maxNSteps, nRollouts);
 }
 
 StagedParser::StagedParser(ParserSet<std::unique_ptr<solver::StepGeneratorFactory>> *allParsers) :
@@ -148,7 +148,9 @@ private:
     std::unique_ptr<Parser<TargetType>> defaultParser_;
 };
 
-/** A parser for UcbStepGeneratorFactory instances. */
+/** A parser for UcbStepGeneratorFactory instances, of the form
+ * "ucb(explorationCoefficient)" or "ucb(explorationCoefficient, virtualLoss)".
+ */
 class UcbParser: public Parser<std::unique_ptr<solver::StepGeneratorFactory>> {
 public:
     UcbParser() = default;
@@ -175,7 +177,10 @@ public:
             std::vector<std::string> args) override;
 };
 
-/** A parser for DefaultRolloutFactory instances. */
+/** A parser for DefaultRolloutFactory instances, of the form "rollout(maxNSteps)" or
+ * "rollout(maxNSteps, nRollouts)"; the latter runs nRollouts rollouts from each new leaf, in
+ * parallel if nThreads is greater than one, and uses their mean return as its value.
+ */
 class DefaultRolloutParser: public Parser<std::unique_ptr<solver::StepGeneratorFactory>> {
 public:
     DefaultRolloutParser() = default;
@@ -131,6 +131,9 @@ protected:
 			return;
 		}
 
+		// The action is over, so we stop searching in the background.
+		agent_->stopPondering();
+
 		std::stringstream prevStream;
 		solver::BeliefNode *currentBelief = agent_->getCurrentBelief();
 
@@ -206,6 +209,10 @@ protected:
 			}
 			lastAction_.reset(static_cast<Action *>(sa.release()));
 			applyAction(*lastAction_);
+			if (options_.usePondering) {
+				// Keep searching while the action is carried out.
+				agent_->startPondering(*lastAction_);
+			}
 		}
 	}
 
@@ -214,6 +221,7 @@ protected:
 			std::vector<std::unique_ptr<solver::ModelChange>> const &changes,
 			bool resetTree) {
 
+		agent_->stopPondering();
 		bool hasDynamicChanges = options_.areDynamic;
 		if (internalSimulation_) {
 			simulator_->handleChanges(changes, hasDynamicChanges, resetTree);
@@ -79,6 +79,7 @@ int simulate(int argc, char const *argv[]) {
 
     double totalReward = 0;
     double totalTime = 0;
+    double totalWallTime = 0;
     double totalNSteps = 0;
 
 #ifdef GOOGLE_PROFILER
@@ -139,12 +140,15 @@ int simulate(int argc, char const *argv[]) {
         cout << "Running..." << endl;
 
         double tStart = tapir::clock_ms();
+        double wallStart = tapir::wall_clock_ms();
         double reward = simulator.runSimulation();
         double totT = tapir::clock_ms() - tStart;
+        double totWallT = tapir::wall_clock_ms() - wallStart;
         long actualNSteps = simulator.getStepCount();
 
         totalReward += reward;
         totalTime += totT;
+        totalWallTime += totWallT;
         totalNSteps += actualNSteps;
 
         os << "Run #" << runNumber+1 << endl;
@@ -167,17 +171,23 @@ int simulate(int argc, char const *argv[]) {
         cout << "Total discounted reward: " << reward << endl;
         cout << "# of steps: " << actualNSteps << endl;
         cout << "Time spent on changes: ";
-        cout << simulator.getTotalChangingTime() << "ms" << endl;
+        cout << simulator.getTotalChangingTime() << "ms CPU, ";
+        cout << simulator.getTotalChangingWallTime() << "ms wall" << endl;
         cout << "Time spent on policy updates: ";
-        cout << simulator.getTotalImprovementTime() << "ms" << endl;
+        cout << simulator.getTotalImprovementTime() << "ms CPU, ";
+        cout << simulator.getTotalImprovementWallTime() << "ms wall" << endl;
         cout << "Time spent replenishing particles: ";
-        cout << simulator.getTotalReplenishingTime() << "ms" << endl;
+        cout << simulator.getTotalReplenishingTime() << "ms CPU, ";
+        cout << simulator.getTotalReplenishingWallTime() << "ms wall" << endl;
         cout << "Time spent pruning: ";
-        cout << simulator.getTotalPruningTime() << "ms" << endl;
-        cout << "Total time taken: " << totT << "ms" << endl;
+        cout << simulator.getTotalPruningTime() << "ms CPU, ";
+        cout << simulator.getTotalPruningWallTime() << "ms wall" << endl;
+        cout << "Total time taken: " << totT << "ms CPU, " << totWallT << "ms wall" << endl;
         if (options.savePolicy) {
             // Write the final policy to a file.
             cout << "Saving final policy..." << endl;
+            // The file doesn't record which histories are stale, so they are all revised first.
+            solver.reviseStaleHistories();
             std::ofstream outFile;
             std::ostringstream sstr;
             sstr << "final-" << runNumber << ".pol";
@@ -198,8 +208,10 @@ int simulate(int argc, char const *argv[]) {
     cout << options.nRuns << " runs completed." << endl;
     cout << "Mean reward: " << totalReward / options.nRuns << endl;
     cout << "Mean number of steps: " << totalNSteps / options.nRuns << endl;
-    cout << "Mean time taken: " << totalTime / options.nRuns << "ms" << endl;
-    cout << "Mean time per step: " << totalTime / totalNSteps << "ms" << endl;
+    cout << "Mean time taken: " << totalTime / options.nRuns << "ms CPU, ";
+    cout << totalWallTime / options.nRuns << "ms wall" << endl;
+    cout << "Mean time per step: " << totalTime / totalNSteps << "ms CPU, ";
+    cout << totalWallTime / totalNSteps << "ms wall" << endl;
     return 0;
 }
 
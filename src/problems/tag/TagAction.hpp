@@ -13,6 +13,7 @@
 
 #include "solver/abstract-problem/Action.hpp"
 #include "solver/abstract-problem/DiscretizedPoint.hpp"             // for DiscretizedPoint
+#include "solver/abstract-problem/Recyclable.hpp"
 
 namespace tag {
 
@@ -36,7 +37,8 @@ enum class ActionType : long {
  * enumerated action mapping approach (EnumeratedActionPool) to store the available actions from
  * each belief node.
  */
-class TagAction : public solver::DiscretizedPoint {
+class TagAction : public solver::DiscretizedPoint,
+        public solver::Recyclable<TagAction> {
     friend class TagTextSerializer;
   public:
     /** Constructs a new action from the given ActionType. */
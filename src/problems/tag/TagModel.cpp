@@ -12,6 +12,7 @@
 #include <fstream>                      // for ifstream, basic_istream, basic_istream<>::__istream_type
 #include <iomanip>                      // for operator<<, setw
 #include <iostream>                     // for cout
+#include <queue>                        // for queue
 #include <random>                       // for uniform_int_distribution, bernoulli_distribution
 #include <unordered_map>                // for _Node_iterator, operator!=, unordered_map<>::iterator, _Node_iterator_base, unordered_map
 #include <utility>                      // for make_pair, move, pair
@@ -28,7 +29,7 @@
 #include "solver/changes/ChangeFlags.hpp"        // for ChangeFlags
 
 #include "solver/indexing/FlaggingVisitor.hpp"
-#include "solver/indexing/RTree.hpp"
+#include "solver/indexing/PackedRTree.hpp"
 #include "solver/indexing/SpatialIndexVisitor.hpp"             // for State, operator<<, operator==
 
 #include "solver/mappings/actions/enumerated_actions.hpp"
@@ -411,6 +412,19 @@ void TagModel::applyChanges(std::vector<std::unique_ptr<solver::ModelChange>> co
         }
     }
 
+    // The states affected by all of the changes are flagged together, in a single query.
+    solver::PackedRTree *tree = nullptr;
+    if (pool != nullptr) {
+        tree = static_cast<solver::PackedRTree *>(pool->getStateIndex());
+        if (tree == nullptr) {
+            debug::show_message("ERROR: state index must be enabled to handle changes in Tag!");
+            std::exit(4);
+        }
+    }
+    solver::FlaggingVisitor deletedVisitor(pool, solver::ChangeFlags::DELETED);
+    solver::FlaggingVisitor transitionVisitor(pool, solver::ChangeFlags::TRANSITION);
+    std::vector<solver::PackedRTree::QueryBox> boxes;
+
     for (auto const &change : changes) {
         TagChange const &tagChange = static_cast<TagChange const &>(*change);
         if (options_->hasVerboseOutput) {
@@ -439,12 +453,6 @@ void TagModel::applyChanges(std::vector<std::unique_ptr<solver::ModelChange>> co
             continue;
         }
 
-        solver::RTree *tree = static_cast<solver::RTree *>(pool->getStateIndex());
-        if (tree == nullptr) {
-            debug::show_message("ERROR: state index must be enabled to handle changes in Tag!");
-            std::exit(4);
-        }
-
         double iLo = tagChange.i0;
         double iHi = tagChange.i1;
         double iMx = nRows_ - 1.0;
@@ -456,26 +464,23 @@ void TagModel::applyChanges(std::vector<std::unique_ptr<solver::ModelChange>> co
         // Adding walls => any states where the robot or the opponent are in a wall must
         // be deleted.
         if (newCellType == TagCellType::WALL) {
-            solver::FlaggingVisitor visitor(pool, solver::ChangeFlags::DELETED);
             // Robot is in a wall.
-            tree->boxQuery(visitor,
-                    {iLo, jLo, 0.0, 0.0, 0.0},
-                    {iHi, jHi, iMx, jMx, 1.0});
+            boxes.push_back({{iLo, jLo, 0.0, 0.0, 0.0}, {iHi, jHi, iMx, jMx, 1.0},
+                    &deletedVisitor});
             // Opponent is in a wall.
-            tree->boxQuery(visitor,
-                    {0.0, 0.0, iLo, jLo, 0.0},
-                    {iMx, jMx, iHi, jHi, 1.0});
-
+            boxes.push_back({{0.0, 0.0, iLo, jLo, 0.0}, {iMx, jMx, iHi, jHi, 1.0},
+                    &deletedVisitor});
         }
 
         // Also, state transitions around the edges of the new / former obstacle must be revised.
-        solver::FlaggingVisitor visitor(pool, solver::ChangeFlags::TRANSITION);
-        tree->boxQuery(visitor,
-                {iLo - 1, jLo - 1, 0.0, 0.0, 0.0},
-                {iHi + 1, jHi + 1, iMx, jMx, 1.0});
-        tree->boxQuery(visitor,
-                {0.0, 0.0, iLo - 1, jLo - 1, 0.0},
-                {iMx, jMx, iHi + 1, jHi + 1, 1.0});
+        boxes.push_back({{iLo - 1, jLo - 1, 0.0, 0.0, 0.0}, {iHi + 1, jHi + 1, iMx, jMx, 1.0},
+                &transitionVisitor});
+        boxes.push_back({{0.0, 0.0, iLo - 1, jLo - 1, 0.0}, {iMx, jMx, iHi + 1, jHi + 1, 1.0},
+                &transitionVisitor});
+    }
+
+    if (tree != nullptr) {
+        tree->boxQueries(boxes);
     }
 
     if (mdpSolver_ != nullptr) {
@@ -739,4 +744,13 @@ std::unique_ptr<solver::ActionPool> TagModel::createActionPool(solver::Solver */
 std::unique_ptr<solver::Serializer> TagModel::createSerializer(solver::Solver *solver) {
     return std::make_unique<TagTextSerializer>(solver);
 }
+std::unique_ptr<solver::Model> TagModel::createWorkerModel(RandomGenerator *randGen) {
+    std::unique_ptr<TagOptions> options = std::make_unique<TagOptions>(*options_);
+    options->hasVerboseOutput = false;
+    std::unique_ptr<TagModel> model = std::make_unique<TagModel>(randGen, std::move(options));
+    // The map may have changed since it was read from the file.
+    model->envMap_ = envMap_;
+    model->calculatePairwiseDistances();
+    return std::move(model);
+}
 } /* namespace tag */
@@ -252,6 +252,8 @@ class TagModel: public shared::ModelWithProgramOptions {
 
     virtual std::unique_ptr<solver::Serializer> createSerializer(solver::Solver *solver) override;
 
+    virtual std::unique_ptr<solver::Model> createWorkerModel(RandomGenerator *randGen) override;
+
   private:
     /** Calculates the distances from the given position to all other parts of the map. */
     void calculateDistancesFrom(GridPosition position);
@@ -15,6 +15,7 @@
 #include "problems/shared/GridPosition.hpp"
 #include "solver/abstract-problem/DiscretizedPoint.hpp"
 #include "solver/abstract-problem/Observation.hpp"
+#include "solver/abstract-problem/Recyclable.hpp"
 
 namespace tag {
 class TagModel;
@@ -24,7 +25,8 @@ class TagModel;
  * This includes an observation of the robot's own position, and a boolean flag representing
  * whether or not the robot sees the opponent (and hence is on the same grid square).
  */
-class TagObservation : public solver::Point {
+class TagObservation : public solver::Point,
+        public solver::Recyclable<TagObservation> {
     friend class TagTextSerializer;
   public:
     /** Constructs a new TagObservation for the given robot position; seesOpponent should be true
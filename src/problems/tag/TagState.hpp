@@ -14,6 +14,7 @@
 #include "problems/shared/GridPosition.hpp"  // for GridPosition
 #include "solver/abstract-problem/State.hpp"
 #include "solver/abstract-problem/VectorState.hpp"
+#include "solver/abstract-problem/Recyclable.hpp"
 
 namespace tag {
 /** A class representing a state in the Tag POMDP.
@@ -25,7 +26,8 @@ namespace tag {
  * converted to a vector<double>, which can then be used inside the standard R*-tree implementation
  * of StateIndex to allow spatial lookup of states.
  */
-class TagState : public solver::VectorState {
+class TagState : public solver::VectorState,
+        public solver::Recyclable<TagState> {
     friend class TagTextSerializer;
   public:
     /** Constructs a new TagState with the given positions of the robot and opponent, and the
@@ -0,0 +1,14 @@
+/** @file tag/bench_obsmap.cpp
+ *
+ * Defines the main method for the "bench_obsmap" executable for the Tag POMDP, which times
+ * lookups in the observation mappings of the belief tree.
+ */
+#include "problems/shared/bench_obsmap.hpp"
+
+#include "TagModel.hpp"                 // for TagModel
+#include "TagOptions.hpp"               // for TagOptions
+
+/** The main method for the "bench_obsmap" executable for Tag. */
+int main(int argc, char const *argv[]) {
+    return bench_obsmap<tag::TagModel, tag::TagOptions>(argc, argv);
+}
@@ -0,0 +1,14 @@
+/** @file tag/bench_revision.cpp
+ *
+ * Defines the main method for the "bench_revision" executable for the Tag POMDP, which times the
+ * revision of histories after changes, e.g. those in changes/mid-wall.txt.
+ */
+#include "problems/shared/bench_revision.hpp"
+
+#include "TagModel.hpp"                 // for TagModel
+#include "TagOptions.hpp"               // for TagOptions
+
+/** The main method for the "bench_revision" executable for Tag. */
+int main(int argc, char const *argv[]) {
+    return bench_revision<tag::TagModel, tag::TagOptions>(argc, argv);
+}
@@ -0,0 +1,14 @@
+/** @file tag/bench_statepool.cpp
+ *
+ * Defines the main method for the "bench_statepool" executable for the Tag POMDP, which times
+ * concurrent lookups in a StatePool.
+ */
+#include "problems/shared/bench_statepool.hpp"
+
+#include "TagModel.hpp"                 // for TagModel
+#include "TagOptions.hpp"               // for TagOptions
+
+/** The main method for the "bench_statepool" executable for Tag. */
+int main(int argc, char const *argv[]) {
+    return bench_statepool<tag::TagModel, tag::TagOptions>(argc, argv);
+}
@@ -24,12 +24,14 @@
 namespace solver {
 ActionNode::ActionNode() :
         parentEntry_(nullptr),
-        observationMap_(nullptr) {
+        observationMap_(nullptr),
+        virtualLossCount_(0) {
 }
 
 ActionNode::ActionNode(ActionMappingEntry *parentEntry) :
         parentEntry_(parentEntry),
-        observationMap_(nullptr) {
+        observationMap_(nullptr),
+        virtualLossCount_(0) {
 }
 
 // Default destructor
@@ -49,6 +51,9 @@ BeliefNode *ActionNode::getParentBelief() const {
 BeliefNode *ActionNode::getChild(Observation const &obs) const {
     return observationMap_->getBelief(obs);
 }
+long ActionNode::getVirtualLossCount() const {
+    return virtualLossCount_;
+}
 
 
 /* ============================ PRIVATE ============================ */
@@ -12,6 +12,8 @@
 
 #include "global.hpp"
 
+#include "solver/SlabAllocator.hpp"
+
 #include "solver/abstract-problem/Action.hpp"                   // for Action
 #include "solver/abstract-problem/Observation.hpp"              // for Observation
 
@@ -29,11 +31,12 @@ class Solver;
  * For purposes of customizability most of the work is done in the ActionMapping and
  * ObservationMapping interfaces, which allow for custom approaches to implementing those mappings.
  *
- * This class contains only two fields; a back-pointer to the ActionMappingEntry that owns this
- * action node (and stores relevant statistics), and an ObservationMapping, which is owned by
- * this ActionNode, and stores information about the observations branching out of this node.
+ * This class contains only three fields; a back-pointer to the ActionMappingEntry that owns this
+ * action node (and stores relevant statistics), an ObservationMapping, which is owned by
+ * this ActionNode, and stores information about the observations branching out of this node,
+ * and a count of virtual losses used by tree-parallel search.
  */
-class ActionNode {
+class ActionNode : public SlabAllocated {
     friend class BeliefNode;
     friend class TextSerializer;
 
@@ -59,6 +62,10 @@ class ActionNode {
      * sufficient proximity.
      */
     BeliefNode *getChild(Observation const &obs) const;
+    /** Returns the number of histories currently being searched through this node by other
+     * threads; these count as virtual losses when choosing actions.
+     */
+    long getVirtualLossCount() const;
 
   private:
     /* -------------------- Tree-related setters  ---------------------- */
@@ -79,6 +86,8 @@ class ActionNode {
      * entries, statistics, and subtrees.
      */
     std::unique_ptr<ObservationMapping> observationMap_;
+    /** The number of virtual losses; guarded by the mutex of the parent belief. */
+    long virtualLossCount_;
 };
 } /* namespace solver */
 
@@ -4,15 +4,37 @@
  */
 #include "solver/Agent.hpp"
 
+#include <algorithm>
+#include <random>
+#include <vector>
+
+#include "solver/ActionNode.hpp"
 #include "solver/BeliefNode.hpp"
 #include "solver/BeliefTree.hpp"
 #include "solver/Solver.hpp"
 
+#include "solver/abstract-problem/Model.hpp"
+
+#include "solver/mappings/actions/ActionMapping.hpp"
+#include "solver/mappings/observations/ObservationMapping.hpp"
+
 namespace solver {
+namespace {
+/** The length of each search made while pondering, in milliseconds; a new child belief is chosen
+ * for each one.
+ */
+double const PONDERING_SLICE_TIME = 10.0;
+} /* namespace */
 
 Agent::Agent(Solver *solver) :
         solver_(solver),
-        currentBelief_(solver_->getPolicy()->getRoot()) {
+        currentBelief_(solver_->getPolicy()->getRoot()),
+        ponderingThread_(),
+        ponderingStopToken_() {
+}
+
+Agent::~Agent() {
+    stopPondering();
 }
 
 Solver *Agent::getSolver() const {
@@ -26,9 +48,59 @@ BeliefNode *Agent::getCurrentBelief() const {
 }
 
 void Agent::setCurrentBelief(BeliefNode *belief) {
+    stopPondering();
     currentBelief_ = belief;
 }
 void Agent::updateBelief(Action const &action, Observation const &observation) {
+    stopPondering();
     currentBelief_ = currentBelief_->createOrGetChild(action, observation);
 }
+
+void Agent::startPondering(Action const &action) {
+    stopPondering();
+    ActionNode *actionNode = currentBelief_->getMapping()->getActionNode(action);
+    if (actionNode == nullptr) {
+        return;
+    }
+
+    // Weight each child belief by the visit count of its observation; beliefs with no
+    // non-terminal particles can't be searched from.
+    Model *model = solver_->getModel();
+    std::vector<BeliefNode *> beliefs;
+    std::vector<double> weights;
+    actionNode->getMapping()->forEachChildEntry([&] (ObservationMappingEntry const *entry) {
+        BeliefNode *belief = entry->getBeliefNode();
+        std::vector<State const *> states = belief->getStates();
+        if (entry->getVisitCount() > 0 && std::any_of(states.begin(), states.end(),
+                [model] (State const *state) { return !model->isTerminal(*state); })) {
+            beliefs.push_back(belief);
+            weights.push_back(entry->getVisitCount());
+        }
+    });
+    if (beliefs.empty()) {
+        return;
+    }
+
+    RandomGenerator randGen((*model->getRandomGenerator())());
+    ponderingStopToken_.reset();
+    ponderingThread_ = std::thread([this, beliefs, weights, randGen] () mutable {
+        std::discrete_distribution<long> distribution(weights.begin(), weights.end());
+        while (!ponderingStopToken_.isStopRequested()) {
+            solver_->searchFrom(beliefs[distribution(randGen)], 0, -1, PONDERING_SLICE_TIME,
+                    &ponderingStopToken_);
+        }
+    });
+}
+
+void Agent::stopPondering() {
+    if (!ponderingThread_.joinable()) {
+        return;
+    }
+    ponderingStopToken_.requestStop();
+    ponderingThread_.join();
+}
+
+bool Agent::isPondering() const {
+    return ponderingThread_.joinable();
+}
 } /* namespace solver */
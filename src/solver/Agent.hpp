@@ -9,6 +9,7 @@
 #define SOLVER_AGENT_HPP_
 
 #include <memory>
+#include <thread>
 
 #include "global.hpp"
 
@@ -28,13 +29,18 @@ class Solver;
  *
  * Note that multiple agents can use the same solver, as the belief tree representation
  * is not tied to the state of a specific agent.
+ *
+ * While an action is being carried out the agent can also "ponder", i.e. keep improving the policy
+ * in a background thread for the beliefs it is likely to end up in next. This is only worthwhile
+ * when there is real actuation latency to fill, as the solver can't be used for anything else in
+ * the meantime.
  */
 class Agent {
 public:
     /** Constructs a new agent associated with the given solver. The initial belief will start
      * at the root node of the solver. */
     Agent(Solver *solver);
-    ~Agent() = default;
+    ~Agent();
     _NO_COPY_OR_MOVE(Agent);
 
     /** Returns the solver being used by this agent. */
@@ -44,16 +50,35 @@ public:
     /** Returns the current belief of the agent (as a BeliefNode within the solver's belief tree). */
     BeliefNode *getCurrentBelief() const;
 
-    /** Sets the current belief of this agent to the given BeliefNode. */
+    /** Sets the current belief of this agent to the given BeliefNode; this stops pondering. */
     void setCurrentBelief(BeliefNode *belief);
-    /** Updates the belief of this agent based on an action and observation. */
+    /** Updates the belief of this agent based on an action and observation; this stops pondering,
+     * and any search already done under the new belief is kept.
+     */
     void updateBelief(Action const &action, Observation const &observation);
 
+    /** Starts improving the policy in a background thread, searching from the children of the
+     * current belief that follow the given action. Each child is chosen with probability
+     * proportional to the visit count of its observation.
+     *
+     * Nothing else may use the solver until pondering is stopped, either via stopPondering() or
+     * by updating the belief.
+     */
+    void startPondering(Action const &action);
+    /** Stops pondering, and waits for the background search to finish. */
+    void stopPondering();
+    /** Returns true iff the agent is currently pondering. */
+    bool isPondering() const;
+
 private:
     /** The solver used by this agent. */
     Solver *solver_;
     /** The belief node in the tree that represents this agent's current belief. */
     BeliefNode *currentBelief_;
+    /** The thread used for pondering, if any. */
+    std::thread ponderingThread_;
+    /** Used to tell the pondering thread to stop. */
+    tapir::StopToken ponderingStopToken_;
 };
 
 } /* namespace solver */
@@ -4,12 +4,15 @@
  */
 #include "solver/BeliefNode.hpp"
 
+#include <algorithm>                    // for max, sort
+#include <cmath>                        // for sqrt
 #include <map>                          // for _Rb_tree_iterator, map<>::iterator, map
 #include <memory>                       // for unique_ptr
 #include <random>                       // for uniform_int_distribution
 #include <set>
 #include <tuple>                        // for tie, tuple
 #include <utility>                      // for pair, make_pair, move
+#include <vector>                       // for vector
 
 #include "global.hpp"                     // for RandomGenerator, make_unique
 #include "RandomAccessSet.hpp"
@@ -20,11 +23,13 @@
 #include "solver/BeliefTree.hpp"
 #include "solver/HistoryEntry.hpp"             // for HistoryEntry
 #include "solver/Solver.hpp"                   // for Solver
+#include "solver/StateInfo.hpp"                // for StateInfo
 
 #include "solver/abstract-problem/Action.hpp"                   // for Action
 #include "solver/abstract-problem/HistoricalData.hpp"
 #include "solver/abstract-problem/Observation.hpp"              // for Observation
 #include "solver/abstract-problem/State.hpp"                    // for State
+#include "solver/abstract-problem/VectorState.hpp"              // for VectorState
 
 #include "solver/belief-estimators/estimators.hpp"
 
@@ -37,6 +42,64 @@
 #include "solver/mappings/observations/ObservationPool.hpp"
 
 namespace solver {
+namespace {
+/** The number of pairs sampled between checks of the error of a sampled belief distance. */
+long const SAMPLED_PAIRS_PER_CHECK = 32;
+
+/** Packs the state vectors of the given particles into one sorted column per dimension; returns
+ * false if there are no particles, or if any of the states isn't a Vector of the same size.
+ */
+bool get_sorted_columns(tapir::RandomAccessSet<HistoryEntry *> const &particles,
+        std::vector<std::vector<double>> &columns) {
+    for (HistoryEntry *entry : particles) {
+        VectorState const *vectorState = dynamic_cast<VectorState const *>(entry->getState());
+        if (vectorState == nullptr) {
+            return false;
+        }
+        std::vector<double> stateVector = vectorState->asVector();
+        if (columns.empty()) {
+            columns.resize(stateVector.size());
+            for (std::vector<double> &column : columns) {
+                column.reserve(particles.size());
+            }
+        } else if (stateVector.size() != columns.size()) {
+            return false;
+        }
+        for (std::size_t i = 0; i < stateVector.size(); i++) {
+            columns[i].push_back(stateVector[i]);
+        }
+    }
+    for (std::vector<double> &column : columns) {
+        std::sort(column.begin(), column.end());
+    }
+    return particles.size() > 0;
+}
+
+/** Returns the average of |x - y| over all pairs of values x and y from the two given sorted
+ * columns, in linear time.
+ */
+double mean_absolute_difference(std::vector<double> const &column1,
+        std::vector<double> const &column2) {
+    double total2 = 0;
+    for (double y : column2) {
+        total2 += y;
+    }
+    // Each x is compared to the values below it and above it in the other column using
+    // running counts and sums of those values.
+    double totalDifference = 0;
+    double sumBelow = 0;
+    std::size_t nBelow = 0;
+    for (double x : column1) {
+        for (; nBelow < column2.size() && column2[nBelow] < x; nBelow++) {
+            sumBelow += column2[nBelow];
+        }
+        std::size_t nAbove = column2.size() - nBelow;
+        totalDifference += (x * nBelow - sumBelow) + ((total2 - sumBelow) - x * nAbove);
+    }
+    return totalDifference / (column1.size() * column2.size());
+}
+} /* namespace */
+
 BeliefNode::BeliefNode(Solver *solver) :
             BeliefNode(-1, nullptr, solver) {
 }
@@ -49,12 +112,19 @@ BeliefNode::BeliefNode(long id, ObservationMappingEntry *parentEntry, Solver *so
             id_(id),
             depth_(-1),
             parentEntry_(parentEntry),
+            tourStart_(),
+            tourEnd_(),
             data_(nullptr),
             particles_(),
             nStartingSequences_(0),
+            stateVectorSums_(nullptr),
+            isQueuedForBackup_(false),
+            unpropagatedTotalQ_(0),
+            nVirtualLosses_(0),
             actionMap_(nullptr),
             cachedValues_(),
-            valueEstimator_(nullptr) {
+            valueEstimator_(nullptr),
+            mutex_() {
 
     // Correctly calculate the depth based on the parent node.
     if (parentEntry_ == nullptr) {
@@ -67,9 +137,11 @@ BeliefNode::BeliefNode(long id, ObservationMappingEntry *parentEntry, Solver *so
     solver_->getPolicy()->addNode(this);
 }
 
-// The destructor must remove the node from the solver's index.
+// The destructor must remove the node from the solver's index, unless that's already been done.
 BeliefNode::~BeliefNode() {
-    solver_->getPolicy()->removeNode(this);
+    if (id_ >= 0) {
+        solver_->getPolicy()->removeNode(this);
+    }
 }
 
 /* ----------------- Useful calculations ------------------- */
@@ -89,6 +161,75 @@ double BeliefNode::distL1Independent(BeliefNode *b) const {
     return averageDist;
 }
 
+double BeliefNode::distL1Sampled(BeliefNode *b, double tolerance, long maxPairs,
+        RandomGenerator &randGen) const {
+    long nParticles = getNumberOfParticles();
+    long nOtherParticles = b->getNumberOfParticles();
+    if (nParticles * nOtherParticles <= maxPairs) {
+        return distL1Independent(b);
+    }
+
+    std::uniform_int_distribution<long> indexDistribution(0, nParticles - 1);
+    std::uniform_int_distribution<long> otherIndexDistribution(0, nOtherParticles - 1);
+    // Welford's method gives the mean and variance of the sampled distances in one pass.
+    double mean = 0;
+    double sumOfSquaredDeviations = 0;
+    long nPairs = 0;
+    while (nPairs < maxPairs) {
+        State const *state = particles_.get(indexDistribution(randGen))->getState();
+        State const *otherState = b->particles_.get(otherIndexDistribution(randGen))->getState();
+        double distance = state->distanceTo(*otherState);
+        nPairs++;
+        double deviation = distance - mean;
+        mean += deviation / nPairs;
+        sumOfSquaredDeviations += deviation * (distance - mean);
+
+        // The standard error is sqrt(variance / nPairs), with variance estimated from the sample.
+        if (nPairs % SAMPLED_PAIRS_PER_CHECK == 0
+                && sumOfSquaredDeviations / (nPairs - 1) <= tolerance * tolerance * nPairs) {
+            break;
+        }
+    }
+    return mean;
+}
+
+double BeliefNode::distL1StateVectors(BeliefNode *b) const {
+    std::vector<std::vector<double>> columns;
+    std::vector<std::vector<double>> otherColumns;
+    if (!get_sorted_columns(particles_, columns) || !get_sorted_columns(b->particles_, otherColumns)
+            || columns.size() != otherColumns.size()) {
+        return -1;
+    }
+    double distance = 0;
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        distance += mean_absolute_difference(columns[i], otherColumns[i]);
+    }
+    return distance;
+}
+
+double BeliefNode::getStateVectorMoments(std::vector<double> &mean) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stateVectorSums_ == nullptr) {
+        stateVectorSums_ = std::make_unique<StateVectorSums>();
+        for (HistoryEntry *entry : particles_) {
+            addStateVector(entry->getStateInfo(), 1);
+        }
+    }
+    StateVectorSums const &sums = *stateVectorSums_;
+    if (sums.count <= 0) {
+        return -1;
+    }
+    mean.resize(sums.sum.size());
+    double meanSquaredNorm = 0;
+    for (std::size_t i = 0; i < sums.sum.size(); i++) {
+        mean[i] = sums.sum[i] / sums.count;
+        meanSquaredNorm += mean[i] * mean[i];
+    }
+    // E|x - mean|^2 = E|x|^2 - |mean|^2; rounding errors could make this slightly negative.
+    double spreadSquared = sums.squaredNormSum / sums.count - meanSquaredNorm;
+    return std::sqrt(std::max(0.0, spreadSquared));
+}
+
 /* -------------------- Simple getters ---------------------- */
 long BeliefNode::getId() const {
     return id_;
@@ -132,6 +273,12 @@ BeliefNode *BeliefNode::getParentBelief() const {
     }
     return getParentActionNode()->getParentEntry()->getMapping()->getOwner();
 }
+bool BeliefNode::isInSubtreeOf(BeliefNode const *root) const {
+    return root->tourStart_.label <= tourStart_.label && tourStart_.label <= root->tourEnd_.label;
+}
+SlabAllocator *BeliefNode::getAllocator() const {
+    return solver_->getPolicy()->getAllocator();
+}
 std::unique_ptr<Observation> BeliefNode::getLastObservation() const {
     if (parentEntry_ == nullptr) {
         return nullptr;
@@ -144,6 +291,18 @@ std::unique_ptr<Action> BeliefNode::getLastAction() const {
     }
     return getParentActionNode()->getParentEntry()->getAction();
 }
+Observation const *BeliefNode::peekLastObservation() const {
+    if (parentEntry_ == nullptr) {
+        return nullptr;
+    }
+    return &parentEntry_->peekObservation();
+}
+Action const *BeliefNode::peekLastAction() const {
+    if (parentEntry_ == nullptr) {
+        return nullptr;
+    }
+    return getParentActionNode()->getParentEntry()->peekAction();
+}
 BeliefNode *BeliefNode::getChild(Action const &action, Observation const &obs) const {
     ActionNode *node = actionMap_->getActionNode(action);
     if (node == nullptr) {
@@ -152,6 +311,22 @@ BeliefNode *BeliefNode::getChild(Action const &action, Observation const &obs) c
     return node->getChild(obs);
 }
 
+/* -------------------- Synchronization  ---------------------- */
+std::mutex &BeliefNode::getMutex() const {
+    return mutex_;
+}
+void BeliefNode::addVirtualLoss(Action const &action, long deltaNLosses) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    ActionNode *node = actionMap_->getActionNode(action);
+    if (node != nullptr) {
+        node->virtualLossCount_ += deltaNLosses;
+        nVirtualLosses_ += deltaNLosses;
+    }
+}
+long BeliefNode::getVirtualLossCount() const {
+    return nVirtualLosses_;
+}
+
 /* ----------------- Management of cached values ------------------- */
 BaseCachedValue *BeliefNode::addCachedValue(std::unique_ptr<BaseCachedValue> value) {
     BaseCachedValue *rawPtr = value.get();
@@ -179,7 +354,16 @@ void BeliefNode::recalculateValue() {
 /* -------------------- Core tree-related methods  ---------------------- */
 BeliefNode *BeliefNode::createOrGetChild(Action const &action,
         Observation const &obs) {
+    std::lock_guard<std::mutex> lock(mutex_);
     ActionNode *actionNode = actionMap_->getActionNode(action);
+    if (actionNode != nullptr) {
+        BeliefNode *childNode = actionNode->getChild(obs);
+        if (childNode != nullptr) {
+            return childNode;
+        }
+    }
+
+    std::lock_guard<std::mutex> creationLock(solver_->getPolicy()->nodeCreationMutex_);
     if (actionNode == nullptr) {
         actionNode = actionMap_->createActionNode(action);
         actionNode->setMapping(solver_->getObservationPool()->createObservationMapping(actionNode));
@@ -202,17 +386,60 @@ BeliefNode *BeliefNode::createOrGetChild(Action const &action,
 
 /* -------------- Particle management / sampling ---------------- */
 void BeliefNode::addParticle(HistoryEntry *newHistEntry) {
+    std::lock_guard<std::mutex> lock(mutex_);
     particles_.add(newHistEntry);
     if (newHistEntry->getId() == 0) {
         nStartingSequences_++;
     }
+    if (stateVectorSums_ != nullptr) {
+        addStateVector(newHistEntry->getStateInfo(), 1);
+    }
 }
 
 void BeliefNode::removeParticle(HistoryEntry *histEntry) {
+    std::lock_guard<std::mutex> lock(mutex_);
     particles_.remove(histEntry);
     if (histEntry->getId() == 0) {
         nStartingSequences_--;
     }
+    if (stateVectorSums_ != nullptr) {
+        addStateVector(histEntry->getStateInfo(), -1);
+    }
+}
+
+void BeliefNode::changeParticleState(State const *oldState, State const *newState) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (stateVectorSums_ != nullptr) {
+        addStateVector(oldState, -1);
+        addStateVector(newState, 1);
+    }
+}
+
+void BeliefNode::addStateVector(StateInfo const *stateInfo, int sign) {
+    if (stateInfo != nullptr) {
+        addStateVector(stateInfo->getState(), sign);
+    }
+}
+
+void BeliefNode::addStateVector(State const *state, int sign) {
+    VectorState const *vectorState = dynamic_cast<VectorState const *>(state);
+    if (vectorState == nullptr) {
+        return;
+    }
+    std::vector<double> stateVector = vectorState->asVector();
+    StateVectorSums &sums = *stateVectorSums_;
+    sums.sum.resize(std::max(sums.sum.size(), stateVector.size()), 0.0);
+    for (std::size_t i = 0; i < stateVector.size(); i++) {
+        sums.sum[i] += sign * stateVector[i];
+        sums.squaredNormSum += sign * stateVector[i] * stateVector[i];
+    }
+    sums.count += sign;
+}
+
+BeliefNode::StateVectorSums::StateVectorSums() :
+        sum(),
+        squaredNormSum(0),
+        count(0) {
 }
 
 /* -------------------- Tree-related setters  ---------------------- */
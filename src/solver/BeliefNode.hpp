@@ -8,15 +8,21 @@
 #ifndef SOLVER_BELIEFNODE_HPP_
 #define SOLVER_BELIEFNODE_HPP_
 
+#include <atomic>                       // for atomic
 #include <functional>
 #include <map>                          // for map, map<>::value_compare
 #include <memory>                       // for unique_ptr
+#include <mutex>
 #include <set>
 #include <utility>                      // for pair
+#include <vector>                       // for vector
 
 #include "global.hpp"                     // for RandomGenerator
 #include "RandomAccessSet.hpp"
 
+#include "solver/EulerTour.hpp"
+#include "solver/SlabAllocator.hpp"
+
 #include "solver/abstract-problem/Action.hpp"                   // for Action
 #include "solver/abstract-problem/HistoricalData.hpp"
 #include "solver/abstract-problem/State.hpp"
@@ -34,6 +40,7 @@ class HistoricalData;
 class HistoryEntry;
 class ObservationMappingEntry;
 class Solver;
+class StateInfo;
 
 /** Represents a single node in a belief tree.
  *
@@ -51,13 +58,14 @@ class Solver;
  * compared to its new value after recalculation, and then the change in value can be easily
  * backpropagated.
  */
-class BeliefNode {
+class BeliefNode : public SlabAllocated {
 public:
     friend class ActionNode;
     friend class BeliefTree;
     friend class HistoryEntry;
     friend class Solver;
     friend class TextSerializer;
+    friend class TreeReclaimer;
 
     /** Constructs a new belief node with no ID, and no parent entry, that will belong to the
      * given solver.
@@ -80,8 +88,40 @@ public:
     /** Calculates the distance between this belief node and another by
      * calculating the average pairwise distance between the individual
      * particles.
+     *
+     * This is exact, but makes a call to State::distanceTo() for every pair of particles; the
+     * methods below are much faster, and this can be used to validate them.
      */
     double distL1Independent(BeliefNode *b) const;
+    /** Estimates the same distance as distL1Independent() from randomly sampled pairs of
+     * particles, stopping once the standard error of the estimate is at most the given tolerance,
+     * or once the given maximum number of pairs have been sampled.
+     *
+     * If there are no more pairs than that maximum, the exact distance is returned instead.
+     */
+    double distL1Sampled(BeliefNode *b, double tolerance, long maxPairs,
+            RandomGenerator &randGen) const;
+    /** Calculates the average L1 distance between the state vectors of pairs of particles from
+     * this belief node and another, or returns a negative number if their states aren't Vectors
+     * of the same size.
+     *
+     * This only equals distL1Independent() if the states use the L1 distance between their
+     * state vectors, but it is exact, and takes O(d * P log P) time rather than O(P^2) calls to
+     * State::distanceTo(), since the L1 distance is a sum of independent terms for each
+     * dimension.
+     */
+    double distL1StateVectors(BeliefNode *b) const;
+    /** Summarizes the particles of this node, whose states must be Vectors, by setting mean to the
+     * mean of their state vectors, and returning the root-mean-square distance of the state
+     * vectors from that mean; returns a negative number if there are no such particles.
+     *
+     * The first call makes this node keep running sums of the state vectors, which are updated as
+     * particles are added and removed; later calls take time linear only in the number of
+     * state variables.
+     *
+     * This locks the mutex of this node.
+     */
+    double getStateVectorMoments(std::vector<double> &mean);
 
     /* -------------------- Simple getters ---------------------- */
     /** Returns the id of this node. */
@@ -106,15 +146,42 @@ public:
     ActionNode *getParentActionNode() const;
     /** Returns the parent belief of this belief. */
     BeliefNode *getParentBelief() const;
+    /** Returns true iff this node is the given node or one of its descendants; this takes
+     * constant time, but both nodes must still be in the same tree.
+     */
+    bool isInSubtreeOf(BeliefNode const *root) const;
+    /** Returns the allocator for the nodes and mappings of the tree this node belongs to. */
+    SlabAllocator *getAllocator() const;
     /** Returns the last observation received before this belief. */
     std::unique_ptr<Observation> getLastObservation() const;
     /** Returns the last action taken before this belief. */
     std::unique_ptr<Action> getLastAction() const;
+    /** Returns the last observation received before this belief without copying it, or nullptr
+     * if this is the root.
+     */
+    Observation const *peekLastObservation() const;
+    /** Returns the last action taken before this belief without copying it, or nullptr if this
+     * is the root or the action mapping doesn't keep a fixed action for it.
+     */
+    Action const *peekLastAction() const;
     /** Returns the belief node child corresponding to the given action and
      * observation
      */
     BeliefNode *getChild(Action const &action, Observation const &obs) const;
 
+    /* -------------------- Synchronization  ---------------------- */
+    /** Returns the mutex guarding this node's particles, action mapping statistics and
+     * children, for use by tree-parallel search.
+     */
+    std::mutex &getMutex() const;
+    /** Adds the given number of virtual losses (or removes them, if negative) to the child
+     * action node for the given action; this discourages other search threads from following
+     * the same branch while a history through it is still in progress.
+     */
+    void addVirtualLoss(Action const &action, long deltaNLosses);
+    /** Returns the total number of virtual losses on the actions of this node. */
+    long getVirtualLossCount() const;
+
     /* ----------------- Management of cached values ------------------- */
     /** Adds a value to be cached by this belief node. */
     BaseCachedValue *addCachedValue(std::unique_ptr<BaseCachedValue> value);
@@ -138,6 +205,9 @@ public:
      *
      * The belief node will also be added to the flattened node vector of the policy tree, as
      * this is done by the BeliefNode constructor.
+     *
+     * This locks the mutex of this node, and also the node creation mutex of the tree if a new
+     * node must be created.
      */
     BeliefNode *createOrGetChild(Action const &action, Observation const &obs);
 
@@ -148,6 +218,14 @@ private:
     void addParticle(HistoryEntry *newHistEntry);
     /** Removes the given history entry from this belief node. */
     void removeParticle(HistoryEntry *histEntry);
+    /** Informs this node that the state of one of its particles has changed. */
+    void changeParticleState(State const *oldState, State const *newState);
+    /** Adds the state vector of the given state to the running sums, with the given sign; does
+     * nothing if the state is null or isn't a Vector. The mutex must be held.
+     */
+    void addStateVector(State const *state, int sign);
+    /** Adds the state vector for the given state info, if it isn't null. */
+    void addStateVector(StateInfo const *stateInfo, int sign);
 
     /* -------------------- Tree-related setters  ---------------------- */
     /** Sets the mapping for this node. */
@@ -159,12 +237,16 @@ private:
     /** The solver that this belief node belongs to. */
     Solver *solver_;
 
-    /** The ID of this node. */
-    long id_;
+    /** The ID of this node, which the TreeReclaimer can change while the tree is being
+     * searched.
+     */
+    std::atomic<long> id_;
     /** The depth of this node in the tree. */
     long depth_;
     /** The observation entry that is this node's parent / owner. */
     ObservationMappingEntry *parentEntry_;
+    /** The points where the tree's Euler tour enters and leaves this node. */
+    EulerTour::Item tourStart_, tourEnd_;
 
     /** The smart history-based data, to be used for history-based policies. */
     std::unique_ptr<HistoricalData> data_;
@@ -173,6 +255,32 @@ private:
     /** The number of sequences that start at this node. */
     long nStartingSequences_;
 
+    /** Running sums over the state vectors of the particles in this node. */
+    struct StateVectorSums {
+        StateVectorSums();
+
+        /** The sum of the state vectors. */
+        std::vector<double> sum;
+        /** The sum of the squared norms of the state vectors. */
+        double squaredNormSum;
+        /** The number of state vectors. */
+        long count;
+    };
+    /** The running sums of the state vectors, or null if getStateVectorMoments() has never been
+     * called; guarded by mutex_.
+     */
+    std::unique_ptr<StateVectorSums> stateVectorSums_;
+
+    /** True iff this node is waiting in the solver's deferred backup queue. */
+    bool isQueuedForBackup_;
+    /** The change in total q-value that has yet to be passed on to the parent action, because
+     * it was within the solver's backup tolerance.
+     */
+    double unpropagatedTotalQ_;
+
+    /** The total number of virtual losses on the child action nodes; guarded by mutex_. */
+    long nVirtualLosses_;
+
     /** A mapping of actions to action children for this node. */
     std::unique_ptr<ActionMapping> actionMap_;
 
@@ -180,6 +288,9 @@ private:
     std::unordered_map<BaseCachedValue const *, std::unique_ptr<BaseCachedValue>> cachedValues_;
     /** Calculates and caches the estimated value of this node. */
     CachedValue<double> *valueEstimator_;
+
+    /** The mutex for this node. */
+    mutable std::mutex mutex_;
 };
 } /* namespace solver */
 
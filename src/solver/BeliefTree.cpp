@@ -5,11 +5,13 @@
 #include "solver/BeliefTree.hpp"
 
 #include <memory>                       // for unique_ptr
+#include <mutex>                        // for lock_guard
 #include <vector>                       // for vector
 #include <iostream>
 
 #include "global.hpp"                     // for make_unique
 
+#include "solver/ActionNode.hpp"
 #include "solver/BeliefNode.hpp"               // for BeliefNode
 #include "solver/Solver.hpp"
 
@@ -19,12 +21,16 @@
 
 #include "solver/mappings/actions/ActionMapping.hpp"
 #include "solver/mappings/actions/ActionPool.hpp"
+#include "solver/mappings/observations/ObservationMapping.hpp"
 
 namespace solver {
 BeliefTree::BeliefTree(Solver *solver) :
     solver_(solver),
     allNodes_(),
-    root_(nullptr) {
+    allocator_(),
+    tour_(),
+    root_(nullptr),
+    nodeCreationMutex_() {
 }
 
 // Do nothing!
@@ -36,6 +42,10 @@ BeliefNode *BeliefTree::getRoot() const {
     return root_.get();
 }
 BeliefNode *BeliefTree::getNode(long id) const {
+    std::lock_guard<std::mutex> lock(nodeCreationMutex_);
+    if (id < 0 || id >= static_cast<long>(allNodes_.size())) {
+        return nullptr;
+    }
     BeliefNode *node = allNodes_[id];
     if (node->getId() != id) {
         std::ostringstream message;
@@ -43,14 +53,19 @@ BeliefNode *BeliefTree::getNode(long id) const {
         message << " but was " << node->getId();
         debug::show_message(message.str());;
     }
-    return allNodes_[id];
+    return node;
 }
 long BeliefTree::getNumberOfNodes() const {
+    std::lock_guard<std::mutex> lock(nodeCreationMutex_);
     return allNodes_.size();
 }
 std::vector<BeliefNode *> BeliefTree::getNodes() const {
+    std::lock_guard<std::mutex> lock(nodeCreationMutex_);
     return allNodes_;
 }
+SlabAllocator *BeliefTree::getAllocator() {
+    return &allocator_;
+}
 
 /* ============================ PRIVATE ============================ */
 
@@ -68,20 +83,33 @@ void BeliefTree::addNode(BeliefNode *node) {
         debug::show_message("ERROR: Node already exists - overwriting!!");
     }
     allNodes_[id] = node;
+
+    // The parent always comes first, so the tour only has to go into the node and back out again.
+    BeliefNode *parent = node->getParentBelief();
+    EulerTour::Item *position = (parent == nullptr ? tour_.getLast() : parent->tourEnd_.previous);
+    tour_.insertAfter(position, &node->tourStart_);
+    tour_.insertAfter(&node->tourStart_, &node->tourEnd_);
 }
 
 void BeliefTree::removeNode(BeliefNode *node) {
+    if (unindexNode(node)) {
+        EulerTour::remove(&node->tourStart_);
+        EulerTour::remove(&node->tourEnd_);
+    }
+}
+
+bool BeliefTree::unindexNode(BeliefNode *node) {
     long id = node->id_;
 
     long lastNodeId = allNodes_.size() - 1;
 
     if (id < 0 || id > lastNodeId) {
         debug::show_message("ERROR: Node ID is out of bounds.");
-        return;
+        return false;
     }
     if (allNodes_[id] != node) {
         debug::show_message("ERROR: Node ID does not match index.");
-        return;
+        return false;
     }
 
     // Now remove the node from the index.
@@ -91,16 +119,51 @@ void BeliefTree::removeNode(BeliefNode *node) {
         allNodes_[id] = lastNode;
     }
     allNodes_.pop_back();
+    node->id_ = -1;
+    return true;
+}
+
+void BeliefTree::detachSubtree(BeliefNode *root) {
+    EulerTour::removeRange(&root->tourStart_, &root->tourEnd_);
+}
+
+void BeliefTree::removeDetachedSubtree(BeliefNode *root) {
+    {
+        // The lock is only held for one node at a time, so that the search isn't held up.
+        std::lock_guard<std::mutex> lock(nodeCreationMutex_);
+        unindexNode(root);
+    }
+    if (root->getMapping() == nullptr) {
+        return;
+    }
+    root->getMapping()->forEachChildEntry([this] (ActionMappingEntry const *actionEntry) {
+        ObservationMapping *obsMap = actionEntry->getActionNode()->getMapping();
+        obsMap->forEachChildEntry([this] (ObservationMappingEntry const *obsEntry) {
+            removeDetachedSubtree(obsEntry->getBeliefNode());
+        });
+    });
+}
+
+std::vector<BeliefNode *> BeliefTree::releaseAllNodes() {
+    std::vector<BeliefNode *> released;
+    released.swap(allNodes_);
+    tour_.clear();
+    return released;
 }
 
 /* ------------------- Tree modification ------------------- */
 BeliefNode *BeliefTree::reset() {
     root_ = nullptr;
-    root_ = std::make_unique<BeliefNode>(solver_);
+    root_ = allocate_unique<BeliefNode>(&allocator_, solver_);
     BeliefNode *rootPtr = root_.get();
     return rootPtr;
 }
 
+BeliefNode *BeliefTree::reset(std::unique_ptr<BeliefNode> &oldRoot) {
+    oldRoot = std::move(root_);
+    return reset();
+}
+
 void BeliefTree::initializeRoot() {
     root_->setHistoricalData(solver_->getModel()->createRootHistoricalData());
     root_->setMapping(solver_->getActionPool()->createActionMapping(root_.get()));
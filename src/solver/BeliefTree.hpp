@@ -10,10 +10,14 @@
 #define SOLVER_BELIEFTREE_HPP_
 
 #include <memory>                       // for unique_ptr
+#include <mutex>
 #include <vector>                       // for vector
 
 #include "global.hpp"
 
+#include "solver/EulerTour.hpp"
+#include "solver/SlabAllocator.hpp"
+
 #include "solver/abstract-problem/Action.hpp"
 #include "solver/abstract-problem/Observation.hpp"
 
@@ -27,11 +31,15 @@ class Solver;
  * ABT solver.
  *
  * This class just owns the root belief node; each individual node in the tree is owned by
- * its parent mapping entry.
+ * its parent mapping entry. The nodes, mappings and mapping entries are allocated via the tree's
+ * SlabAllocator, so that freeing a subtree gives its memory back in whole slabs.
  *
  * However, this belief tree also keeps track of an index of nodes, represented by a
  * vector of non-owning pointers to the individual belief nodes.
  * This allows for access by node ID, iteration and serialization.
+ *
+ * The nodes in the index are also kept in an EulerTour, which is what allows
+ * BeliefNode::isInSubtreeOf() to take constant time.
  */
 class BeliefTree {
     friend class Agent;
@@ -39,6 +47,7 @@ class BeliefTree {
     friend class HistorySequence;
     friend class Solver;
     friend class TextSerializer;
+    friend class TreeReclaimer;
 
 public:
     /** Constructs an empty belief tree. */
@@ -49,24 +58,56 @@ public:
     /* ------------------- Simple getters --------------------- */
     /** Returns the root node. */
     BeliefNode *getRoot() const;
-    /** Retrieves the node with the given ID. */
+    /** Retrieves the node with the given ID, or nullptr if there is no such node.
+     *
+     * The index can shrink while the tree is being searched, as the TreeReclaimer removes pruned
+     * nodes from it, so callers that loop over the IDs must check for nullptr.
+     */
     BeliefNode *getNode(long id) const;
     /** Returns the number of belief nodes. */
     long getNumberOfNodes() const;
     /** Retrieves a vector of all belief nodes within the policy. */
     std::vector<BeliefNode *> getNodes() const;
+    /** Returns the allocator for the nodes, mappings and mapping entries of this tree. */
+    SlabAllocator *getAllocator();
 
 private:
     /* ------------------- Node index modification ------------------- */
-    /** Adds the given node to the index of nodes. */
+    /** Adds the given node to the index of nodes, and to the Euler tour just before the tour
+     * leaves its parent.
+     */
     void addNode(BeliefNode *node);
 
     /** Removes the given node from the index of nodes. */
     void removeNode(BeliefNode *node);
+    /** Removes the given node from the index of nodes, but not from the Euler tour; returns
+     * false if it wasn't in the index.
+     */
+    bool unindexNode(BeliefNode *node);
+    /** Takes the given node and all of its descendants out of the Euler tour, in constant time;
+     * the node must then be unlinked from its parent, and the subtree passed to
+     * removeDetachedSubtree().
+     */
+    void detachSubtree(BeliefNode *root);
+    /** Removes the given node and all of its descendants, which must have been detached, from the
+     * index of nodes without deleting them.
+     *
+     * This can be called while the rest of the tree is being searched, as the index is only
+     * changed while holding the node creation mutex.
+     */
+    void removeDetachedSubtree(BeliefNode *root);
+    /** Empties the index of nodes and the Euler tour, and returns the nodes that were in the
+     * index without changing them.
+     */
+    std::vector<BeliefNode *> releaseAllNodes();
 
     /* ------------------- Tree modification ------------------- */
     /** Resets the tree, creating a new root node and returning it. */
     BeliefNode *reset();
+    /** Resets the tree like reset(), but hands over the old root instead of deleting it; the old
+     * nodes must already have been removed from the index.
+     */
+    BeliefNode *reset(std::unique_ptr<BeliefNode> &oldRoot);
 
     /** Initializes the root node - for creating a new tree from scratch. */
     void initializeRoot();
@@ -79,8 +120,18 @@ private:
     /** A vector of pointers to the all of the nodes of the tree. */
     std::vector<BeliefNode *> allNodes_;
 
+    /** The allocator for the parts of the tree; this must outlive the root. */
+    SlabAllocator allocator_;
+    /** The tour of the nodes in the index; this must also outlive the root. */
+    EulerTour tour_;
+
     /** The root node for this tree. */
     std::unique_ptr<BeliefNode> root_;
+
+    /** Guards the creation of new nodes, which modifies the node index and uses the action and
+     * observation pools, and any other access to the node index while the tree may be searched.
+     */
+    mutable std::mutex nodeCreationMutex_;
 };
 } /* namespace solver */
 
@@ -0,0 +1,106 @@
+/** @file EulerTour.cpp
+ *
+ * Contains the implementation of the EulerTour class.
+ */
+#include "solver/EulerTour.hpp"
+
+#include <cstdint>                      // for uint64_t
+
+#include "global.hpp"
+
+namespace solver {
+namespace {
+/** The number of bits in each label; a few are spare so that the sums can't overflow. */
+int const LABEL_BITS = 62;
+/** One more than the largest label. */
+std::uint64_t const LABEL_LIMIT = std::uint64_t(1) << LABEL_BITS;
+/** A range of 2^i labels is sparse enough to be relabeled if it holds at most
+ * (2 / OVERFLOW_BASE)^i items; this must be between 1 and 2.
+ */
+double const OVERFLOW_BASE = 1.4;
+} /* namespace */
+
+EulerTour::EulerTour() :
+        start_() {
+    clear();
+}
+
+EulerTour::Item *EulerTour::getLast() {
+    return start_.previous;
+}
+
+void EulerTour::insertAfter(Item *position, Item *item) {
+    item->previous = position;
+    item->next = position->next;
+    position->next->previous = item;
+    position->next = item;
+
+    std::uint64_t low = position->label;
+    std::uint64_t high = (item->next == &start_ ? LABEL_LIMIT : item->next->label);
+    if (high - low > 1) {
+        item->label = low + (high - low) / 2;
+    } else {
+        relabel(item);
+    }
+}
+
+void EulerTour::remove(Item *item) {
+    item->previous->next = item->next;
+    item->next->previous = item->previous;
+    item->previous = nullptr;
+    item->next = nullptr;
+}
+
+void EulerTour::removeRange(Item *first, Item *last) {
+    first->previous->next = last->next;
+    last->next->previous = first->previous;
+    first->previous = nullptr;
+    last->next = nullptr;
+}
+
+void EulerTour::clear() {
+    start_.previous = &start_;
+    start_.next = &start_;
+}
+
+/* ============================ PRIVATE ============================ */
+
+void EulerTour::relabel(Item *item) {
+    // Look at the aligned ranges of labels around the new item, doubling the size each time,
+    // and keep track of the first and last items in the current range.
+    std::uint64_t base = item->previous->label;
+    Item *first = item;
+    Item *last = item;
+    std::uint64_t count = 1;
+    double maxCount = 1;
+    for (int bits = 1; bits <= LABEL_BITS; bits++) {
+        maxCount *= 2 / OVERFLOW_BASE;
+        std::uint64_t size = std::uint64_t(1) << bits;
+        std::uint64_t low = base & ~(size - 1);
+        std::uint64_t high = low + size;
+        while (first->previous != &start_ && first->previous->label >= low) {
+            first = first->previous;
+            count++;
+        }
+        while (last->next != &start_ && last->next->label < high) {
+            last = last->next;
+            count++;
+        }
+        // The label 0 belongs to the start of the tour.
+        if (low == 0) {
+            low = 1;
+        }
+        if ((count <= maxCount || bits == LABEL_BITS) && count <= high - low) {
+            // Spread the items in the range out evenly.
+            std::uint64_t step = (high - low) / count;
+            std::uint64_t label = low;
+            for (Item *current = first; current != last->next; current = current->next) {
+                current->label = label;
+                label += step;
+            }
+            return;
+        }
+    }
+    debug::show_message("ERROR: Ran out of labels for the Euler tour!");
+}
+} /* namespace solver */
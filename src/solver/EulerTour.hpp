@@ -0,0 +1,81 @@
+/** @file EulerTour.hpp
+ *
+ * Contains the EulerTour class, which keeps the nodes of a belief tree in depth-first order so
+ * that ancestors can be checked in constant time.
+ */
+#ifndef SOLVER_EULERTOUR_HPP_
+#define SOLVER_EULERTOUR_HPP_
+
+#include <cstdint>                      // for uint64_t
+
+#include "global.hpp"
+
+namespace solver {
+/** An ordered list of items with integer labels, which can be compared in constant time.
+ *
+ * Each belief node has two items - one where the tour enters the node, and one where it leaves
+ * again - and the items of a node's descendants are all between those two. A new node's items
+ * go just before where the tour leaves its parent, so a node is a descendant of another iff its
+ * entry label is between the two labels of the other node.
+ *
+ * The labels are kept in order as items are inserted using the order-maintenance algorithm of
+ * Bender et al. ("Two simplified algorithms for maintaining order in a list", 2002). A new item
+ * normally takes the label halfway between its neighbors; when there is no gap, the smallest
+ * aligned range of labels around it that is sparse enough is relabeled evenly. This takes
+ * amortized logarithmic time per insertion, and removing an item takes constant time.
+ *
+ * Items are not thread-safe; BeliefTree only changes the tour while creating or removing nodes.
+ */
+class EulerTour {
+  public:
+    /** A position in the tour. */
+    struct Item {
+        /** Constructs an item that is not in any tour. */
+        Item() :
+                previous(nullptr),
+                next(nullptr),
+                label(0) {
+        }
+        _NO_COPY_OR_MOVE(Item);
+
+        /** The item before this one; the last item links back to the start of the tour. */
+        Item *previous;
+        /** The item after this one; the first item links back to the start of the tour. */
+        Item *next;
+        /** The label of this item, which is larger than the labels of all of the items before it.
+         */
+        std::uint64_t label;
+    };
+
+    /** Constructs an empty tour. */
+    EulerTour();
+    ~EulerTour() = default;
+    _NO_COPY_OR_MOVE(EulerTour);
+
+    /** Returns the last item in the tour, or the start of the tour if it is empty. */
+    Item *getLast();
+
+    /** Inserts the given item just after the given position, which is either an item in this
+     * tour or the result of getLast().
+     */
+    void insertAfter(Item *position, Item *item);
+    /** Removes the given item from this tour. */
+    static void remove(Item *item);
+    /** Removes the given items, and all of the items between them, from their tour; the items
+     * in between are still linked to each other, so that they can be discarded without being
+     * removed one by one.
+     */
+    static void removeRange(Item *first, Item *last);
+    /** Removes every item from this tour, without changing the items themselves. */
+    void clear();
+
+  private:
+    /** Gives the given new item a label, relabeling the items around it if there is no gap. */
+    void relabel(Item *item);
+
+    /** The start of the tour, which has the label 0 and isn't a real item. */
+    Item start_;
+};
+} /* namespace solver */
+
+#endif /* SOLVER_EULERTOUR_HPP_ */
@@ -13,7 +13,9 @@
 
 namespace solver {
 Histories::Histories() :
-        sequencesById_() {
+        arena_(),
+        sequencesById_(),
+        mutex_() {
 }
 
 /* ------------------- Retrieving sequences ------------------- */
@@ -31,15 +33,22 @@ HistorySequence *Histories::getSequence(long seqId) const {
 /* ---------------- Adding / removing sequences  ---------------- */
 void Histories::reset() {
     sequencesById_.clear();
+    arena_.reset();
 }
 HistorySequence *Histories::createSequence() {
+    std::lock_guard<std::mutex> lock(mutex_);
     std::unique_ptr<HistorySequence> histSeq(
-            std::make_unique<HistorySequence>(sequencesById_.size()));
+            std::make_unique<HistorySequence>(sequencesById_.size(), &arena_));
     HistorySequence *rawPtr = histSeq.get();
     sequencesById_.push_back(std::move(histSeq));
     return rawPtr;
 }
 void Histories::deleteSequence(HistorySequence *sequence) {
+    // Deregister and clear the sequence.
+    releaseSequence(sequence)->erase();
+}
+std::unique_ptr<HistorySequence> Histories::releaseSequence(HistorySequence *sequence) {
+    std::lock_guard<std::mutex> lock(mutex_);
     // Retrieve the current ID of the sequence, which should be its position in the vector.
     long seqId = sequence->id_;
 
@@ -47,12 +56,18 @@ void Histories::deleteSequence(HistorySequence *sequence) {
         debug::show_message("ERROR: sequence ID does not match its index!");
     }
 
-    // Deregister and clear the sequence.
-    sequence->erase();
+    std::unique_ptr<HistorySequence> released = std::move(sequencesById_[seqId]);
     if (seqId < static_cast<long>(sequencesById_.size()) - 1) {
         sequencesById_[seqId] = std::move(sequencesById_[sequencesById_.size()-1]);
         sequencesById_[seqId]->id_ = seqId;
     }
     sequencesById_.pop_back();
+    return released;
+}
+std::vector<std::unique_ptr<HistorySequence>> Histories::releaseAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<std::unique_ptr<HistorySequence>> released;
+    released.swap(sequencesById_);
+    return released;
 }
 } /* namespace solver */
@@ -2,16 +2,21 @@
  *
  * Contains the Histories class, which represents a collection of history sequences.
  *
- * This class owns the associated sequences, which are stored in a vector of unique_ptr
+ * This class owns the associated sequences, which are stored in a vector of unique_ptr; it also owns
+ * the arena that holds the entries of those sequences.
  */
 #ifndef SOLVER_HISTORIES_HPP_
 #define SOLVER_HISTORIES_HPP_
 
 #include <map>                          // for map
 #include <memory>                       // for unique_ptr
+#include <mutex>
+#include <vector>                       // for vector
 
 #include "global.hpp"
 
+#include "solver/HistoryEntryArena.hpp"
+
 namespace solver {
 class HistoryEntry;
 class HistorySequence;
@@ -33,6 +38,7 @@ class Histories {
   public:
     friend class Solver;
     friend class TextSerializer;
+    friend class TreeReclaimer;
 
     /** Constructs an empty bundle of histories. */
     Histories();
@@ -50,16 +56,29 @@ class Histories {
 
   private:
     /* ---------------- Adding / removing sequences  ---------------- */
-    /** Resets the histories to be empty. */
+    /** Resets the histories to be empty, releasing the memory for all of their entries. */
     void reset();
     /** Adds a new history sequence. */
     HistorySequence *createSequence();
     /** Deletes the given history sequence. */
     void deleteSequence(HistorySequence *sequence);
+    /** Removes the given history sequence from this collection and returns it, without
+     * deregistering its entries; the IDs are kept contiguous in the same way as deleteSequence().
+     */
+    std::unique_ptr<HistorySequence> releaseSequence(HistorySequence *sequence);
+    /** Removes all of the sequences from this collection and returns them, without deregistering
+     * their entries. Unlike reset(), this keeps the arena, which must outlive the sequences.
+     */
+    std::vector<std::unique_ptr<HistorySequence>> releaseAll();
 
   private:
+    /** The arena that holds the entries of the sequences; this must outlive the sequences. */
+    HistoryEntryArena arena_;
     /** A vector to hold all of the sequences in this collection. */
     std::vector<std::unique_ptr<HistorySequence>> sequencesById_;
+
+    /** Guards the creation and deletion of sequences. */
+    std::mutex mutex_;
 };
 } /* namespace solver */
 
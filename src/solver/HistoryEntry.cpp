@@ -80,6 +80,11 @@ void HistoryEntry::registerState(StateInfo *info) {
     if (stateInfo_ == info) {
         return;
     }
+    if (associatedBeliefNode_ != nullptr) {
+        associatedBeliefNode_->changeParticleState(
+                stateInfo_ == nullptr ? nullptr : stateInfo_->getState(),
+                info == nullptr ? nullptr : info->getState());
+    }
     if (stateInfo_ != nullptr) {
         stateInfo_->removeHistoryEntry(this);
         stateInfo_ = nullptr;
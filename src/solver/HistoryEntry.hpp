@@ -52,6 +52,7 @@ public:
     friend class Simulator;
     friend class Solver;
     friend class TextSerializer;
+    friend class TreeReclaimer;
 
     /** The ID type of this HistoryEntry. This should be an integer type with at least 16 bits. */
     typedef uint16_t IdType;
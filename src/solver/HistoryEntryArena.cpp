@@ -0,0 +1,83 @@
+/** @file HistoryEntryArena.cpp
+ *
+ * Contains the implementation of the HistoryEntryArena class.
+ */
+#include "solver/HistoryEntryArena.hpp"
+
+#include <iterator>                     // for prev
+#include <map>                          // for map
+#include <memory>                       // for unique_ptr
+#include <mutex>
+
+namespace solver {
+HistoryEntryArena::HistoryEntryArena() :
+        chunks_(),
+        availableChunks_(),
+        spareBlocks_(nullptr),
+        mutex_() {
+}
+
+HistoryEntryArena::Block *HistoryEntryArena::allocateBlock() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (availableChunks_.empty()) {
+        std::unique_ptr<Chunk> chunk(new Chunk { std::move(spareBlocks_), 0, 0, { }, 0 });
+        if (chunk->blocks == nullptr) {
+            chunk->blocks.reset(new Block[BLOCKS_PER_CHUNK]);
+        }
+        availableChunks_.push_back(chunk.get());
+        chunks_.emplace(chunk->blocks.get(), std::move(chunk));
+    }
+
+    Chunk *chunk = availableChunks_.back();
+    Block *block;
+    if (!chunk->freeBlocks.empty()) {
+        block = chunk->freeBlocks.back();
+        chunk->freeBlocks.pop_back();
+    } else {
+        block = &chunk->blocks[chunk->nBlocksTouched++];
+    }
+    chunk->nBlocksInUse++;
+    if (chunk->nBlocksInUse == BLOCKS_PER_CHUNK) {
+        // This chunk is full, so it's no longer available.
+        availableChunks_.pop_back();
+        chunk->availableIndex = -1;
+    }
+    return block;
+}
+
+void HistoryEntryArena::freeBlock(Block *block) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    // The chunk holding the block is the last one that starts at or before it.
+    Chunk *chunk = std::prev(chunks_.upper_bound(block))->second.get();
+    chunk->nBlocksInUse--;
+    if (chunk->nBlocksInUse == 0) {
+        releaseChunk(chunk);
+        return;
+    }
+    chunk->freeBlocks.push_back(block);
+    if (chunk->availableIndex < 0) {
+        chunk->availableIndex = availableChunks_.size();
+        availableChunks_.push_back(chunk);
+    }
+}
+
+void HistoryEntryArena::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    availableChunks_.clear();
+    chunks_.clear();
+    spareBlocks_ = nullptr;
+}
+
+void HistoryEntryArena::releaseChunk(Chunk *chunk) {
+    if (chunk->availableIndex >= 0) {
+        // Move the last available chunk into this one's place.
+        Chunk *lastChunk = availableChunks_.back();
+        availableChunks_[chunk->availableIndex] = lastChunk;
+        lastChunk->availableIndex = chunk->availableIndex;
+        availableChunks_.pop_back();
+    }
+    auto it = chunks_.find(chunk->blocks.get());
+    spareBlocks_ = std::move(chunk->blocks);
+    chunks_.erase(it);
+}
+} /* namespace solver */
@@ -0,0 +1,87 @@
+/** @file HistoryEntryArena.hpp
+ *
+ * Contains the HistoryEntryArena class, which hands out the memory used to store the entries of
+ * history sequences.
+ */
+#ifndef SOLVER_HISTORYENTRYARENA_HPP_
+#define SOLVER_HISTORYENTRYARENA_HPP_
+
+#include <map>                          // for map
+#include <memory>                       // for unique_ptr
+#include <mutex>
+#include <type_traits>                  // for aligned_storage
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+#include "solver/HistoryEntry.hpp"
+
+namespace solver {
+/** Hands out blocks of memory, each of which can hold HistoryEntryArena::BLOCK_SIZE history
+ * entries.
+ *
+ * Blocks are carved out of large chunks, so a sequence's entries are stored contiguously in
+ * blocks rather than each being allocated separately. Freed blocks are kept for reuse, and a
+ * chunk is released as soon as all of its blocks have been freed, apart from a single spare
+ * chunk that is kept for the next allocation. reset() releases all of the chunks at once.
+ *
+ * The arena only deals with raw memory; the HistorySequence that uses a block is responsible for
+ * constructing and destroying the entries in it.
+ *
+ * allocateBlock() and freeBlock() can safely be called from several threads at once.
+ */
+class HistoryEntryArena {
+  public:
+    /** The number of history entries in each block. */
+    static long const BLOCK_SIZE = 16;
+    /** The number of blocks in each chunk. */
+    static long const BLOCKS_PER_CHUNK = 256;
+
+    /** Raw storage for one block of history entries. */
+    typedef std::aligned_storage<sizeof(HistoryEntry) * BLOCK_SIZE,
+            alignof(HistoryEntry)>::type Block;
+
+    /** Constructs an empty arena. */
+    HistoryEntryArena();
+    ~HistoryEntryArena() = default;
+    _NO_COPY_OR_MOVE(HistoryEntryArena);
+
+    /** Returns the memory for a new block. */
+    Block *allocateBlock();
+    /** Returns the given block to this arena for reuse. */
+    void freeBlock(Block *block);
+    /** Releases all of the memory held by this arena; every block must already have been freed,
+     * or at least no longer be in use.
+     */
+    void reset();
+
+  private:
+    /** A chunk of blocks, with its own record of which blocks are free. */
+    struct Chunk {
+        /** The blocks in this chunk. */
+        std::unique_ptr<Block[]> blocks;
+        /** The number of blocks that are currently in use. */
+        long nBlocksInUse;
+        /** The number of blocks that have ever been handed out; the rest are untouched. */
+        long nBlocksTouched;
+        /** The blocks that have been freed, which will be handed out again first. */
+        std::vector<Block *> freeBlocks;
+        /** This chunk's position in availableChunks_, or -1 if it has no blocks to spare. */
+        long availableIndex;
+    };
+
+    /** Releases the given chunk, which has no blocks in use; the mutex must be held. */
+    void releaseChunk(Chunk *chunk);
+
+    /** The chunks, indexed by the address of their first block. */
+    std::map<Block const *, std::unique_ptr<Chunk>> chunks_;
+    /** The chunks that have blocks to spare. */
+    std::vector<Chunk *> availableChunks_;
+    /** The memory of the last released chunk, which is reused for the next new chunk. */
+    std::unique_ptr<Block[]> spareBlocks_;
+    /** Guards the chunks. */
+    std::mutex mutex_;
+};
+} /* namespace solver */
+
+#endif /* SOLVER_HISTORYENTRYARENA_HPP_ */
@@ -7,6 +7,7 @@
 #include <limits>
 
 #include <memory>                       // for unique_ptr
+#include <new>                          // for placement new
 #include <utility>                      // for move
 #include <vector>                       // for vector, __alloc_traits<>::value_type
 
@@ -27,16 +28,27 @@ HistorySequence::HistorySequence() :
     HistorySequence(-1) {
 }
 
-HistorySequence::HistorySequence(long id) :
+HistorySequence::HistorySequence(long id, HistoryEntryArena *arena) :
     id_(id),
-    entrySequence_(),
+    arena_(arena),
+    blocks_(),
+    length_(0),
     startAffectedIdx_(std::numeric_limits<long>::max()),
     endAffectedIdx_(-1),
     changeFlags_(ChangeFlags::UNCHANGED) {
 }
 
-// Do nothing!
 HistorySequence::~HistorySequence() {
+    for (long i = length_ - 1; i >= 0; i--) {
+        getEntryAddress(i)->~HistoryEntry();
+    }
+    for (HistoryEntryArena::Block *block : blocks_) {
+        if (arena_ != nullptr) {
+            arena_->freeBlock(block);
+        } else {
+            delete block;
+        }
+    }
 }
 
 /* ------------------ Simple getters ------------------- */
@@ -44,21 +56,21 @@ long HistorySequence::getId() const {
     return id_;
 }
 long HistorySequence::getLength() const {
-    return entrySequence_.size();
+    return length_;
 }
 HistoryEntry *HistorySequence::getEntry(HistoryEntry::IdType entryId) const {
-    return entrySequence_[entryId].get();
+    return getEntryAddress(entryId);
 }
 HistoryEntry *HistorySequence::getFirstEntry() const {
-    return entrySequence_.front().get();
+    return getEntryAddress(0);
 }
 HistoryEntry *HistorySequence::getLastEntry() const {
-    return entrySequence_.back().get();
+    return getEntryAddress(length_ - 1);
 }
 std::vector<State const *> HistorySequence::getStates() const {
     std::vector<State const *> states;
-    for (std::unique_ptr<HistoryEntry> const &entry : entrySequence_) {
-        states.push_back(entry->getState());
+    for (long i = 0; i < length_; i++) {
+        states.push_back(getEntryAddress(i)->getState());
     }
     return states;
 }
@@ -69,20 +81,46 @@ std::vector<State const *> HistorySequence::getStates() const {
 
 /* ----------- Methods to add or remove history entries ------------- */
 void HistorySequence::erase(HistoryEntry::IdType firstEntryId) {
-    for (auto it = entrySequence_.crbegin();
-            it != entrySequence_.crend() && (*it)->entryId_ >= firstEntryId; it++) {
-        (*it)->registerNode(nullptr);
-        (*it)->registerState(nullptr);
+    for (long i = length_ - 1; i >= firstEntryId; i--) {
+        HistoryEntry *entry = getEntryAddress(i);
+        entry->registerNode(nullptr);
+        entry->registerState(nullptr);
+        entry->~HistoryEntry();
+    }
+    if (firstEntryId < length_) {
+        length_ = firstEntryId;
+    }
+
+    // Give back any blocks that are now empty.
+    long nBlocksUsed = ((length_ + HistoryEntryArena::BLOCK_SIZE - 1)
+            / HistoryEntryArena::BLOCK_SIZE);
+    while (static_cast<long>(blocks_.size()) > nBlocksUsed) {
+        if (arena_ != nullptr) {
+            arena_->freeBlock(blocks_.back());
+        } else {
+            delete blocks_.back();
+        }
+        blocks_.pop_back();
     }
-    entrySequence_.erase(entrySequence_.begin() + firstEntryId, entrySequence_.end());
 }
 
 HistoryEntry *HistorySequence::addEntry() {
-    std::unique_ptr<HistoryEntry> newEntry = std::make_unique<HistoryEntry>(
-            this, entrySequence_.size());
-    HistoryEntry *newEntryReturn = newEntry.get();
-    entrySequence_.push_back(std::move(newEntry));
-    return newEntryReturn;
+    if (length_ == static_cast<long>(blocks_.size()) * HistoryEntryArena::BLOCK_SIZE) {
+        if (arena_ != nullptr) {
+            blocks_.push_back(arena_->allocateBlock());
+        } else {
+            blocks_.push_back(new HistoryEntryArena::Block);
+        }
+    }
+    HistoryEntry *newEntry = new (getEntryAddress(length_)) HistoryEntry(this, length_);
+    length_++;
+    return newEntry;
+}
+
+HistoryEntry *HistorySequence::getEntryAddress(long entryId) const {
+    HistoryEntry *block = reinterpret_cast<HistoryEntry *>(
+            blocks_[entryId / HistoryEntryArena::BLOCK_SIZE]);
+    return block + entryId % HistoryEntryArena::BLOCK_SIZE;
 }
 
 /* -------------- Change flagging methods ---------------- */
@@ -2,7 +2,7 @@
  *
  * Contains the HistorySequence class, which represents a single history sequence.
  *
- * For the most part, a history sequence is just a vector of history entries; it also stores
+ * For the most part, a history sequence is just an array of history entries; it also stores
  * the starting index and ending index of any changes that affect this sequence, as well as
  * the collective types of these changes.
  */
@@ -15,6 +15,7 @@
 #include "global.hpp"
 
 #include "solver/HistoryEntry.hpp"
+#include "solver/HistoryEntryArena.hpp"
 
 #include "solver/changes/ChangeFlags.hpp"               // for ChangeFlags
 
@@ -29,7 +30,8 @@ class StateInfo;
 
 /** Represents a single history sequence.
  *
- * The sequence owns its entries, which are stored in a vector of unique_ptr<HistoryEntry>.
+ * The sequence owns its entries, which are stored in place in fixed-size blocks taken from a
+ * HistoryEntryArena; entries never move, so pointers to them stay valid until they are erased.
  *
  * The sequence also keeps track of the first index and last index for entries that have been
  * affected by changes, as well as the logical disjunction (or) of all changes that affect the
@@ -43,13 +45,16 @@ class HistorySequence {
     friend class Simulator;
     friend class Solver;
     friend class TextSerializer;
+    friend class TreeReclaimer;
 
     /** Constructs an empty history sequence, with no ID assigned. */
     HistorySequence();
-    /** Constructs an empty history sequence, assigning the given ID. */
-    HistorySequence(long id);
+    /** Constructs an empty history sequence, assigning the given ID; the entries will be stored
+     * in blocks from the given arena (nullptr => blocks are allocated individually).
+     */
+    HistorySequence(long id, HistoryEntryArena *arena = nullptr);
 
-    // Default destructor; copying and moving disallowed!
+    // Destroys the entries, and returns their blocks to the arena; copying and moving disallowed!
     ~HistorySequence();
     _NO_COPY_OR_MOVE(HistorySequence);
 
@@ -73,6 +78,8 @@ class HistorySequence {
     void erase(HistoryEntry::IdType firstEntryId = 0);
     /** Adds a new entry to this sequence, and returns a pointer to it. */
     HistoryEntry *addEntry();
+    /** Returns the memory for the entry with the given ID. */
+    HistoryEntry *getEntryAddress(long entryId) const;
 
     /* -------------- Change flagging methods ---------------- */
     /** Resets the changes for this sequence and all its entries. */
@@ -90,8 +97,12 @@ class HistorySequence {
     /** The ID of this sequence. */
     long id_;
 
-    /** The actual sequence of history entries. */
-    std::vector<std::unique_ptr<HistoryEntry>> entrySequence_;
+    /** The arena that provides the blocks for the entries, if any. */
+    HistoryEntryArena *arena_;
+    /** The blocks holding the entries; entry i is in block i / HistoryEntryArena::BLOCK_SIZE. */
+    std::vector<HistoryEntryArena::Block *> blocks_;
+    /** The number of entries in this sequence. */
+    long length_;
 
     /** The start and end of where this sequence is affected by changes. */
     long startAffectedIdx_, endAffectedIdx_;
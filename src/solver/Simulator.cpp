@@ -42,9 +42,15 @@ Simulator::Simulator(std::unique_ptr<Model> model, Solver *solver, bool hasDynam
         totalChangingTime_(0.0),
         totalReplenishingTime_(0.0),
         totalImprovementTime_(0.0),
-        totalPruningTime_(0.0) {
+        totalPruningTime_(0.0),
+        totalChangingWallTime_(0.0),
+        totalReplenishingWallTime_(0.0),
+        totalImprovementWallTime_(0.0),
+        totalPruningWallTime_(0.0) {
     std::unique_ptr<State> initialState = model_->sampleAnInitState();
-    StateInfo *initInfo = solver_->getStatePool()->createOrGetInfo(*initialState);
+    StateInfo *initInfo = solver_->getStatePool()->createOrAdoptInfo(std::move(initialState));
+    // The actual history doesn't register its states, so they must be pinned instead.
+    solver_->getStatePool()->pinInfo(initInfo);
     HistoryEntry *newEntry = actualHistory_->addEntry();
     newEntry->stateInfo_ = initInfo;
 }
@@ -83,6 +89,18 @@ double Simulator::getTotalImprovementTime() const {
 double Simulator::getTotalPruningTime() const {
     return totalPruningTime_;
 }
+double Simulator::getTotalChangingWallTime() const {
+    return totalChangingWallTime_;
+}
+double Simulator::getTotalReplenishingWallTime() const {
+    return totalReplenishingWallTime_;
+}
+double Simulator::getTotalImprovementWallTime() const {
+    return totalImprovementWallTime_;
+}
+double Simulator::getTotalPruningWallTime() const {
+    return totalPruningWallTime_;
+}
 
 
 void Simulator::setChangeSequence(ChangeSequence sequence) {
@@ -159,12 +177,14 @@ bool Simulator::stepSimulation() {
     }
 
     double impSolTimeStart = tapir::clock_ms();
+    double impSolWallTimeStart = tapir::wall_clock_ms();
     if (currentBelief == solver_->getPolicy()->getRoot()) {
     	solver_->improvePolicy();
     } else {
     	solver_->improvePolicy(currentBelief);
     }
     totalImprovementTime_ += (tapir::clock_ms() - impSolTimeStart);
+    totalImprovementWallTime_ += (tapir::wall_clock_ms() - impSolWallTimeStart);
 
     if (options_->hasVerboseOutput) {
         std::stringstream newStream;
@@ -206,8 +226,10 @@ bool Simulator::stepSimulation() {
 
     // Replenish the particles.
     double replenishTimeStart = tapir::clock_ms();
+    double replenishWallTimeStart = tapir::wall_clock_ms();
     solver_->replenishChild(currentBelief, *result.action, *result.observation);
     totalReplenishingTime_ += tapir::clock_ms() - replenishTimeStart;
+    totalReplenishingWallTime_ += tapir::wall_clock_ms() - replenishWallTimeStart;
 
     // Update the agent's belief.
     agent_->updateBelief(*result.action, *result.observation);
@@ -216,9 +238,11 @@ bool Simulator::stepSimulation() {
     // If we're pruning on every step, we do it now.
     if (options_->pruneEveryStep) {
         double pruningTimeStart = tapir::clock_ms();
+        double pruningWallTimeStart = tapir::wall_clock_ms();
         long nSequencesDeleted = solver_->pruneSiblings(currentBelief);
         long pruningTime = tapir::clock_ms() - pruningTimeStart;
         totalPruningTime_ += pruningTime;
+        totalPruningWallTime_ += tapir::wall_clock_ms() - pruningWallTimeStart;
         if (options_->hasVerboseOutput) {
            cout << "Pruned " << nSequencesDeleted << " sequences in ";
            cout << pruningTime << "ms." << endl;
@@ -229,7 +253,9 @@ bool Simulator::stepSimulation() {
     currentEntry->observation_ = std::move(result.observation);
     currentEntry->immediateReward_ = result.reward;
     currentEntry->transitionParameters_ = std::move(result.transitionParameters);
-    StateInfo *nextInfo = solver_->getStatePool()->createOrGetInfo(*result.nextState);
+    StateInfo *nextInfo = solver_->getStatePool()->createOrAdoptInfo(
+            std::move(result.nextState));
+    solver_->getStatePool()->pinInfo(nextInfo);
     currentEntry = actualHistory_->addEntry();
     currentEntry->stateInfo_ = nextInfo;
 
@@ -259,13 +285,16 @@ bool Simulator::handleChanges(std::vector<std::unique_ptr<ModelChange>> const &c
     model_->applyChanges(changes, nullptr);
 
     double startTime = tapir::clock_ms();
+    double wallStartTime = tapir::wall_clock_ms();
     if (resetTree) {
         solverModel_->applyChanges(changes, nullptr);
     } else {
         // The model only needs to inform the solver of changes if we intend to keep the policy.
         solverModel_->applyChanges(changes, solver_);
     }
+    solver_->applyChangesToWorkers(changes);
     totalChangingTime_ += tapir::clock_ms() - startTime;
+    totalChangingWallTime_ += tapir::wall_clock_ms() - wallStartTime;
 
     // If the current state is deleted, the simulation is broken!
     StateInfo const *lastInfo = actualHistory_->getLastEntry()->getStateInfo();
@@ -290,6 +319,7 @@ bool Simulator::handleChanges(std::vector<std::unique_ptr<ModelChange>> const &c
 
     // Apply the changes, or simply reset the tree.
     startTime = tapir::clock_ms();
+    wallStartTime = tapir::wall_clock_ms();
     if (resetTree) {
         solver_->resetTree(agent_->getCurrentBelief());
         agent_->setCurrentBelief(solver_->getPolicy()->getRoot());
@@ -297,6 +327,7 @@ bool Simulator::handleChanges(std::vector<std::unique_ptr<ModelChange>> const &c
         solver_->applyChanges();
     }
     totalChangingTime_ += tapir::clock_ms() - startTime;
+    totalChangingWallTime_ += tapir::wall_clock_ms() - wallStartTime;
     return true;
 }
 
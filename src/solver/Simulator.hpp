@@ -66,17 +66,26 @@ public:
     /** Returns the number of steps taken in this simulation. */
     long getStepCount() const;
 
-    /** Returns the total time spent on changes to the solver's model and policy. */
+    /** Returns the total CPU time spent on changes to the solver's model and policy. */
     double getTotalChangingTime() const;
-    /** Returns the total time spent replenishing particles. */
+    /** Returns the total CPU time spent replenishing particles. */
     double getTotalReplenishingTime() const;
-    /** Returns the total time spent on straight improvements to the policy (i.e. generating new
-     * histories.
+    /** Returns the total CPU time spent on straight improvements to the policy (i.e. generating
+     * new histories); this includes the CPU time of every search thread.
      */
     double getTotalImprovementTime() const;
-    /** Returns the total time spent on pruning the tree. */
+    /** Returns the total CPU time spent on pruning the tree. */
     double getTotalPruningTime() const;
 
+    /** Returns the total wall-clock time spent on changes to the solver's model and policy. */
+    double getTotalChangingWallTime() const;
+    /** Returns the total wall-clock time spent replenishing particles. */
+    double getTotalReplenishingWallTime() const;
+    /** Returns the total wall-clock time spent on straight improvements to the policy. */
+    double getTotalImprovementWallTime() const;
+    /** Returns the total wall-clock time spent on pruning the tree. */
+    double getTotalPruningWallTime() const;
+
     /** Sets a sequence of changes to be used for this simulation. */
     void setChangeSequence(ChangeSequence sequence);
     /** Loads a sequence of changes from a file at the given path. */
@@ -130,14 +139,23 @@ private:
     /** The actual history of the simulation. */
     std::unique_ptr<HistorySequence> actualHistory_;
 
-    /** The total time spent on changes to the solver's model and policy. */
+    /** The total CPU time spent on changes to the solver's model and policy. */
     double totalChangingTime_;
-    /** The total time spent on replenishing particles. */
+    /** The total CPU time spent on replenishing particles. */
     double totalReplenishingTime_;
-    /** The total time spent on improving the policy, via new histories. */
+    /** The total CPU time spent on improving the policy, via new histories. */
     double totalImprovementTime_;
-    /** The total time spent on pruning the tree. */
+    /** The total CPU time spent on pruning the tree. */
     double totalPruningTime_;
+
+    /** The total wall-clock time spent on changes to the solver's model and policy. */
+    double totalChangingWallTime_;
+    /** The total wall-clock time spent on replenishing particles. */
+    double totalReplenishingWallTime_;
+    /** The total wall-clock time spent on improving the policy, via new histories. */
+    double totalImprovementWallTime_;
+    /** The total wall-clock time spent on pruning the tree. */
+    double totalPruningWallTime_;
 };
 } /* namespace solver */
 
@@ -0,0 +1,214 @@
+/** @file SlabAllocator.cpp
+ *
+ * Contains the implementation of the SlabAllocator and SlabAllocated classes.
+ */
+#include "solver/SlabAllocator.hpp"
+
+#include <cstddef>                      // for size_t
+
+#include <mutex>
+#include <new>                          // for operator new, operator delete
+
+#include "global.hpp"
+
+namespace solver {
+/** A slab of memory, which starts with this header and is followed by its slots. Each slot
+ * starts with a header holding a pointer to its slab, or nullptr if it was allocated on the heap.
+ */
+struct SlabAllocator::Slab {
+    /** The pool this slab belongs to. */
+    Pool *pool;
+    /** The number of slots that are in use. */
+    long nLive;
+    /** The number of slots that have ever been handed out. */
+    long nBumped;
+    /** A linked list of the slots that have been freed. */
+    void *freeList;
+    /** The previous and next slabs with free slots. */
+    Slab *previous, *next;
+    /** True iff this slab is in its pool's list of slabs with free slots. */
+    bool isAvailable;
+};
+
+namespace {
+/** The size of the header at the start of every slot. */
+std::size_t const SLOT_HEADER_SIZE = SlabAllocator::GRANULARITY;
+
+/** Rounds the given size up to a multiple of SlabAllocator::GRANULARITY. */
+std::size_t round_up(std::size_t size) {
+    return ((size + SlabAllocator::GRANULARITY - 1) / SlabAllocator::GRANULARITY
+            * SlabAllocator::GRANULARITY);
+}
+} /* namespace */
+
+SlabAllocator::Pool::Pool() :
+        mutex(),
+        slotSize(0),
+        slotsPerSlab(0),
+        available(nullptr),
+        nAvailable(0),
+        nSlabs(0) {
+}
+
+SlabAllocator::SlabAllocator() :
+        pools_(new Pool[MAX_OBJECT_SIZE / GRANULARITY]) {
+    for (std::size_t i = 0; i < MAX_OBJECT_SIZE / GRANULARITY; i++) {
+        pools_[i].slotSize = SLOT_HEADER_SIZE + (i + 1) * GRANULARITY;
+        pools_[i].slotsPerSlab = (SLAB_SIZE - round_up(sizeof(Slab))) / pools_[i].slotSize;
+    }
+}
+
+SlabAllocator::~SlabAllocator() {
+    for (std::size_t i = 0; i < MAX_OBJECT_SIZE / GRANULARITY; i++) {
+        Pool &pool = pools_[i];
+        if (pool.nAvailable != pool.nSlabs) {
+            // Full slabs aren't kept in any list, so there's no way to free them.
+            debug::show_message("ERROR: Destroying a SlabAllocator that still has live objects!");
+        }
+        while (pool.available != nullptr) {
+            Slab *slab = pool.available;
+            pool.available = slab->next;
+            ::operator delete(slab);
+        }
+    }
+}
+
+void *SlabAllocator::allocate(SlabAllocator *allocator, std::size_t size) {
+    if (allocator == nullptr || size > MAX_OBJECT_SIZE) {
+        void *slot = ::operator new(SLOT_HEADER_SIZE + size);
+        *static_cast<Slab **>(slot) = nullptr;
+        return static_cast<char *>(slot) + SLOT_HEADER_SIZE;
+    }
+
+    Pool &pool = allocator->pools_[size == 0 ? 0 : (size - 1) / GRANULARITY];
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    Slab *slab = pool.available;
+    if (slab == nullptr) {
+        slab = createSlab(pool);
+    }
+
+    void *slot;
+    if (slab->freeList != nullptr) {
+        slot = slab->freeList;
+        slab->freeList = *static_cast<void **>(slot);
+    } else {
+        slot = (reinterpret_cast<char *>(slab) + round_up(sizeof(Slab))
+                + slab->nBumped * pool.slotSize);
+        slab->nBumped++;
+    }
+    slab->nLive++;
+    if (slab->nLive == pool.slotsPerSlab) {
+        unlinkAvailable(slab);
+    }
+
+    *static_cast<Slab **>(slot) = slab;
+    return static_cast<char *>(slot) + SLOT_HEADER_SIZE;
+}
+
+void SlabAllocator::deallocate(void *pointer) {
+    if (pointer == nullptr) {
+        return;
+    }
+    void *slot = static_cast<char *>(pointer) - SLOT_HEADER_SIZE;
+    Slab *slab = *static_cast<Slab **>(slot);
+    if (slab == nullptr) {
+        ::operator delete(slot);
+        return;
+    }
+
+    Pool &pool = *slab->pool;
+    std::lock_guard<std::mutex> lock(pool.mutex);
+    *static_cast<void **>(slot) = slab->freeList;
+    slab->freeList = slot;
+    slab->nLive--;
+    if (!slab->isAvailable) {
+        linkAvailable(slab);
+    }
+    if (slab->nLive == 0 && pool.nAvailable > 1) {
+        // The whole slab is free, and there's another one to use instead.
+        unlinkAvailable(slab);
+        pool.nSlabs--;
+        ::operator delete(slab);
+    }
+}
+
+long SlabAllocator::getNumberOfSlabs() const {
+    long nSlabs = 0;
+    for (std::size_t i = 0; i < MAX_OBJECT_SIZE / GRANULARITY; i++) {
+        std::lock_guard<std::mutex> lock(pools_[i].mutex);
+        nSlabs += pools_[i].nSlabs;
+    }
+    return nSlabs;
+}
+
+/* ============================ PRIVATE ============================ */
+
+
+SlabAllocator::Slab *SlabAllocator::createSlab(Pool &pool) {
+    Slab *slab = static_cast<Slab *>(::operator new(SLAB_SIZE));
+    slab->pool = &pool;
+    slab->nLive = 0;
+    slab->nBumped = 0;
+    slab->freeList = nullptr;
+    slab->previous = nullptr;
+    slab->next = nullptr;
+    slab->isAvailable = false;
+    pool.nSlabs++;
+    linkAvailable(slab);
+    return slab;
+}
+
+void SlabAllocator::linkAvailable(Slab *slab) {
+    Pool &pool = *slab->pool;
+    slab->previous = nullptr;
+    slab->next = pool.available;
+    if (pool.available != nullptr) {
+        pool.available->previous = slab;
+    }
+    pool.available = slab;
+    pool.nAvailable++;
+    slab->isAvailable = true;
+}
+
+void SlabAllocator::unlinkAvailable(Slab *slab) {
+    Pool &pool = *slab->pool;
+    if (slab->previous != nullptr) {
+        slab->previous->next = slab->next;
+    } else {
+        pool.available = slab->next;
+    }
+    if (slab->next != nullptr) {
+        slab->next->previous = slab->previous;
+    }
+    slab->previous = nullptr;
+    slab->next = nullptr;
+    pool.nAvailable--;
+    slab->isAvailable = false;
+}
+
+/* ------------------------- SlabAllocated ------------------------- */
+void *SlabAllocated::operator new(std::size_t size) {
+    return SlabAllocator::allocate(nullptr, size);
+}
+void *SlabAllocated::operator new(std::size_t size, SlabAllocator *allocator) {
+    return SlabAllocator::allocate(allocator, size);
+}
+void *SlabAllocated::operator new[](std::size_t size) {
+    return SlabAllocator::allocate(nullptr, size);
+}
+void *SlabAllocated::operator new[](std::size_t size, SlabAllocator *allocator) {
+    return SlabAllocator::allocate(allocator, size);
+}
+void SlabAllocated::operator delete(void *pointer) {
+    SlabAllocator::deallocate(pointer);
+}
+void SlabAllocated::operator delete(void *pointer, SlabAllocator */*allocator*/) {
+    SlabAllocator::deallocate(pointer);
+}
+void SlabAllocated::operator delete[](void *pointer) {
+    SlabAllocator::deallocate(pointer);
+}
+void SlabAllocated::operator delete[](void *pointer, SlabAllocator */*allocator*/) {
+    SlabAllocator::deallocate(pointer);
+}
+} /* namespace solver */
@@ -0,0 +1,133 @@
+/** @file SlabAllocator.hpp
+ *
+ * Contains the SlabAllocator class, which allocates the nodes of a belief tree from large slabs
+ * of memory, and the SlabAllocated base class for the objects it can allocate.
+ */
+#ifndef SOLVER_SLABALLOCATOR_HPP_
+#define SOLVER_SLABALLOCATOR_HPP_
+
+#include <cstddef>                      // for size_t
+
+#include <memory>                       // for unique_ptr
+#include <mutex>
+#include <utility>                      // for forward
+
+#include "global.hpp"
+
+namespace solver {
+/** Allocates small objects from slabs of memory, each of which holds objects of a single size.
+ *
+ * Objects of similar sizes (rounded up to a multiple of GRANULARITY bytes) share slabs, so
+ * the nodes of a belief tree end up close together in memory, and building the tree rarely
+ * needs to call malloc. A slab is returned to the heap as soon as all of its objects have been
+ * freed (apart from one spare slab for each size, which is kept for reuse); objects larger than
+ * MAX_OBJECT_SIZE are simply allocated on the heap.
+ *
+ * Each object is preceded by a small header recording which slab it came from, so it can be
+ * freed via deallocate() without knowing which allocator it came from. The allocator must
+ * outlive every object allocated from it.
+ *
+ * allocate() and deallocate() can safely be called from several threads at once.
+ *
+ * The usual way to use this class is via the SlabAllocated base class, e.g. via
+ * allocate_unique().
+ */
+class SlabAllocator {
+  public:
+    /** The size of each slab, in bytes. */
+    static std::size_t const SLAB_SIZE = 64 * 1024;
+    /** Object sizes are rounded up to a multiple of this many bytes. */
+    static std::size_t const GRANULARITY = 16;
+    /** The largest object size that will be allocated from a slab. */
+    static std::size_t const MAX_OBJECT_SIZE = 4096;
+
+    /** Constructs an allocator with no slabs. */
+    SlabAllocator();
+    ~SlabAllocator();
+    _NO_COPY_OR_MOVE(SlabAllocator);
+
+    /** Returns memory for an object of the given size; a null allocator uses the heap. */
+    static void *allocate(SlabAllocator *allocator, std::size_t size);
+    /** Frees the memory for an object allocated via allocate(). */
+    static void deallocate(void *pointer);
+
+    /** Returns the number of slabs currently held by this allocator. */
+    long getNumberOfSlabs() const;
+
+  private:
+    struct Slab;
+    /** The slabs for objects of a single size. */
+    struct Pool {
+        Pool();
+        _NO_COPY_OR_MOVE(Pool);
+        /** Guards this pool and its slabs. */
+        std::mutex mutex;
+        /** The size of each slot, including the header. */
+        std::size_t slotSize;
+        /** The number of slots in each slab. */
+        long slotsPerSlab;
+        /** The first of the slabs that have free slots. */
+        Slab *available;
+        /** The number of slabs that have free slots. */
+        long nAvailable;
+        /** The total number of slabs. */
+        long nSlabs;
+    };
+
+    /** Makes a new slab for the given pool, which must be locked. */
+    static Slab *createSlab(Pool &pool);
+    /** Adds the given slab to the front of its pool's list of slabs with free slots. */
+    static void linkAvailable(Slab *slab);
+    /** Removes the given slab from its pool's list of slabs with free slots. */
+    static void unlinkAvailable(Slab *slab);
+
+    /** The pools, one for each multiple of GRANULARITY up to MAX_OBJECT_SIZE. */
+    std::unique_ptr<Pool[]> pools_;
+};
+
+/** A base class for objects that can be allocated from a SlabAllocator, via
+ * new (allocator) T(...) or allocate_unique(); they can still be allocated on the heap via a
+ * plain new (or a null allocator), and either way are freed by a plain delete.
+ */
+class SlabAllocated {
+  public:
+    /** Allocates an object on the heap. */
+    static void *operator new(std::size_t size);
+    /** Allocates an object from the given allocator (nullptr => the heap). */
+    static void *operator new(std::size_t size, SlabAllocator *allocator);
+    /** Allocates an array on the heap. */
+    static void *operator new[](std::size_t size);
+    /** Allocates an array from the given allocator (nullptr => the heap). */
+    static void *operator new[](std::size_t size, SlabAllocator *allocator);
+    /** Frees an object, wherever it was allocated. */
+    static void operator delete(void *pointer);
+    /** Frees an object whose constructor threw an exception. */
+    static void operator delete(void *pointer, SlabAllocator *allocator);
+    /** Frees an array, wherever it was allocated. */
+    static void operator delete[](void *pointer);
+    /** Frees an array whose constructor threw an exception. */
+    static void operator delete[](void *pointer, SlabAllocator *allocator);
+
+  protected:
+    SlabAllocated() = default;
+    ~SlabAllocated() = default;
+};
+
+/** Makes a new T (a subclass of SlabAllocated) in the given allocator, and returns a unique_ptr
+ * that owns it.
+ */
+template<typename T, typename... Args>
+std::unique_ptr<T> allocate_unique(SlabAllocator *allocator, Args&&... args) {
+    return std::unique_ptr<T>(new (allocator) T(std::forward<Args>(args)...));
+}
+
+/** Makes a new value-initialized array of T (a subclass of SlabAllocated) in the given allocator,
+ * and returns a unique_ptr that owns it.
+ */
+template<typename T>
+std::unique_ptr<T[]> allocate_unique_array(SlabAllocator *allocator, std::size_t size) {
+    return std::unique_ptr<T[]>(new (allocator) T[size]());
+}
+} /* namespace solver */
+
+#endif /* SOLVER_SLABALLOCATOR_HPP_ */
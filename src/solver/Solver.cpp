@@ -6,13 +6,16 @@
 
 #include <cmath>                        // for pow, exp
 #include <cstdio>
+#include <cstdlib>                      // for abs
 
 #include <algorithm>                    // for max
 #include <iostream>                     // for operator<<, ostream, basic_ostream, endl, basic_ostream<>::__ostream_type, cout
 #include <limits>
 #include <memory>                       // for unique_ptr
+#include <numeric>                      // for iota
 #include <random>                       // for uniform_int_distribution, bernoulli_distribution
 #include <set>                          // for set, _Rb_tree_const_iterator, set<>::iterator
+#include <thread>
 #include <tuple>                        // for tie, tuple
 #include <type_traits>                  // for remove_reference<>::type
 #include <utility>                      // for move, make_pair, pair
@@ -21,6 +24,7 @@
 #include "global.hpp"                     // for RandomGenerator
 
 #include "solver/abstract-problem/Action.hpp"                   // for Action
+#include "solver/abstract-problem/HistoricalData.hpp"
 #include "solver/abstract-problem/Model.hpp"                    // for Model::StepResult, Model
 #include "solver/abstract-problem/ModelChange.hpp"                    // for Model::StepResult, Model
 #include "solver/abstract-problem/Observation.hpp"              // for Observation
@@ -38,6 +42,7 @@
 
 #include "solver/search/SearchStatus.hpp"
 #include "solver/search/search_interface.hpp"
+#include "solver/search/steppers/default_rollout.hpp"
 
 #include "solver/serialization/Serializer.hpp"               // for Serializer
 
@@ -57,6 +62,26 @@ using std::cout;
 using std::endl;
 
 namespace solver {
+namespace {
+/** The solver whose tree is being searched by the current thread, if this is a tree-parallel
+ * search thread.
+ */
+thread_local Solver const *threadSolver = nullptr;
+/** The model to be used by the current thread for threadSolver. */
+thread_local Model *threadModel = nullptr;
+/** The nodes queued for backup by the current thread, if it is revising a batch of histories
+ * in parallel; these are merged into the backup queue once every batch has finished.
+ */
+thread_local std::vector<BeliefNode *> *threadBackupQueue = nullptr;
+
+/** Returns the number of searches to be done by the given thread, when the given maximum number
+ * of searches is split evenly between the given number of threads.
+ */
+long get_search_quota(long maxNumSearches, long nThreads, long threadNo) {
+    return maxNumSearches / nThreads + (threadNo < maxNumSearches % nThreads ? 1 : 0);
+}
+} /* namespace */
+
 Solver::Solver(std::unique_ptr<Model> model) :
             model_(std::move(model)),
             options_(model_->getOptions()),
@@ -71,12 +96,26 @@ Solver::Solver(std::unique_ptr<Model> model) :
             recommendationStrategy_(nullptr),
             estimationStrategy_(nullptr),
             nodesToBackup_(),
+            nodesWithResiduals_(),
+            backupMutex_(),
+            searchDeadline_(),
+            searchStopToken_(nullptr),
             changeRoot_(nullptr),
-            isAffectedMap_() {
+            staleSequences_(),
+            canCreateWorkers_(true),
+            workerRandGens_(),
+            workers_(),
+            ownRolloutWorkerPool_(std::make_unique<RolloutWorkerPool>(this,
+                    std::max(options_->nThreads - 1, 0L))),
+            rolloutWorkerPool_(ownRolloutWorkerPool_.get()),
+            mergedStatistics_(),
+            prunedParents_(),
+            reclaimer_() {
 }
 
-// Default destructor
+// The reclaimer must finish before the tree and the histories are destroyed.
 Solver::~Solver() {
+    reclaimer_.reclaimAll();
 }
 
 /* ------------------ Simple getters. ------------------- */
@@ -87,6 +126,10 @@ StatePool *Solver::getStatePool() const {
     return statePool_.get();
 }
 Model *Solver::getModel() const {
+    // Tree-parallel search threads each have their own model.
+    if (threadSolver == this) {
+        return threadModel;
+    }
     return model_.get();
 }
 Options const *Solver::getOptions() const {
@@ -107,6 +150,12 @@ SelectRecommendedActionStrategy* Solver::getRecommendationStrategy() const {
 Serializer *Solver::getSerializer() const {
     return serializer_.get();
 }
+tapir::Deadline const &Solver::getSearchDeadline() const {
+    return searchDeadline_;
+}
+RolloutWorkerPool *Solver::getRolloutWorkerPool() const {
+    return rolloutWorkerPool_;
+}
 
 /* ------------------ Initialization methods ------------------- */
 void Solver::initializeEmpty() {
@@ -123,8 +172,18 @@ void Solver::initializeEmpty() {
 
 /* ------------------- Policy mutators ------------------- */
 void Solver::improvePolicy(BeliefNode *startNode, long numberOfHistories, long maximumDepth,
-        double timeout) {
-    double startTime = tapir::clock_ms();
+        double timeout, tapir::StopToken const *stopToken) {
+    double startTime = tapir::wall_clock_ms();
+    long actualNumHistories = searchFrom(startNode, numberOfHistories, maximumDepth, timeout,
+            stopToken);
+    double totalTimeTaken = tapir::wall_clock_ms() - startTime;
+    if (options_->hasVerboseOutput) {
+        cout << actualNumHistories << " histories in " << totalTimeTaken << "ms." << endl;
+    }
+}
+
+long Solver::searchFrom(BeliefNode *startNode, long numberOfHistories, long maximumDepth,
+        double timeout, tapir::StopToken const *stopToken) {
     if (numberOfHistories < 0) {
         numberOfHistories = options_->historiesPerStep;
     }
@@ -144,23 +203,63 @@ void Solver::improvePolicy(BeliefNode *startNode, long numberOfHistories, long m
         timeout = std::numeric_limits<double>::infinity();
     }
 
+    // The statistics merged in by the last root-parallel search have no histories behind them.
+    removeMergedStatistics();
+
+    // The particles used by the search must not be changing underneath it.
+    finishReclaimingAbove(startNode == nullptr ? policy_->getRoot() : startNode);
+
+    // Revise the histories left stale by the last changes, so that the search can use them.
+    reviseStaleHistories(startNode, options_->changeTimeout);
+
     // Retrieve the sampling function to use.
     std::function<StateInfo *()> sampler = getStateSampler(startNode);
     if (sampler == nullptr) {
-        return;
+        return 0;
     }
 
     // Null start node => use the root.
+    BeliefNode *samplingNode = startNode;
     if (startNode == nullptr) {
         startNode = policy_->getRoot();
     }
 
-    long actualNumHistories = multipleSearches(startNode,  sampler, maximumDepth, numberOfHistories,
-            startTime + timeout);
-    double totalTimeTaken = tapir::clock_ms() - startTime;
-    if (options_->hasVerboseOutput) {
-        cout << actualNumHistories << " histories in " << totalTimeTaken << "ms." << endl;
+    // The workers are made ready before the time starts, since making them can take a while.
+    bool isParallel = (options_->nThreads > 1 && canCreateWorkers_
+            && initializeWorkers(options_->nThreads - 1));
+    if (isParallel && !options_->useTreeParallelSearch) {
+        initializeWorkerRoots(startNode);
+    }
+
+    long actualNumHistories;
+    searchDeadline_ = tapir::Deadline(timeout);
+    searchStopToken_ = stopToken;
+    if (isParallel) {
+        if (options_->useTreeParallelSearch) {
+            actualNumHistories = treeParallelSearches(startNode, samplingNode, sampler,
+                    maximumDepth, numberOfHistories);
+        } else {
+            actualNumHistories = parallelSearches(startNode, sampler, maximumDepth,
+                    numberOfHistories);
+        }
+    } else {
+        actualNumHistories = multipleSearches(startNode, sampler, maximumDepth, numberOfHistories);
+    }
+    // The recommended action is chosen from values that have been backed up exactly.
+    flushBackup();
+    // Other searches (e.g. for history correction) must not be cut short.
+    searchDeadline_ = tapir::Deadline();
+    searchStopToken_ = nullptr;
+    return actualNumHistories;
+}
+
+std::unique_ptr<Action> Solver::getRecommendedActionSnapshot(BeliefNode const *node) const {
+    if (node == nullptr) {
+        node = policy_->getRoot();
     }
+    // The searching threads only change a node's statistics while holding its mutex.
+    std::lock_guard<std::mutex> lock(node->getMutex());
+    return node->getRecommendedAction();
 }
 
 BeliefNode *Solver::replenishChild(BeliefNode *currNode, Action const &action,
@@ -168,6 +267,7 @@ BeliefNode *Solver::replenishChild(BeliefNode *currNode, Action const &action,
     if (minParticleCount < 0) {
         minParticleCount = options_->minParticleCount;
     }
+    finishReclaimingAbove(currNode);
     BeliefNode *nextNode = currNode->createOrGetChild(action, obs);
     long particleCount = nextNode->getNumberOfParticles();
     long deficit = minParticleCount - particleCount;
@@ -204,7 +304,7 @@ BeliefNode *Solver::replenishChild(BeliefNode *currNode, Action const &action,
     }
 
     for (std::unique_ptr<State> &uniqueStatePtr : nextParticles) {
-        StateInfo *stateInfo = statePool_->createOrGetInfo(*uniqueStatePtr);
+        StateInfo *stateInfo = statePool_->createOrAdoptInfo(std::move(uniqueStatePtr));
 
         // Create a new history sequence and entry for the new particle.
         HistorySequence *histSeq = histories_->createSequence();
@@ -219,9 +319,15 @@ BeliefNode *Solver::replenishChild(BeliefNode *currNode, Action const &action,
 }
 
 void Solver::resetTree(BeliefNode *newRoot) {
+    // Free the states that were only used by trees that have already been reclaimed.
+    finishReclaiming();
+    statePool_->collectGarbage();
+    removeMergedStatistics();
+
     changeRoot_ = nullptr;
-    isAffectedMap_.clear();
+    staleSequences_.clear();
     nodesToBackup_.clear();
+    nodesWithResiduals_.clear();
 
     std::vector<StateInfo *> allParticles;
 
@@ -238,16 +344,15 @@ void Solver::resetTree(BeliefNode *newRoot) {
     if (oldData != nullptr) {
         newData = oldData->copy();
     }
-    newRoot = policy_->reset();
+    // The old tree and all of the histories are handed over whole, and freed in the background.
+    std::vector<BeliefNode *> oldNodes = policy_->releaseAllNodes();
+    std::unique_ptr<BeliefNode> oldRoot;
+    newRoot = policy_->reset(oldRoot);
+    reclaimer_.add(std::move(oldRoot), std::move(oldNodes));
+    reclaimer_.add(histories_->releaseAll());
     newRoot->data_ = std::move(newData);
     newRoot->setMapping(actionPool_->createActionMapping(newRoot));
     estimationStrategy_->setValueEstimator(this, newRoot);
-    histories_->reset();
-
-    // Clear the stored history entries for each StateInfo in the pool.
-    for (std::unique_ptr<StateInfo> const &info : statePool_->statesByIndex_) {
-        info->usedInHistoryEntries_.clear();
-    }
 
     // Now fill the re-created belief node with the particles from the old one.
     for (StateInfo *info : allParticles) {
@@ -257,21 +362,30 @@ void Solver::resetTree(BeliefNode *newRoot) {
         histEntry->registerState(info);
         histEntry->registerNode(newRoot);
     }
+    reclaimer_.start();
 }
 
 long Solver::pruneSiblings(BeliefNode *node) {
+    // Free the states that were only used by subtrees that have already been reclaimed.
+    finishReclaiming();
+    statePool_->collectGarbage();
+    removeMergedStatistics();
+
     ObservationMappingEntry *entry = node->getParentEntry();
     if (entry == nullptr) {
         return 0;
     }
 
+    // Nothing in the pruned subtrees may be left in the backup queue.
+    flushBackup();
+
     long nSequencesDeleted = 0;
 
     // Prune siblings that share an action, but not an observation.
     ObservationMapping *obsMap = entry->getMapping();
     for (ObservationMappingEntry const *sibling : obsMap->getChildEntries()) {
         if (sibling != entry) {
-            nSequencesDeleted += pruneSubtree(sibling->getBeliefNode());
+            nSequencesDeleted += detachSubtree(sibling->getBeliefNode());
         }
     }
 
@@ -281,33 +395,33 @@ long Solver::pruneSiblings(BeliefNode *node) {
         if (actionSibling != actionEntry) {
             ObservationMapping *siblingObsMap = actionSibling->getActionNode()->getMapping();
             for (ObservationMappingEntry const *obsSibling : siblingObsMap->getChildEntries()) {
-                nSequencesDeleted += pruneSubtree(obsSibling->getBeliefNode());
+                nSequencesDeleted += detachSubtree(obsSibling->getBeliefNode());
             }
             // Now delete the action mapping entry.
-            actionMapping->deleteChild(actionSibling);
+            reclaimer_.add(actionMapping->deleteChild(actionSibling));
         }
     }
 
     // Backup the parent node so the value estimate remains OK.
     doBackup();
 
+    // The pruned subtrees are freed while the search carries on.
+    reclaimer_.start();
     return nSequencesDeleted;
 }
 
 long Solver::pruneSubtree(BeliefNode *root) {
-    // Delete all history sequences going into this subtree.
-    long nSequencesDeleted = 0;
-    for (HistoryEntry *entry : root->particles_) {
-        histories_->deleteSequence(entry->owningSequence_);
-        nSequencesDeleted++;
-    }
-
-    ObservationMappingEntry *entry = root->getParentEntry();
-    if (entry != nullptr) {
-        addNodeToBackup(root->getParentBelief());
-        entry->getMapping()->deleteChild(entry);
+    if (root->getParentEntry() == nullptr) {
+        return 0;
     }
+    finishReclaiming();
+    removeMergedStatistics();
+    // Nothing in the pruned subtree may be left in the backup queue.
+    flushBackup();
 
+    long nSequencesDeleted = detachSubtree(root);
+    doBackup();
+    reclaimer_.start();
     return nSequencesDeleted;
 }
 
@@ -320,61 +434,25 @@ void Solver::setChangeRoot(BeliefNode *changeRoot) {
     changeRoot_ = changeRoot;
 }
 
-bool Solver::isAffected(BeliefNode const *node) {
-    if (changeRoot_ == nullptr) {
-        // No change root => all nodes are affected.
-        return true;
-    }
-    if (node == changeRoot_) {
-        // Same node => must be affected.
-        return true;
-    }
-
-    long rootDepth = changeRoot_->getDepth();
-    if (node->getDepth() <= rootDepth) {
-        // Not below the root and not the root => can't be affected.
-        return false;
-    }
-
-    // If it's deeper, look it up in the mapping.
-    std::unordered_map<BeliefNode const *, bool>::iterator it = isAffectedMap_.find(node);
-    if (it != isAffectedMap_.end()) {
-        return it->second;
-    }
-
-    // We have to traverse the tree to see if it's a descendant.
-    std::vector<BeliefNode const *> ancestors;
-    bool isDescendedFromChangeRoot = false;
-    while (true) {
-        ancestors.push_back(node);
-        node = node->getParentBelief();
-        // If we hit the root, we must be descended from it.
-        if (node == changeRoot_) {
-            isDescendedFromChangeRoot = true;
-            break;
-        }
-        // If we reach the same depth without hitting the root, we aren't descended from it.
-        if (node->getDepth() == rootDepth) {
-            break;
-        }
+bool Solver::isAffected(BeliefNode const *node) const {
+    // No change root => all nodes are affected.
+    return changeRoot_ == nullptr || node->isInSubtreeOf(changeRoot_);
+}
 
-        it = isAffectedMap_.find(node);
-        // If we hit a node for which we know whether it's descended, we copy its state.
-        if (it != isAffectedMap_.end()) {
-            isDescendedFromChangeRoot = it->second;
-            break;
-        }
+void Solver::applyChangesToWorkers(std::vector<std::unique_ptr<ModelChange>> const &changes) {
+    for (std::unique_ptr<Solver> &worker : workers_) {
+        worker->model_->applyChanges(changes, nullptr);
     }
-
-    // Add ancestors to the mapping for efficient lookup later on.
-    for (BeliefNode const *ancestor : ancestors) {
-        isAffectedMap_[ancestor] = isDescendedFromChangeRoot;
+    if (ownRolloutWorkerPool_ != nullptr) {
+        ownRolloutWorkerPool_->applyChanges(changes);
     }
-
-    return isDescendedFromChangeRoot;
 }
 
 void Solver::applyChanges() {
+    // The sequences being reclaimed must be fully deregistered from their states first.
+    finishReclaiming();
+    removeMergedStatistics();
+
     std::unordered_set<HistorySequence *> affectedSequences;
     for (StateInfo *stateInfo : statePool_->getAffectedStates()) {
         if (changes::has_flags(stateInfo->changeFlags_, ChangeFlags::DELETED)) {
@@ -456,26 +534,72 @@ void Solver::applyChanges() {
         cout << histories_->getNumberOfSequences() << " histories!" << endl;
     }
 
-    // Delete and remove any sequences where the first state has been deleted.
-    std::unordered_set<HistorySequence *>::iterator it = affectedSequences.begin();
-    while (it != affectedSequences.end()) {
-        HistorySequence *sequence = *it;
+    // Delete and remove any sequences where the first state has been deleted. Deleting a sequence
+    // renumbers the last one, so they go in order of ID to keep the IDs repeatable.
+    std::vector<HistorySequence *> deletedSequences;
+    for (HistorySequence *sequence : affectedSequences) {
         if (changes::has_flags(sequence->getFirstEntry()->changeFlags_, ChangeFlags::DELETED)) {
-            it = affectedSequences.erase(it);
-            // Now we undo the sequence, and delete it entirely.
-            updateSequence(sequence, -1);
-            histories_->deleteSequence(sequence);
-        } else {
-            it++;
+            deletedSequences.push_back(sequence);
         }
     }
+    std::sort(deletedSequences.begin(), deletedSequences.end(),
+            [] (HistorySequence const *a, HistorySequence const *b) {
+                return a->getId() > b->getId();
+    });
+    for (HistorySequence *sequence : deletedSequences) {
+        affectedSequences.erase(sequence);
+        staleSequences_.erase(sequence);
+        // Now we undo the sequence, and delete it entirely.
+        updateSequence(sequence, -1);
+        histories_->deleteSequence(sequence);
+    }
 
     if (options_->hasVerboseOutput) {
         cout << "Deleted " << numAffected - affectedSequences.size() << " histories!" << endl;
     }
 
+    if (options_->changeTimeout > 0) {
+        // With a time limit, the sequences are only revised while there's time to spare.
+        for (HistorySequence *sequence : affectedSequences) {
+            BeliefNode *firstNode = sequence->getFirstEntry()->getAssociatedBeliefNode();
+            staleSequences_[sequence] = firstNode->getDepth() + sequence->startAffectedIdx_;
+        }
+        statePool_->resetAffectedStates();
+        reviseStaleHistories(changeRoot_, options_->changeTimeout);
+        // The deleted sequences must be backed up even if nothing was revised.
+        flushBackup();
+        return;
+    }
+
+    // With tree-parallel search, independent batches of histories are revised concurrently.
+    bool isParallel = (options_->nThreads > 1 && options_->useTreeParallelSearch
+            && canCreateWorkers_ && initializeWorkers(options_->nThreads - 1));
+    std::vector<HistorySequence *> sharedSequences;
+    std::vector<std::vector<HistorySequence *>> batches;
+    if (isParallel) {
+        partitionSequences(affectedSequences, sharedSequences, batches);
+        if (options_->hasVerboseOutput) {
+            cout << "Revising " << affectedSequences.size() - sharedSequences.size();
+            cout << " histories in " << batches.size() << " parallel batches." << endl;
+        }
+    }
+
     // Revise all of the histories.
-    historyCorrector_->reviseHistories(affectedSequences);
+    if (isParallel) {
+        // Any sequences left in a batch are incomplete, and will be extended by the search.
+        std::function<bool(HistorySequence *)> revise = [this] (HistorySequence *sequence) {
+            return !historyCorrector_->reviseSequence(sequence);
+        };
+        filterSequences(sharedSequences, revise);
+        runBatches(batches, revise);
+        affectedSequences.clear();
+        affectedSequences.insert(sharedSequences.begin(), sharedSequences.end());
+        for (std::vector<HistorySequence *> const &batch : batches) {
+            affectedSequences.insert(batch.begin(), batch.end());
+        }
+    } else {
+        historyCorrector_->reviseHistories(affectedSequences);
+    }
 
     if (options_->hasVerboseOutput) {
         cout << "Revision complete. Backing up..." << endl;
@@ -493,19 +617,201 @@ void Solver::applyChanges() {
     }
 
     // Extend and backup each sequence.
-    for (HistorySequence *sequence : affectedSequences) {
-        long maximumDepth = options_->maximumDepth;
-        if (options_->isAbsoluteHorizon) {
-            maximumDepth += sequence->getFirstEntry()->getAssociatedBeliefNode()->getDepth();
+    std::function<bool(HistorySequence *)> extend = [this] (HistorySequence *sequence) {
+        extendSequence(sequence);
+        return false;
+    };
+    if (isParallel) {
+        filterSequences(sharedSequences, extend);
+        runBatches(batches, extend);
+    } else {
+        for (HistorySequence *sequence : affectedSequences) {
+            extend(sequence);
         }
-        searchStrategy_->extendAndBackup(sequence, maximumDepth);
     }
 
     // Backup all the way to the root to keep the tree consistent.
+    flushBackup();
+}
+
+long Solver::reviseStaleHistories(BeliefNode *node, double timeout) {
+    if (staleSequences_.empty()) {
+        return 0;
+    }
+    // The reclaimer changes the IDs of the sequences as it releases them.
+    finishReclaiming();
+    removeMergedStatistics();
+    if (node == nullptr) {
+        node = policy_->getRoot();
+    }
+    if (timeout == 0) {
+        timeout = std::numeric_limits<double>::infinity();
+    }
+    tapir::Deadline deadline(timeout);
+
+    // Each sequence is ranked by how far its first change is from the node in depth, except that
+    // the sequences with stale particles in the node itself come first; ties are broken by ID so
+    // that the order is repeatable. A heap is used since usually only a few of them are revised.
+    typedef std::pair<std::pair<long, long>, HistorySequence *> RankedSequence;
+    std::vector<RankedSequence> rankedSequences;
+    long depth = node->getDepth();
+    for (auto const &staleSequence : staleSequences_) {
+        HistorySequence *sequence = staleSequence.first;
+        long distance = 1 + std::abs(staleSequence.second - depth);
+        rankedSequences.emplace_back(std::make_pair(distance, sequence->getId()), sequence);
+    }
+    for (HistoryEntry *entry : node->particles_) {
+        HistorySequence *sequence = entry->owningSequence_;
+        if (entry->entryId_ >= sequence->startAffectedIdx_) {
+            rankedSequences.emplace_back(std::make_pair(0L, sequence->getId()), sequence);
+        }
+    }
+    std::greater<RankedSequence> isRankedLower;
+    std::make_heap(rankedSequences.begin(), rankedSequences.end(), isRankedLower);
+
+    // At least one sequence is revised each time, so that the revision always makes progress.
+    std::vector<HistorySequence *> incompleteSequences;
+    long nRevised = 0;
+    while (!rankedSequences.empty() && (nRevised == 0 || !deadline.hasExpired())) {
+        std::pop_heap(rankedSequences.begin(), rankedSequences.end(), isRankedLower);
+        HistorySequence *sequence = rankedSequences.back().second;
+        rankedSequences.pop_back();
+        // A sequence with stale particles in the node is listed twice.
+        if (staleSequences_.erase(sequence) == 0) {
+            continue;
+        }
+        if (!historyCorrector_->reviseSequence(sequence)) {
+            incompleteSequences.push_back(sequence);
+        }
+        nRevised++;
+    }
+    doBackup();
+
+    // Sequences that hit illegal actions are extended in the same way as by applyChanges().
+    for (HistorySequence *sequence : incompleteSequences) {
+        extendSequence(sequence);
+    }
     doBackup();
 
-    // Clear the map of affected nodes, to make sure it doesn't keep nodes that may be deleted.
-    isAffectedMap_.clear();
+    if (options_->hasVerboseOutput) {
+        cout << "Revised " << nRevised << " histories; " << staleSequences_.size();
+        cout << " are still stale." << endl;
+    }
+    return nRevised;
+}
+
+long Solver::getNumberOfStaleHistories() const {
+    return staleSequences_.size();
+}
+
+void Solver::extendSequence(HistorySequence *sequence) {
+    long maximumDepth = options_->maximumDepth;
+    if (options_->isAbsoluteHorizon) {
+        maximumDepth += sequence->getFirstEntry()->getAssociatedBeliefNode()->getDepth();
+    }
+    searchStrategy_->extendAndBackup(sequence, maximumDepth);
+}
+
+void Solver::partitionSequences(std::unordered_set<HistorySequence *> const &sequences,
+        std::vector<HistorySequence *> &sharedSequences,
+        std::vector<std::vector<HistorySequence *>> &batches) {
+    // Sort by ID so that the batches don't depend on the order of the set.
+    std::vector<HistorySequence *> sortedSequences(sequences.begin(), sequences.end());
+    std::sort(sortedSequences.begin(), sortedSequences.end(),
+            [] (HistorySequence const *a, HistorySequence const *b) {
+                return a->getId() < b->getId();
+    });
+
+    // Revising a sequence only changes the subtree of the belief where the changes start, and the
+    // parent of that belief; sequences whose changes start two or more levels below the change
+    // root are grouped by the child of the change root above them, so that the groups touch
+    // disjoint parts of the tree.
+    long groupDepth = (changeRoot_ == nullptr ? policy_->getRoot() : changeRoot_)->getDepth() + 1;
+    std::unordered_map<BeliefNode const *, std::size_t> groupIndices;
+    std::vector<std::vector<HistorySequence *>> groups;
+    for (HistorySequence *sequence : sortedSequences) {
+        BeliefNode const *node = nullptr;
+        if (sequence->startAffectedIdx_ <= sequence->endAffectedIdx_) {
+            node = sequence->getEntry(sequence->startAffectedIdx_)->getAssociatedBeliefNode();
+        }
+        if (node == nullptr || node->getDepth() <= groupDepth) {
+            sharedSequences.push_back(sequence);
+            continue;
+        }
+        while (node->getDepth() > groupDepth) {
+            node = node->getParentBelief();
+        }
+        auto result = groupIndices.emplace(node, groups.size());
+        if (result.second) {
+            groups.emplace_back();
+        }
+        groups[result.first->second].push_back(sequence);
+    }
+
+    // Largest groups first, each to the batch with the fewest sequences so far.
+    std::vector<std::size_t> groupOrder(groups.size());
+    std::iota(groupOrder.begin(), groupOrder.end(), 0);
+    std::stable_sort(groupOrder.begin(), groupOrder.end(), [&groups] (std::size_t a, std::size_t b) {
+        return groups[a].size() > groups[b].size();
+    });
+    batches.assign(std::min<std::size_t>(options_->nThreads, groups.size()), {});
+    for (std::size_t groupIndex : groupOrder) {
+        std::vector<HistorySequence *> *smallestBatch = &batches[0];
+        for (std::vector<HistorySequence *> &batch : batches) {
+            if (batch.size() < smallestBatch->size()) {
+                smallestBatch = &batch;
+            }
+        }
+        smallestBatch->insert(smallestBatch->end(), groups[groupIndex].begin(),
+                groups[groupIndex].end());
+    }
+}
+
+void Solver::filterSequences(std::vector<HistorySequence *> &sequences,
+        std::function<bool(HistorySequence *)> function) {
+    std::vector<HistorySequence *> remainingSequences;
+    for (HistorySequence *sequence : sequences) {
+        if (function(sequence)) {
+            remainingSequences.push_back(sequence);
+        }
+    }
+    sequences = std::move(remainingSequences);
+}
+
+void Solver::runBatches(std::vector<std::vector<HistorySequence *>> &batches,
+        std::function<bool(HistorySequence *)> function) {
+    std::vector<std::vector<BeliefNode *>> backupQueues(batches.size());
+    std::vector<std::thread> threads;
+    // The first batch is run on this thread, and each of the others on a worker thread.
+    for (std::size_t i = 1; i < batches.size(); i++) {
+        Model *workerModel = workers_[i - 1]->getModel();
+        std::vector<HistorySequence *> *batch = &batches[i];
+        std::vector<BeliefNode *> *backupQueue = &backupQueues[i];
+        threads.emplace_back([=]() {
+            threadSolver = this;
+            threadModel = workerModel;
+            threadBackupQueue = backupQueue;
+            filterSequences(*batch, function);
+            threadSolver = nullptr;
+            threadModel = nullptr;
+            threadBackupQueue = nullptr;
+        });
+    }
+    if (!batches.empty()) {
+        threadBackupQueue = &backupQueues[0];
+        filterSequences(batches[0], function);
+        threadBackupQueue = nullptr;
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+
+    // Merging the queues in batch order keeps the backup independent of the thread timing.
+    for (std::vector<BeliefNode *> const &backupQueue : backupQueues) {
+        for (BeliefNode *node : backupQueue) {
+            queueNodeForBackup(node);
+        }
+    }
 }
 
 /* ------------------ Display methods  ------------------- */
@@ -518,11 +824,11 @@ void Solver::printBelief(BeliefNode *belief, std::ostream &os) {
     typedef std::pair<solver::ActionMappingEntry const *, std::string> EntryWithMarker;
     std::multimap<double, EntryWithMarker> actionValues;
     size_t longestMarker = 0;
-    for (solver::ActionMappingEntry const *entry : belief->getMapping()->getVisitedEntries()) {
-    	EntryWithMarker entryWithMarker(entry, entry->getMarker() );
-    	longestMarker = std::max(longestMarker, entryWithMarker.second.length());
+    belief->getMapping()->forEachVisitedEntry([&] (solver::ActionMappingEntry const *entry) {
+        EntryWithMarker entryWithMarker(entry, entry->getMarker());
+        longestMarker = std::max(longestMarker, entryWithMarker.second.length());
         actionValues.insert(std::make_pair(entry->getMeanQValue(), std::move(entryWithMarker)));
-    }
+    });
     for (auto it = actionValues.rbegin(); it != actionValues.rend(); it++) {
         tapir::print_double(it->first, os, 8, 2, std::ios_base::fixed | std::ios_base::showpos);
         os << ": ";
@@ -540,33 +846,24 @@ void Solver::printTree(std::ostream &/*os*/) {
 
 /* -------------- Management of deferred backpropagation. --------------- */
 bool Solver::isBackedUp() const {
-    return nodesToBackup_.empty();
+    for (std::vector<BeliefNode *> const &nodes : nodesToBackup_) {
+        if (!nodes.empty()) {
+            return false;
+        }
+    }
+    return true;
 }
 
 void Solver::doBackup() {
-    while (!nodesToBackup_.empty()) {
-        auto firstEntry = nodesToBackup_.cbegin();
-        long depth = firstEntry->first;
-        for (BeliefNode *node : firstEntry->second) {
-            if (depth == 0) {
-                node->recalculateValue();
-            } else {
-                double oldQValue = node->getCachedValue();
-                node->recalculateValue();
-                double deltaQValue = node->getCachedValue() - oldQValue;
-                long nContinuations = node->getMapping()->getTotalVisitCount()
-                        - node->getNumberOfStartingSequences();
-                double deltaTotalQ = options_->discountFactor * nContinuations * deltaQValue;
-
-                ActionMappingEntry *parentActionEntry =
-                        node->getParentActionNode()->getParentEntry();
-                if (parentActionEntry->update(0, deltaTotalQ)) {
-                    addNodeToBackup(parentActionEntry->getMapping()->getOwner());
-                }
-            }
-        }
-        nodesToBackup_.erase(firstEntry);
+    backUpQueuedNodes(options_->backupTolerance);
+}
+
+void Solver::flushBackup() {
+    for (BeliefNode *node : nodesWithResiduals_) {
+        queueNodeForBackup(node);
     }
+    nodesWithResiduals_.clear();
+    backUpQueuedNodes(0);
 }
 
 
@@ -582,30 +879,33 @@ void Solver::updateSequence(HistorySequence *sequence, int sgn, long firstEntryI
 
 
     // Traverse the sequence in reverse.
-    auto it = sequence->entrySequence_.crbegin();
+    long entryId = sequence->getLength() - 1;
 
     // The last entry is used only for the heuristic estimate.
-    double deltaTotalQ = (*it)->immediateReward_;
-    it++;
+    double deltaTotalQ = sequence->getEntry(entryId)->immediateReward_;
+    entryId--;
     BeliefNode *node;
     while (true) {
+        HistoryEntry *historyEntry = sequence->getEntry(entryId);
         // Apply discount and add the immediate reward.
-        deltaTotalQ = deltaTotalQ * discountFactor + (*it)->immediateReward_;
-        node = (*it)->getAssociatedBeliefNode();
+        deltaTotalQ = deltaTotalQ * discountFactor + historyEntry->immediateReward_;
+        node = historyEntry->getAssociatedBeliefNode();
+        // Other search threads may be updating this node.
+        std::lock_guard<std::mutex> lock(node->getMutex());
         ActionMapping *mapping = node->getMapping();
-        ActionMappingEntry *entry = mapping->getEntry(*(*it)->getAction());
+        ActionMappingEntry *entry = mapping->getEntry(*historyEntry->getAction());
         // Update the action value and visit count.
         entry->update(sgn, sgn * deltaTotalQ);
 
         // Update the observation visit count.
         ObservationMappingEntry *obsEntry = (
-                entry->getActionNode()->getMapping()->getEntry(*(*it)->getObservation()));
+                entry->getActionNode()->getMapping()->getEntry(*historyEntry->getObservation()));
         obsEntry->updateVisitCount(sgn);
 
         // If we've gone past the source node, we don't need to update further.
         // Backpropagation may need to go further, but we can simply defer it.
-        it++;
-        if (it == sequence->entrySequence_.crend() || (*it)->entryId_ < firstEntryId) {
+        entryId--;
+        if (entryId < 0 || entryId < firstEntryId) {
             addNodeToBackup(node);
             break;
         }
@@ -636,8 +936,10 @@ void Solver::updateEstimate(BeliefNode *node, double deltaTotalQ, long deltaNCon
     deltaTotalQ *= options_->discountFactor;
 
     ActionMappingEntry *parentActionEntry = node->getParentActionNode()->getParentEntry();
+    BeliefNode *parentNode = parentActionEntry->getMapping()->getOwner();
+    std::lock_guard<std::mutex> lock(parentNode->getMutex());
     if (parentActionEntry->update(0, deltaTotalQ)) {
-        addNodeToBackup(parentActionEntry->getMapping()->getOwner());
+        addNodeToBackup(parentNode);
     }
 }
 
@@ -649,6 +951,7 @@ void Solver::updateImmediate(BeliefNode *node, Action const &action, Observation
         return;
     }
 
+    std::lock_guard<std::mutex> lock(node->getMutex());
     // Retrieve the associated ActionMappingEntry.
     ActionMappingEntry *entry = node->getMapping()->getEntry(action);
 
@@ -666,6 +969,13 @@ void Solver::updateImmediate(BeliefNode *node, Action const &action, Observation
 
 /* ------------------ Initialization methods ------------------- */
 void Solver::initialize() {
+    // Anything handed over to the reclaimer still points into the old data structures.
+    reclaimer_.reclaimAll();
+    prunedParents_.clear();
+    mergedStatistics_.clear();
+    nodesToBackup_.clear();
+    nodesWithResiduals_.clear();
+
     // Core data structures
     if (options_->useStateIndex) {
         statePool_ = std::make_unique<StatePool>(model_->createStateIndex());
@@ -687,23 +997,248 @@ void Solver::initialize() {
     estimationStrategy_ = model_->createEstimationStrategy(this);
 }
 
+BeliefNode *Solver::initializeWorkerRoot(HistoricalData const *data,
+        std::vector<State const *> const &states) {
+    if (policy_ == nullptr) {
+        initialize();
+        actionPool_ = model_->createActionPool(this);
+        observationPool_ = model_->createObservationPool(this);
+    } else {
+        // Discard the previous search; the old nodes must be removed from the existing tree.
+        policy_->reset();
+        histories_->reset();
+        if (options_->useStateIndex) {
+            statePool_ = std::make_unique<StatePool>(model_->createStateIndex());
+        } else {
+            statePool_ = std::make_unique<StatePool>(nullptr);
+        }
+        nodesToBackup_.clear();
+        nodesWithResiduals_.clear();
+    }
+
+    BeliefNode *root = policy_->getRoot();
+    if (data != nullptr) {
+        root->data_ = data->copy();
+    }
+    root->setMapping(actionPool_->createActionMapping(root));
+    estimationStrategy_->setValueEstimator(this, root);
+
+    for (State const *state : states) {
+        HistorySequence *histSeq = histories_->createSequence();
+        HistoryEntry *histEntry = histSeq->addEntry();
+        histEntry->registerState(statePool_->createOrGetInfo(*state));
+        histEntry->registerNode(root);
+    }
+    return root;
+}
+
+/* ------------------ Root-parallel search methods ------------------- */
+bool Solver::initializeWorkers(long nWorkers) {
+    while (static_cast<long>(workers_.size()) < nWorkers) {
+        // Each worker gets its own RNG stream, seeded from ours.
+        std::unique_ptr<RandomGenerator> randGen = std::make_unique<RandomGenerator>(
+                (*model_->getRandomGenerator())());
+        std::unique_ptr<Model> workerModel = model_->createWorkerModel(randGen.get());
+        if (workerModel == nullptr) {
+            debug::show_message("WARNING: This model cannot create worker models;"
+                    " searching with one thread.");
+            canCreateWorkers_ = false;
+            return false;
+        }
+        workerRandGens_.push_back(std::move(randGen));
+        std::unique_ptr<Solver> worker = std::make_unique<Solver>(std::move(workerModel));
+        // The worker's rollouts go to our pool; its search strategy is only made when it is first
+        // initialized, so nothing is using the pool it made.
+        worker->ownRolloutWorkerPool_ = nullptr;
+        worker->rolloutWorkerPool_ = rolloutWorkerPool_;
+        workers_.push_back(std::move(worker));
+    }
+    return true;
+}
+
+void Solver::initializeWorkerRoots(BeliefNode *startNode) {
+    // The workers search from copies of the same particles; none => sample initial states.
+    std::vector<State const *> startStates;
+    for (long index = 0; index < startNode->getNumberOfParticles(); index++) {
+        State const *state = startNode->particles_.get(index)->getState();
+        if (!model_->isTerminal(*state)) {
+            startStates.push_back(state);
+        }
+    }
+    HistoricalData const *data = startNode->getHistoricalData();
+
+    // Each worker clears out its own previous tree.
+    std::vector<std::thread> threads;
+    for (std::unique_ptr<Solver> &worker : workers_) {
+        Solver *workerSolver = worker.get();
+        threads.emplace_back([workerSolver, data, &startStates]() {
+            workerSolver->initializeWorkerRoot(data, startStates);
+        });
+    }
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+}
+
+long Solver::parallelSearches(BeliefNode *startNode, std::function<StateInfo *()> sampler,
+        long maximumDepth, long maxNumSearches) {
+    // The worker roots are at depth 0.
+    long workerMaximumDepth = maximumDepth - startNode->getDepth();
+
+    // Split any limit on the number of histories evenly between the threads.
+    long nThreads = workers_.size() + 1;
+    std::vector<long> workerNumSearches(workers_.size(), 0);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < workers_.size(); i++) {
+        long maxWorkerSearches = get_search_quota(maxNumSearches, nThreads, i + 1);
+        if (maxNumSearches != 0 && maxWorkerSearches == 0) {
+            continue;
+        }
+        Solver *worker = workers_[i].get();
+        worker->searchDeadline_ = searchDeadline_;
+        worker->searchStopToken_ = searchStopToken_;
+        long *numSearches = &workerNumSearches[i];
+        threads.emplace_back([=]() {
+            // A root without particles => sample initial states.
+            BeliefNode *root = worker->policy_->getRoot();
+            std::function<StateInfo *()> workerSampler = worker->getStateSampler(
+                    root->getNumberOfParticles() == 0 ? nullptr : root);
+            if (workerSampler != nullptr) {
+                *numSearches = worker->multipleSearches(root, workerSampler, workerMaximumDepth,
+                        maxWorkerSearches);
+                // The root statistics must be exact before they are merged.
+                worker->flushBackup();
+            }
+        });
+    }
+
+    long numSearches = multipleSearches(startNode, sampler, maximumDepth,
+            get_search_quota(maxNumSearches, nThreads, 0));
+
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    for (std::size_t i = 0; i < workers_.size(); i++) {
+        workers_[i]->searchDeadline_ = tapir::Deadline();
+        workers_[i]->searchStopToken_ = nullptr;
+        if (workerNumSearches[i] > 0) {
+            numSearches += workerNumSearches[i];
+            mergeRootStatistics(startNode, workers_[i]->policy_->getRoot());
+        }
+    }
+
+    // Backup the merged statistics.
+    doBackup();
+    return numSearches;
+}
+
+void Solver::mergeRootStatistics(BeliefNode *node, BeliefNode const *workerRoot) {
+    std::lock_guard<std::mutex> lock(node->getMutex());
+    ActionMapping *mapping = node->getMapping();
+    long nMergedVisits = 0;
+    workerRoot->getMapping()->forEachVisitedEntry(
+            [this, node, mapping, &nMergedVisits] (ActionMappingEntry const *workerEntry) {
+        ActionMappingEntry *entry = mapping->getEntry(*workerEntry->getAction());
+        if (entry == nullptr) {
+            // No matching entry in this tree (e.g. a continuous action), so it can't be merged.
+            return;
+        }
+        entry->update(workerEntry->getVisitCount(), workerEntry->getTotalQValue());
+        nMergedVisits += workerEntry->getVisitCount();
+        mergedStatistics_.push_back(MergedStatistics { node, workerEntry->getAction()->copy(),
+                workerEntry->getVisitCount(), workerEntry->getTotalQValue() });
+    });
+
+    // The merged visits count as histories that start here, not as continuations from the
+    // parent belief, so the value estimate of the parent is unaffected.
+    node->nStartingSequences_ += nMergedVisits;
+    addNodeToBackup(node);
+}
+
+void Solver::removeMergedStatistics() {
+    if (mergedStatistics_.empty()) {
+        return;
+    }
+    for (MergedStatistics const &stats : mergedStatistics_) {
+        BeliefNode *node = stats.node;
+        node->getMapping()->getEntry(*stats.action)->update(-stats.visitCount,
+                -stats.totalQValue);
+        node->nStartingSequences_ -= stats.visitCount;
+        addNodeToBackup(node);
+    }
+    mergedStatistics_.clear();
+    doBackup();
+}
+
+/* ------------------ Tree-parallel search methods ------------------- */
+long Solver::treeParallelSearches(BeliefNode *startNode, BeliefNode *samplingNode,
+        std::function<StateInfo *()> sampler, long maximumDepth, long maxNumSearches) {
+    long nThreads = workers_.size() + 1;
+    std::vector<long> workerNumSearches(workers_.size(), 0);
+    std::vector<std::thread> threads;
+    for (std::size_t i = 0; i < workers_.size(); i++) {
+        long maxWorkerSearches = get_search_quota(maxNumSearches, nThreads, i + 1);
+        if (maxNumSearches != 0 && maxWorkerSearches == 0) {
+            continue;
+        }
+        Model *workerModel = workers_[i]->getModel();
+        // The samplers must be made before any thread starts adding particles to the start node.
+        std::function<StateInfo *()> workerSampler = getStateSampler(samplingNode, workerModel);
+        long *numSearches = &workerNumSearches[i];
+        threads.emplace_back([=]() {
+            threadSolver = this;
+            threadModel = workerModel;
+            *numSearches = runSearches(startNode, workerSampler, maximumDepth, maxWorkerSearches);
+            threadSolver = nullptr;
+            threadModel = nullptr;
+        });
+    }
+
+    long numSearches = runSearches(startNode, sampler, maximumDepth,
+            get_search_quota(maxNumSearches, nThreads, 0));
+    for (std::thread &thread : threads) {
+        thread.join();
+    }
+    for (long workerSearches : workerNumSearches) {
+        numSearches += workerSearches;
+    }
+
+    // Backup all the way back to the root of the tree to maintain consistency.
+    doBackup();
+    return numSearches;
+}
+
 /* ------------------ Episode sampling methods ------------------- */
 std::function<StateInfo *()> Solver::getStateSampler(BeliefNode *node) {
+    return getStateSampler(node, model_.get());
+}
+
+std::function<StateInfo *()> Solver::getStateSampler(BeliefNode *node, Model *model) {
     // Nullptr => sample initial sates from the model.
     if (node == nullptr) {
-        return [this]() {
-            return statePool_->createOrGetInfo(*model_->sampleAnInitState());
+        StatePool *statePool = statePool_.get();
+        return [statePool, model]() {
+            return statePool->createOrAdoptInfo(model->sampleAnInitState());
         };
     }
 
-    // Filter out any terminal states.
+    // Filter out any terminal states; particles that haven't been revised since the last changes
+    // are only used if there are no others.
     std::vector<StateInfo *> nonTerminalStates;
+    std::vector<StateInfo *> staleStates;
     for (long index = 0; index < node->getNumberOfParticles(); index++) {
         HistoryEntry *entry = node->particles_.get(index);
-        if (!model_->isTerminal(*entry->getState())) {
-            nonTerminalStates.push_back(entry->stateInfo_);
+        if (!model->isTerminal(*entry->getState())) {
+            if (entry->entryId_ < entry->owningSequence_->startAffectedIdx_) {
+                nonTerminalStates.push_back(entry->stateInfo_);
+            } else {
+                staleStates.push_back(entry->stateInfo_);
+            }
         }
     }
+    if (nonTerminalStates.empty()) {
+        nonTerminalStates = std::move(staleStates);
+    }
 
     // No non-terminal states => return an empty function.
     if (nonTerminalStates.empty()) {
@@ -711,7 +1246,7 @@ std::function<StateInfo *()> Solver::getStateSampler(BeliefNode *node) {
         return std::function<StateInfo *()>();
     }
 
-    RandomGenerator *randGen = model_->getRandomGenerator();
+    RandomGenerator *randGen = model->getRandomGenerator();
     return [randGen, nonTerminalStates]() {
         long index = std::uniform_int_distribution<long>(0, nonTerminalStates.size() - 1)(*randGen);
         return nonTerminalStates[index];
@@ -719,12 +1254,17 @@ std::function<StateInfo *()> Solver::getStateSampler(BeliefNode *node) {
 }
 
 long Solver::multipleSearches(BeliefNode *startNode, std::function<StateInfo *()> sampler,
-        long maximumDepth, long maxNumSearches, double endTime) {
-    bool hasTimeout = true;
-    if (endTime == std::numeric_limits<double>::infinity()) {
-        hasTimeout = false;
-    }
+        long maximumDepth, long maxNumSearches) {
+    long numSearches = runSearches(startNode, sampler, maximumDepth, maxNumSearches);
+
+    // Backup all the way back to the root of the tree to maintain consistency.
+    doBackup();
 
+    return numSearches;
+}
+
+long Solver::runSearches(BeliefNode *startNode, std::function<StateInfo *()> sampler,
+        long maximumDepth, long maxNumSearches) {
     long numSearches = 0;
     while (true) {
         // If we've done enough searches, stop searching.
@@ -732,16 +1272,16 @@ long Solver::multipleSearches(BeliefNode *startNode, std::function<StateInfo *()
             break;
         }
         // If we've gone past the termination time, stop searching.
-        if (hasTimeout && tapir::clock_ms() >= endTime) {
+        if (searchDeadline_.hasExpired()) {
+            break;
+        }
+        // If we've been asked to stop, stop searching.
+        if (searchStopToken_ != nullptr && searchStopToken_->isStopRequested()) {
             break;
         }
         singleSearch(startNode, sampler(), maximumDepth);
         numSearches++;
     }
-
-    // Backup all the way back to the root of the tree to maintain consistency.
-    doBackup();
-
     return numSearches;
 }
 
@@ -760,13 +1300,119 @@ void Solver::continueSearch(HistorySequence *sequence, long maximumDepth) {
     searchStrategy_->extendAndBackup(sequence, maximumDepth);
 }
 
+/* ------------------ Private pruning methods. ------------------- */
+long Solver::detachSubtree(BeliefNode *root) {
+    // The stale sequences are rare, so these are the only ones looked up straight away.
+    if (!staleSequences_.empty()) {
+        for (HistoryEntry *entry : root->particles_) {
+            staleSequences_.erase(entry->owningSequence_);
+        }
+    }
+    long nSequencesDeleted = root->getNumberOfParticles();
+
+    // The histories and the nodes of the subtree are removed by the reclaimer.
+    BeliefNode *parent = root->getParentBelief();
+    ObservationMappingEntry *entry = root->getParentEntry();
+    policy_->detachSubtree(root);
+    reclaimer_.addSubtree(entry->getMapping()->deleteChild(entry), policy_.get(),
+            histories_.get());
+    prunedParents_.push_back(parent);
+    addNodeToBackup(parent);
+    return nSequencesDeleted;
+}
+
+void Solver::finishReclaiming() {
+    reclaimer_.finish();
+    prunedParents_.clear();
+}
+
+void Solver::finishReclaimingAbove(BeliefNode const *node) {
+    for (BeliefNode *parent : prunedParents_) {
+        if (parent->isInSubtreeOf(node)) {
+            finishReclaiming();
+            return;
+        }
+    }
+}
+
 /* ------------------ Private deferred backup methods. ------------------- */
 void Solver::addNodeToBackup(BeliefNode *node) {
-    nodesToBackup_[node->getDepth()].insert(node);
+    if (threadBackupQueue != nullptr) {
+        threadBackupQueue->push_back(node);
+        return;
+    }
+    std::lock_guard<std::mutex> lock(backupMutex_);
+    queueNodeForBackup(node);
 }
 
 void Solver::removeNodeToBackup(BeliefNode *node) {
-    auto nodeSet = nodesToBackup_[node->getDepth()];
-    nodeSet.erase(nodeSet.find(node));
+    std::lock_guard<std::mutex> lock(backupMutex_);
+    if (!node->isQueuedForBackup_) {
+        return;
+    }
+    std::vector<BeliefNode *> &nodes = nodesToBackup_[node->getDepth()];
+    auto it = std::find(nodes.begin(), nodes.end(), node);
+    *it = nodes.back();
+    nodes.pop_back();
+    node->isQueuedForBackup_ = false;
+}
+
+void Solver::queueNodeForBackup(BeliefNode *node) {
+    if (node->isQueuedForBackup_) {
+        return;
+    }
+    node->isQueuedForBackup_ = true;
+    std::size_t depth = node->getDepth();
+    if (depth >= nodesToBackup_.size()) {
+        nodesToBackup_.resize(depth + 1);
+    }
+    nodesToBackup_[depth].push_back(node);
+}
+
+void Solver::backUpQueuedNodes(double tolerance) {
+    double discountFactor = options_->discountFactor;
+    // Parents are always one level up, so a single pass from the deepest level is enough.
+    for (long depth = nodesToBackup_.size() - 1; depth >= 0; depth--) {
+        std::vector<BeliefNode *> &nodes = nodesToBackup_[depth];
+        for (BeliefNode *node : nodes) {
+            node->isQueuedForBackup_ = false;
+            // Nodes that have been pruned since they were queued are skipped.
+            if (node->id_ < 0) {
+                continue;
+            }
+            // Lock the nodes so that snapshots of their statistics can be taken concurrently.
+            std::unique_lock<std::mutex> lock(node->getMutex());
+            if (depth == 0) {
+                node->recalculateValue();
+                continue;
+            }
+            double oldQValue = node->getCachedValue();
+            node->recalculateValue();
+            double deltaQValue = node->getCachedValue() - oldQValue;
+            long nContinuations = node->getMapping()->getTotalVisitCount()
+                    - node->getNumberOfStartingSequences();
+            node->unpropagatedTotalQ_ += discountFactor * nContinuations * deltaQValue;
+            if (std::abs(node->unpropagatedTotalQ_)
+                    <= tolerance * discountFactor * nContinuations) {
+                if (node->unpropagatedTotalQ_ != 0) {
+                    nodesWithResiduals_.insert(node);
+                }
+                continue;
+            }
+            double deltaTotalQ = node->unpropagatedTotalQ_;
+            node->unpropagatedTotalQ_ = 0;
+            lock.unlock();
+
+            ActionMappingEntry *parentActionEntry =
+                    node->getParentActionNode()->getParentEntry();
+            BeliefNode *parentNode = parentActionEntry->getMapping()->getOwner();
+            std::lock_guard<std::mutex> parentLock(parentNode->getMutex());
+            if (parentActionEntry->update(0, deltaTotalQ)) {
+                // No search is running, so the queue can be modified directly.
+                queueNodeForBackup(parentNode);
+            }
+        }
+        nodes.clear();
+    }
 }
 } /* namespace solver */
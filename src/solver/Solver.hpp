@@ -6,8 +6,10 @@
 #ifndef SOLVER_SOLVER_HPP_
 #define SOLVER_SOLVER_HPP_
 
+#include <functional>
 #include <map>
 #include <memory>        // for unique_ptr
+#include <mutex>
 #include <set>                          // for set
 #include <unordered_set>
 #include <unordered_map>
@@ -24,6 +26,8 @@
 
 #include "solver/changes/ChangeFlags.hpp"               // for ChangeFlags
 
+#include "solver/TreeReclaimer.hpp"
+
 /** A namespace to hold all of the various classes used by the solver - particularly the main
  * Solver class, of course.
  */
@@ -32,10 +36,12 @@ class ActionPool;
 class BackpropagationStrategy;
 class BeliefNode;
 class BeliefTree;
+class HistoricalData;
 class Histories;
 class HistoryEntry;
 class HistorySequence;
 class ObservationPool;
+class RolloutWorkerPool;
 class SearchStrategy;
 class Serializer;
 class StateInfo;
@@ -92,10 +98,23 @@ public:
     /** Returns the recommendation strategy. */
     SelectRecommendedActionStrategy* getRecommendationStrategy() const;
 
+    /** Returns the deadline for the search in progress; this never expires when no search is
+     * running.
+     */
+    tapir::Deadline const &getSearchDeadline() const;
+
 
     /** Returns the serializer for this solver. */
     Serializer *getSerializer() const;
 
+    /** Returns the pool of threads for running rollouts in parallel, which has one thread fewer
+     * than Options::nThreads.
+     *
+     * The workers used for parallel search share the pool of the solver that made them, so that
+     * the number of rollout threads doesn't grow with the number of search threads.
+     */
+    RolloutWorkerPool *getRolloutWorkerPool() const;
+
     /* ------------------ Initialization methods ------------------- */
     /** Full initialization - resets all data structures. */
     void initializeEmpty();
@@ -108,10 +127,36 @@ public:
      * - numberOfHistories is the number of histories to make (-1 => default, 0 => no limit),
      * - maximumDepth is the maximum depth allowed in the tree (-1 => default), relative to the
      * starting belief node.
-     * - timeout is the maximum allowed time in milliseconds (-1 => default, 0 => no timeout)
+     * - timeout is the maximum allowed wall-clock time in milliseconds (-1 => default,
+     * 0 => no timeout); a history still being generated when it runs out is cut short and
+     * finished with a heuristic estimate.
+     * - stopToken, if given, can be used by another thread to stop the search early; no new
+     * histories are started once a stop is requested, and the tree is fully backed up before
+     * this method returns.
+     *
+     * If Options::nThreads is greater than one, the search is parallel. By default it is
+     * root-parallel: each extra thread searches its own copy of the tree from the same belief,
+     * and the action statistics at the start node are merged into this tree once every thread
+     * has finished. The merged statistics are only kept until the tree is next searched,
+     * revised, pruned or saved. If Options::useTreeParallelSearch is set, all of the threads search this
+     * tree instead, each with its own copy of the model.
      */
     void improvePolicy(BeliefNode *startNode = nullptr,
-            long numberOfHistories = -1, long maximumDepth = -1, double timeout = -1);
+            long numberOfHistories = -1, long maximumDepth = -1, double timeout = -1,
+            tapir::StopToken const *stopToken = nullptr);
+    /** Does the same as improvePolicy(), but without any output; returns the number of histories
+     * that were generated.
+     */
+    long searchFrom(BeliefNode *startNode = nullptr,
+            long numberOfHistories = -1, long maximumDepth = -1, double timeout = -1,
+            tapir::StopToken const *stopToken = nullptr);
+
+    /** Returns the action currently recommended at the given belief node (nullptr => the root).
+     *
+     * Unlike BeliefNode::getRecommendedAction(), this is safe to call while another thread is
+     * running improvePolicy(), as long as the search strategy is safe for tree-parallel search.
+     */
+    std::unique_ptr<Action> getRecommendedActionSnapshot(BeliefNode const *node = nullptr) const;
 
     /** Replenishes the particle count in the child node, ensuring that it
      * has at least the given number of particles
@@ -120,16 +165,26 @@ public:
     BeliefNode *replenishChild(BeliefNode *currNode, Action const &action, Observation const &obs,
             long minParticleCount = -1);
 
-    /** Resets the tree, so that the given belief will be the new root. */
+    /** Resets the tree, so that the given belief will be the new root.
+     *
+     * The old tree and its histories are freed in a background thread; the states that only they
+     * used are deleted from the StatePool the next time the tree is pruned or reset.
+     */
     void resetTree(BeliefNode *newRoot);
 
     /** Prunes all sibling nodes of the given node in the tree, i.e. all nodes that have the same
      * parent belief node, but take a different action and observation.
+     *
+     * The pruned subtrees and their histories are freed in a background thread; the states that
+     * only they used are deleted from the StatePool the next time the tree is pruned or reset.
      */
     long pruneSiblings(BeliefNode *node);
 
     /** Prunes the subtree rooted at the given node, deleting all of the histories and all of
-     * the nodes in this subtree.
+     * the nodes in this subtree, and returns the number of histories deleted.
+     *
+     * The subtree is only unlinked here; its histories and nodes are removed and freed in a
+     * background thread, as for pruneSiblings().
      */
     long pruneSubtree(BeliefNode *root);
 
@@ -138,17 +193,46 @@ public:
     BeliefNode *getChangeRoot() const;
     /** Sets the root node for the changes. nullptr = all nodes. */
     void setChangeRoot(BeliefNode *changeRoot);
-    /** Returns true iff the given node is affected by the current changes, which is expressed
-     * via the change root, and a map storing info as to whether or not nodes have been
-     * affected.
+    /** Returns true iff the given node is affected by the current changes, i.e. iff it is
+     * descended from the change root; this takes constant time (see BeliefNode::isInSubtreeOf()).
+     */
+    bool isAffected(BeliefNode const *node) const;
+    /** Applies the given changes to the copies of the model used by the extra search and rollout
+     * threads, via Model::applyChanges() without a solver.
+     *
+     * The copies are kept for as long as the solver, so this must be called whenever changes are
+     * applied to the model of this solver.
      */
-    bool isAffected(BeliefNode const *node);
+    void applyChangesToWorkers(std::vector<std::unique_ptr<ModelChange>> const &changes);
     /** Applies any model changes that have been marked within the state pool.
      *
      * Changes are only applied at belief nodes that are descended from the change root,
      * or at all belief nodes if the change root is nullptr.
+     *
+     * With tree-parallel search (see improvePolicy()), the affected histories are split into
+     * batches that change separate subtrees of the change root, and the batches are revised and
+     * extended concurrently, one per thread; the histories that can't be separated are handled
+     * on this thread first. The deferred backups of each batch are queued in batch order, so the
+     * results don't depend on the timing of the threads.
+     *
+     * If Options::changeTimeout is set, histories are only revised until it runs out, starting
+     * with those nearest the change root; the rest are left stale, and are revised by
+     * reviseStaleHistories() at the start of later searches. Searches avoid starting from stale
+     * particles unless there are no others.
      */
     void applyChanges();
+    /** Revises the histories left stale by applyChanges(), starting with those nearest the given
+     * belief (nullptr => the root), until the given wall-clock time in milliseconds has passed
+     * (0 => no limit).
+     *
+     * The histories with stale particles in the given belief come first, followed by the others
+     * in order of the distance in depth between the given belief and their first change.
+     *
+     * Returns the number of histories that were revised.
+     */
+    long reviseStaleHistories(BeliefNode *node = nullptr, double timeout = 0);
+    /** Returns the number of histories that have been affected by changes but not yet revised. */
+    long getNumberOfStaleHistories() const;
 
     /* ------------------ Display methods  ------------------- */
     /** Shows a belief node in a nice, readable way. */
@@ -160,8 +244,23 @@ public:
     /* -------------- Management of deferred backpropagation. --------------- */
     /** Returns true iff there are any incomplete deferred backup operations. */
     bool isBackedUp() const;
-    /** Completes any deferred backup operations. */
+    /** Completes any deferred backup operations.
+     *
+     * The queued nodes are recalculated one depth at a time, deepest first, so that each node is
+     * recalculated only once no matter how many of its descendants changed. A node's change in
+     * value is only passed on to its parent once it exceeds Options::backupTolerance; smaller
+     * changes are accumulated at the node until they do, or until flushBackup() is called.
+     *
+     * This must not be called while other threads are searching the tree.
+     */
     void doBackup();
+    /** Completes any deferred backup operations like doBackup(), but also passes on every change
+     * that is still accumulated at a node, so that the values are exact all the way up to the
+     * root.
+     *
+     * This is done after searching and applying changes, and before pruning or saving the tree.
+     */
+    void flushBackup();
 
     /* -------------- Methods to update the q-values in the tree. --------------- */
     /** Updates the approximate q-values of actions in the belief tree based on this history
@@ -206,28 +305,128 @@ private:
      *    and for loading from a file.
      */
     void initialize();
+    /** Re-initializes this solver as a root-parallel search worker, with a single root belief
+     * holding copies of the given states and of the given historical data.
+     *
+     * Returns the new root.
+     */
+    BeliefNode *initializeWorkerRoot(HistoricalData const *data,
+            std::vector<State const *> const &states);
+
+    /* ------------------ Root-parallel search methods ------------------- */
+    /** Ensures that there are at least the given number of worker solvers for root-parallel
+     * search.
+     *
+     * Returns false if the model cannot create worker models.
+     */
+    bool initializeWorkers(long nWorkers);
+    /** Re-initializes each worker with a new root holding copies of the non-terminal particles
+     * of the given node, or with an empty root if there are none.
+     */
+    void initializeWorkerRoots(BeliefNode *startNode);
+    /** Runs searches from the given start node on this thread and on every worker thread, and
+     * then merges the workers' root statistics into the start node; the worker roots must have
+     * been made by initializeWorkerRoots().
+     *
+     * Returns the total number of histories generated across all of the threads.
+     */
+    long parallelSearches(BeliefNode *startNode, std::function<StateInfo *()> sampler,
+            long maximumDepth, long maxNumSearches);
+    /** Adds the action visit counts and total q-values of the given worker root into the given
+     * node of this tree, so that they are used when choosing the recommended action.
+     *
+     * No histories back these statistics, so they are recorded in mergedStatistics_ and taken
+     * out again by removeMergedStatistics().
+     */
+    void mergeRootStatistics(BeliefNode *node, BeliefNode const *workerRoot);
+    /** Removes the statistics added by mergeRootStatistics(), and backs up the nodes they were
+     * added to; this must be done before the tree is searched, revised, pruned or saved.
+     */
+    void removeMergedStatistics();
+
+    /* ------------------ Tree-parallel search methods ------------------- */
+    /** Runs searches from the given start node on this thread and on every worker thread, with
+     * all of the threads sharing this tree. Each worker thread uses the model of its worker
+     * solver, and samples start states from the given node (nullptr => initial states).
+     *
+     * Returns the total number of histories generated across all of the threads.
+     */
+    long treeParallelSearches(BeliefNode *startNode, BeliefNode *samplingNode,
+            std::function<StateInfo *()> sampler, long maximumDepth, long maxNumSearches);
+
+    /* ------------------ History revision methods ------------------- */
+    /** Extends the given revised sequence using the search strategy, and backs it up. */
+    void extendSequence(HistorySequence *sequence);
+
+    /* ------------------ Parallel history revision methods ------------------- */
+    /** Splits the given affected sequences into one batch for each search thread, such that
+     * revising and extending the sequences in different batches changes disjoint parts of the
+     * tree; the sequences that can't be separated in this way are put into sharedSequences.
+     *
+     * The result depends only on the sequences and the tree, so that the revision is repeatable.
+     */
+    void partitionSequences(std::unordered_set<HistorySequence *> const &sequences,
+            std::vector<HistorySequence *> &sharedSequences,
+            std::vector<std::vector<HistorySequence *>> &batches);
+    /** Calls the given function on each of the given sequences in order, keeping only those for
+     * which it returns true.
+     */
+    void filterSequences(std::vector<HistorySequence *> &sequences,
+            std::function<bool(HistorySequence *)> function);
+    /** Filters each of the given batches with the given function, using this thread for the first
+     * batch and a worker thread for each of the others, and then queues the nodes that need
+     * backing up in batch order.
+     */
+    void runBatches(std::vector<std::vector<HistorySequence *>> &batches,
+            std::function<bool(HistorySequence *)> function);
 
     /* ------------------ Episode sampling methods ------------------- */
     /** Returns a function that will sample states from the given node.
      * nullptr => sample initial states from the model.
      */
     std::function<StateInfo *()> getStateSampler(BeliefNode *node);
+    /** Returns a function that will sample states from the given node, using the given model
+     * for random numbers and for initial states.
+     */
+    std::function<StateInfo *()> getStateSampler(BeliefNode *node, Model *model);
 
-    /** Runs multiple searches from the given start node and start states.
+    /** Runs multiple searches from the given start node and start states, until either the
+     * maximum number of searches is reached or the search deadline passes.
      *
      * Returns the actual number of histories generated. */
     long multipleSearches(BeliefNode *startNode, std::function<StateInfo *()> sampler,
-            long maximumDepth, long maxNumSearches, double endTime);
+            long maximumDepth, long maxNumSearches);
+    /** The search loop of multipleSearches(), without the final backup. */
+    long runSearches(BeliefNode *startNode, std::function<StateInfo *()> sampler,
+            long maximumDepth, long maxNumSearches);
     /** Searches from the given start node with the given start state. */
     void singleSearch(BeliefNode *startNode, StateInfo *startStateInfo, long maximumDepth);
     /** Continues a pre-existing history sequence from its endpoint. */
     void continueSearch(HistorySequence *sequence, long maximumDepth);
 
+    /* ------------------ Private pruning methods. ------------------- */
+    /** Unlinks the subtree rooted at the given node, which must not be the root, and hands it over
+     * to the reclaimer without starting it; returns the number of histories that go into it.
+     */
+    long detachSubtree(BeliefNode *root);
+    /** Waits until the reclaimer has finished with the subtrees it was given. */
+    void finishReclaiming();
+    /** Waits until the reclaimer has finished if it may be changing the particles of the given
+     * node, i.e. if the node is above one of the subtrees being reclaimed.
+     */
+    void finishReclaimingAbove(BeliefNode const *node);
+
     /* ------------------ Private deferred backup methods. ------------------- */
-    /** Adds a new node that requires backing up. */
+    /** Adds a new node that requires backing up; this is safe to call from any search thread. */
     void addNodeToBackup(BeliefNode *node);
     /** Removes a node from the deferred backup queue. */
     void removeNodeToBackup(BeliefNode *node);
+    /** Adds a node to the deferred backup queue, unless it's already there; the caller must
+     * hold backupMutex_ or otherwise have exclusive access to the queue.
+     */
+    void queueNodeForBackup(BeliefNode *node);
+    /** Backs up the queued nodes as in doBackup(), with the given tolerance. */
+    void backUpQueuedNodes(double tolerance);
 
     /* ------------------ Private data fields ------------------- */
     /** The POMDP model */
@@ -260,14 +459,50 @@ private:
     /** The strategy for estimating the value of a belief node based on actions from it. */
     std::unique_ptr<EstimationStrategy> estimationStrategy_;
 
-    /** The nodes to be updated, sorted by depth (deepest first) */
-    std::map<int, std::set<BeliefNode *>, std::greater<int>> nodesToBackup_;
+    /** The nodes to be updated, indexed by depth. */
+    std::vector<std::vector<BeliefNode *>> nodesToBackup_;
+    /** The nodes that may have changes accumulated below the backup tolerance. */
+    std::unordered_set<BeliefNode *> nodesWithResiduals_;
+    /** Guards nodesToBackup_ and the queued flags of the nodes during tree-parallel search. */
+    std::mutex backupMutex_;
+
+    /** The deadline for the search in progress. */
+    tapir::Deadline searchDeadline_;
+    /** The token used to stop the search in progress, if any. */
+    tapir::StopToken const *searchStopToken_;
 
     /** The root node for changes that will be applied. */
     BeliefNode *changeRoot_;
 
-    /** A map to store which nodes are affected by changes and which are not. */
-    std::unordered_map<BeliefNode const *, bool> isAffectedMap_;
+    /** The sequences that have been affected by changes but have not been revised yet, with the
+     * depth of the first change in each.
+     */
+    std::unordered_map<HistorySequence *, long> staleSequences_;
+
+    /** False if the model has been found not to support worker models. */
+    bool canCreateWorkers_;
+    /** The random number generators for the worker models, which only keep a pointer. */
+    std::vector<std::unique_ptr<RandomGenerator>> workerRandGens_;
+    /** The solvers used by the extra threads for root-parallel search. */
+    std::vector<std::unique_ptr<Solver>> workers_;
+    /** The pool of rollout threads made by this solver; workers don't have one of their own. */
+    std::unique_ptr<RolloutWorkerPool> ownRolloutWorkerPool_;
+    /** The pool of rollout threads used by this solver, which may belong to another solver. */
+    RolloutWorkerPool *rolloutWorkerPool_;
+    /** The worker statistics that have been merged into an action of a node in this tree. */
+    struct MergedStatistics {
+        BeliefNode *node;
+        std::unique_ptr<Action> action;
+        long visitCount;
+        double totalQValue;
+    };
+    /** The worker statistics currently merged into this tree by mergeRootStatistics(). */
+    std::vector<MergedStatistics> mergedStatistics_;
+
+    /** The parents of the subtrees that the reclaimer may still be working on. */
+    std::vector<BeliefNode *> prunedParents_;
+    /** Frees pruned subtrees and their histories in the background. */
+    TreeReclaimer reclaimer_;
 };
 } /* namespace solver */
 
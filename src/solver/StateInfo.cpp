@@ -4,8 +4,11 @@
  */
 #include "solver/StateInfo.hpp"
 
+#include <cstdint>                      // for uintptr_t
+
 #include <algorithm>                    // for find
 #include <memory>                       // for unique_ptr
+#include <mutex>
 #include <set>                          // for set
 #include <utility>                      // for move
 #include <vector>                       // for vector, vector<>::iterator
@@ -17,10 +20,28 @@ namespace solver {
 class BeliefNode;
 class HistoryEntry;
 
+namespace {
+/** The number of mutexes shared between all StateInfo instances. */
+constexpr std::size_t N_ENTRIES_MUTEXES = 64;
+
+/** Returns the mutex guarding the set of history entries of the given StateInfo.
+ *
+ * A small fixed set of mutexes is striped across all of the states, rather than keeping one
+ * mutex per state.
+ */
+std::mutex &getEntriesMutex(StateInfo const *info) {
+    static std::mutex mutexes[N_ENTRIES_MUTEXES];
+    // Divide out the alignment so that all of the mutexes are actually used.
+    std::uintptr_t address = reinterpret_cast<std::uintptr_t>(info);
+    return mutexes[(address / sizeof(StateInfo)) % N_ENTRIES_MUTEXES];
+}
+} /* namespace */
+
 StateInfo::StateInfo(std::unique_ptr<State> state) :
     state_(std::move(state)),
     id_(-1),
     usedInHistoryEntries_(),
+    nPins_(0),
     changeFlags_(ChangeFlags::UNCHANGED) {
 }
 
@@ -52,9 +73,11 @@ State const *StateInfo::getState() const {
 
 /* ----------------- History entry registration  ----------------- */
 void StateInfo::addHistoryEntry(HistoryEntry *entry) {
+    std::lock_guard<std::mutex> lock(getEntriesMutex(this));
     usedInHistoryEntries_.insert(entry);
 }
 void StateInfo::removeHistoryEntry(HistoryEntry *entry) {
+    std::lock_guard<std::mutex> lock(getEntriesMutex(this));
     usedInHistoryEntries_.erase(entry);
 }
 
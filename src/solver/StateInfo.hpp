@@ -72,6 +72,10 @@ private:
 
     /** The set of history entries that this state occurs in. */
     std::unordered_set<HistoryEntry *> usedInHistoryEntries_;
+    /** The number of pins on this state, which keep it from being deleted by the pool even if no
+     * history entry uses it.
+     */
+    long nPins_;
 
     /** The flags for the changes that affect this state. */
     ChangeFlags changeFlags_;
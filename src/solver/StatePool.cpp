@@ -4,9 +4,8 @@
  */
 #include "solver/StatePool.hpp"
 
-#include <map>                          // for multimap, __alloc_traits<>::value_type
-#include <set>                          // for set
-#include <unordered_map>                // for unordered_map
+#include <algorithm>                    // for remove_if
+#include <sstream>
 #include <unordered_set>                // for unordered_set
 #include <utility>                      // for move, pair
 
@@ -18,33 +17,55 @@
 #include "solver/changes/ChangeFlags.hpp"               // for ChangeFlags
 
 namespace solver {
+StatePool::BucketTable::BucketTable(std::size_t size) :
+    nBuckets(size),
+    buckets(new std::atomic<ChainNode const *>[size]) {
+    for (std::size_t i = 0; i < size; i++) {
+        buckets[i].store(nullptr, std::memory_order_relaxed);
+    }
+}
+
+StatePool::Shard::Shard() :
+    mutex(),
+    table(nullptr),
+    tables(),
+    nodes(),
+    infos() {
+    tables.push_back(std::make_unique<BucketTable>(16));
+    table.store(tables.back().get(), std::memory_order_release);
+}
 
 StatePool::StatePool(std::unique_ptr<StateIndex> stateIndex) :
-    stateInfoMap_(),
-    statesByIndex_(),
+    shards_(new Shard[NUMBER_OF_SHARDS]),
+    nextId_(0),
+    blocks_(),
     stateIndex_(std::move(stateIndex)),
+    stateIndexMutex_(),
     changedStates_() {
+    for (int k = 0; k < NUMBER_OF_BLOCKS; k++) {
+        blocks_[k].store(nullptr, std::memory_order_relaxed);
+    }
 }
 
 StatePool::~StatePool() {
+    for (int k = 0; k < NUMBER_OF_BLOCKS; k++) {
+        delete[] blocks_[k].load(std::memory_order_relaxed);
+    }
 }
 
 /* ------------------ Simple getters ------------------- */
 StateInfo *StatePool::getInfo(State const &state) const {
-    StateInfoMap::const_iterator it = stateInfoMap_.find(&state);
-    if (it == stateInfoMap_.end()) {
-        return nullptr;
-    }
-    return it->second;
+    std::size_t hash = mixHash(state.hash());
+    return find(getShard(hash).table.load(std::memory_order_acquire), hash, state);
 }
 StateInfo *StatePool::getInfoById(long id) const {
-    return statesByIndex_[id].get();
+    return getSlot(id, false)->load(std::memory_order_acquire);
 }
 StateIndex *StatePool::getStateIndex() const {
     return stateIndex_.get();
 }
 long StatePool::getNumberOfStates() const {
-    return statesByIndex_.size();
+    return nextId_.load(std::memory_order_acquire);
 }
 
 /* ------------------ State lookup ------------------- */
@@ -53,7 +74,16 @@ StateInfo *StatePool::createOrGetInfo(State const &state) {
     if (info != nullptr) {
         return info;
     }
-    return add(std::make_unique<StateInfo>(state.copy()));
+    // Copy the state without holding any lock; if another thread adds an equal state in the
+    // meantime, insert() will return that one instead.
+    return insert(std::make_unique<StateInfo>(state.copy())).first;
+}
+StateInfo *StatePool::createOrAdoptInfo(std::unique_ptr<State> &&state) {
+    StateInfo *info = getInfo(*state);
+    if (info != nullptr) {
+        return info;
+    }
+    return insert(std::make_unique<StateInfo>(std::move(state))).first;
 }
 
 /* ------------------ Flagging of changes at states ------------------- */
@@ -77,32 +107,220 @@ std::unordered_set<StateInfo *> StatePool::getAffectedStates() const {
     return changedStates_;
 }
 
-/* ============================ PRIVATE ============================ */
+/* ------------------ Garbage collection ------------------- */
+void StatePool::pinInfo(StateInfo *stateInfo) {
+    stateInfo->nPins_++;
+}
+void StatePool::unpinInfo(StateInfo *stateInfo) {
+    if (stateInfo->nPins_ <= 0) {
+        debug::show_message("ERROR: Unpinning a state that isn't pinned!");
+        return;
+    }
+    stateInfo->nPins_--;
+}
 
+long StatePool::collectGarbage() {
+    long nStates = getNumberOfStates();
+    // Deleted infos are marked with an ID of -1 until their shard is rebuilt.
+    long nDeleted = 0;
+    for (long id = 0; id < nStates; id++) {
+        StateInfo *info = getInfoById(id);
+        if (isGarbage(info)) {
+            if (stateIndex_ != nullptr) {
+                stateIndex_->removeStateInfo(info);
+            }
+            info->id_ = -1;
+            nDeleted++;
+        }
+    }
+    if (nDeleted == 0) {
+        return 0;
+    }
 
-/* ------------------ Mutators for the pool ------------------- */
-StateInfo *StatePool::add(std::unique_ptr<StateInfo> newInfo) {
-    std::pair<StateInfoMap::iterator, bool> ret = (
-            stateInfoMap_.emplace(newInfo->getState(), newInfo.get()));
-    StateInfo *stateInfo = ret.first->second;
-    if (ret.second) {
-        long newId = long(statesByIndex_.size());
-        // New state - add to the index.
-        long oldId = stateInfo->getId();
-        if (oldId != -1 && oldId != newId) {
-            std::ostringstream message;
-            message << "ERROR: ID mismatch - file says " << oldId;
-            message << " but and ID of " << newId << " was assigned.";
-            debug::show_message(message.str());
+    // Fill the gaps below the new size with the states at the top, as Histories does for
+    // sequences; the moved states must be re-indexed under their new IDs.
+    long nRemaining = nStates - nDeleted;
+    long topId = nStates - 1;
+    for (long id = 0; id < nRemaining; id++) {
+        std::atomic<StateInfo *> *slot = getSlot(id, false);
+        if (slot->load(std::memory_order_relaxed)->id_ != -1) {
+            continue;
+        }
+        StateInfo *movedInfo = getSlot(topId, false)->load(std::memory_order_relaxed);
+        while (movedInfo->id_ == -1) {
+            topId--;
+            movedInfo = getSlot(topId, false)->load(std::memory_order_relaxed);
+        }
+        topId--;
+        if (stateIndex_ != nullptr) {
+            stateIndex_->removeStateInfo(movedInfo);
         }
-        stateInfo->id_ = newId;
-        statesByIndex_.push_back(std::move(newInfo));
+        movedInfo->id_ = id;
+        slot->store(movedInfo, std::memory_order_relaxed);
         if (stateIndex_ != nullptr) {
-            stateIndex_->addStateInfo(stateInfo);
+            stateIndex_->addStateInfo(movedInfo);
+        }
+    }
+    for (long id = nRemaining; id < nStates; id++) {
+        getSlot(id, false)->store(nullptr, std::memory_order_relaxed);
+    }
+
+    // Release the blocks of IDs that are now entirely unused, apart from the first one.
+    for (int k = 1; k < NUMBER_OF_BLOCKS; k++) {
+        if (FIRST_BLOCK_SIZE * ((1L << k) - 1) >= nRemaining) {
+            delete[] blocks_[k].exchange(nullptr, std::memory_order_relaxed);
         }
-    } else {
+    }
+
+    for (long i = 0; i < NUMBER_OF_SHARDS; i++) {
+        rebuildShard(shards_[i]);
+    }
+    nextId_.store(nRemaining, std::memory_order_release);
+    return nDeleted;
+}
+
+/* ============================ PRIVATE ============================ */
+
+
+/* ------------------ Sharded storage ------------------- */
+std::size_t StatePool::mixHash(std::size_t hash) {
+    // Fibonacci hashing spreads poor hash functions (e.g. small integers) over all of the bits.
+    return std::size_t(static_cast<unsigned long long>(hash) * 0x9E3779B97F4A7C15ULL);
+}
+
+StatePool::Shard &StatePool::getShard(std::size_t hash) const {
+    return shards_[(hash >> (sizeof(std::size_t) * 8 - SHARD_BITS)) & (NUMBER_OF_SHARDS - 1)];
+}
+
+StateInfo *StatePool::find(BucketTable const *table, std::size_t hash, State const &state) {
+    ChainNode const *node = table->buckets[(hash >> 16) & (table->nBuckets - 1)].load(
+            std::memory_order_acquire);
+    for (; node != nullptr; node = node->next) {
+        if (node->hash == hash && *node->info->getState() == state) {
+            return node->info;
+        }
+    }
+    return nullptr;
+}
+
+void StatePool::insertNode(Shard &shard, std::size_t hash, StateInfo *info) {
+    BucketTable const *table = shard.table.load(std::memory_order_relaxed);
+    if (shard.infos.size() > table->nBuckets) {
+        // Rebuild the chains in a table twice the size; readers that are still using the old
+        // table will see the same states, so it can be published without waiting for them.
+        std::unique_ptr<BucketTable> newTable = std::make_unique<BucketTable>(
+                2 * table->nBuckets);
+        for (std::size_t i = 0; i < table->nBuckets; i++) {
+            ChainNode const *node = table->buckets[i].load(std::memory_order_relaxed);
+            for (; node != nullptr; node = node->next) {
+                std::atomic<ChainNode const *> &head = newTable->buckets[
+                        (node->hash >> 16) & (newTable->nBuckets - 1)];
+                shard.nodes.push_back(ChainNode { node->hash, node->info,
+                        head.load(std::memory_order_relaxed) });
+                head.store(&shard.nodes.back(), std::memory_order_relaxed);
+            }
+        }
+        table = newTable.get();
+        shard.tables.push_back(std::move(newTable));
+        shard.table.store(table, std::memory_order_release);
+    }
+    std::atomic<ChainNode const *> &head = table->buckets[(hash >> 16) & (table->nBuckets - 1)];
+    shard.nodes.push_back(ChainNode { hash, info, head.load(std::memory_order_relaxed) });
+    head.store(&shard.nodes.back(), std::memory_order_release);
+}
+
+std::atomic<StateInfo *> *StatePool::getSlot(long id, bool allocate) const {
+    // Block k holds the IDs from FIRST_BLOCK_SIZE * (2^k - 1) onwards.
+    unsigned long blockNumber = id / FIRST_BLOCK_SIZE + 1;
+    int k = 0;
+    while (blockNumber >>= 1) {
+        k++;
+    }
+    long blockSize = FIRST_BLOCK_SIZE << k;
+    long offset = id - (blockSize - FIRST_BLOCK_SIZE);
+
+    std::atomic<StateInfo *> *block = blocks_[k].load(std::memory_order_acquire);
+    if (block == nullptr) {
+        if (!allocate) {
+            return nullptr;
+        }
+        std::atomic<StateInfo *> *newBlock = new std::atomic<StateInfo *>[blockSize];
+        for (long i = 0; i < blockSize; i++) {
+            newBlock[i].store(nullptr, std::memory_order_relaxed);
+        }
+        if (blocks_[k].compare_exchange_strong(block, newBlock, std::memory_order_acq_rel)) {
+            block = newBlock;
+        } else {
+            // Another thread got there first.
+            delete[] newBlock;
+        }
+    }
+    return block + offset;
+}
+
+bool StatePool::isGarbage(StateInfo const *stateInfo) {
+    return (stateInfo->nPins_ == 0 && stateInfo->usedInHistoryEntries_.empty()
+            && stateInfo->changeFlags_ == ChangeFlags::UNCHANGED);
+}
+
+void StatePool::rebuildShard(Shard &shard) {
+    std::vector<std::unique_ptr<StateInfo>> &infos = shard.infos;
+    infos.erase(std::remove_if(infos.begin(), infos.end(),
+            [](std::unique_ptr<StateInfo> const &info) {
+                return info->id_ == -1;
+            }), infos.end());
+
+    // Nobody else is using the pool, so the old tables and chains can all be thrown away.
+    std::size_t nBuckets = 16;
+    while (nBuckets < infos.size()) {
+        nBuckets *= 2;
+    }
+    shard.tables.clear();
+    shard.nodes.clear();
+    shard.tables.push_back(std::make_unique<BucketTable>(nBuckets));
+    shard.table.store(shard.tables.back().get(), std::memory_order_release);
+    for (std::unique_ptr<StateInfo> const &info : infos) {
+        insertNode(shard, mixHash(info->getState()->hash()), info.get());
+    }
+}
+
+/* ------------------ Mutators for the pool ------------------- */
+StateInfo *StatePool::add(std::unique_ptr<StateInfo> newInfo) {
+    long oldId = newInfo->getId();
+    std::pair<StateInfo *, bool> ret = insert(std::move(newInfo));
+    if (!ret.second) {
         debug::show_message("ERROR: StateInfo already added!!");
+    } else if (oldId != -1 && oldId != ret.first->getId()) {
+        std::ostringstream message;
+        message << "ERROR: ID mismatch - file says " << oldId;
+        message << " but and ID of " << ret.first->getId() << " was assigned.";
+        debug::show_message(message.str());
+    }
+    return ret.first;
+}
+
+std::pair<StateInfo *, bool> StatePool::insert(std::unique_ptr<StateInfo> newInfo) {
+    State const &state = *newInfo->getState();
+    std::size_t hash = mixHash(state.hash());
+    Shard &shard = getShard(hash);
+    StateInfo *stateInfo = newInfo.get();
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        StateInfo *existingInfo = find(shard.table.load(std::memory_order_relaxed), hash, state);
+        if (existingInfo != nullptr) {
+            return std::make_pair(existingInfo, false);
+        }
+        // New state - give it the next ID, and make it visible by ID before it can be found by
+        // value.
+        stateInfo->id_ = nextId_.fetch_add(1, std::memory_order_acq_rel);
+        getSlot(stateInfo->id_, true)->store(stateInfo, std::memory_order_release);
+        shard.infos.push_back(std::move(newInfo));
+        insertNode(shard, hash, stateInfo);
+    }
+    if (stateIndex_ != nullptr) {
+        std::lock_guard<std::mutex> lock(stateIndexMutex_);
+        stateIndex_->addStateInfo(stateInfo);
     }
-    return stateInfo;
+    return std::make_pair(stateInfo, true);
 }
 } /* namespace solver */
@@ -14,10 +14,12 @@
 
 #include <cstddef>                      // for size_t
 
-#include <map>                          // for multimap
+#include <atomic>
+#include <deque>
 #include <memory>                       // for unique_ptr
-#include <unordered_map>                // for unordered_map
+#include <mutex>
 #include <unordered_set>                // for unordered_set
+#include <utility>                      // for pair
 #include <vector>                       // for vector
 
 #include "global.hpp"
@@ -42,6 +44,14 @@ class StateIndex;
  * The pool allows states to be looked up by ID; more complicated lookup operations
  * (typically based on spatial coordinates) should be handled via the StateIndex, which can be
  * retrieved via getStateIndex().
+ *
+ * createOrGetInfo(), getInfo() and getInfoById() can safely be called from several threads at
+ * once. The states are split into shards by hash value; lookups don't take any locks, and
+ * adding a new state only locks the shard it belongs to.
+ *
+ * States that are no longer used by any history entry can be deleted via collectGarbage(); any
+ * other StateInfo pointers that need to outlive the histories (e.g. the actual history of a
+ * simulation) must be protected by pinning the state via pinInfo().
  */
 class StatePool {
     friend class Solver;
@@ -62,8 +72,6 @@ class StatePool {
             return *s1 == *s2;
         }
     };
-    /** An unordered map for looking up the StateInfo for a given State. */
-    typedef std::unordered_map<State const *, StateInfo *, Hash, EqualityTest> StateInfoMap;
 
     /** Constructs a new StatePool with the given StateIndex. */
     StatePool(std::unique_ptr<StateIndex> stateIndex);
@@ -80,12 +88,20 @@ class StatePool {
     StateInfo *getInfoById(long id) const;
     /** Returns the StateIndex used by this pool. */
     StateIndex *getStateIndex() const;
-    /** Returns the number of states in this pooll. */
+    /** Returns the number of states in this pool; if states are being added by other threads,
+     * the newest IDs may not have their infos yet.
+     */
     long getNumberOfStates() const;
 
     /* ------------------ State lookup ------------------- */
     /** Returns a StateInfo for the given state, creating a new one if there wasn't one already. */
     StateInfo *createOrGetInfo(State const &state);
+    /** Returns a StateInfo for the given state, creating a new one if there wasn't one already.
+     *
+     * Unlike createOrGetInfo(), a new StateInfo takes over the given state instead of copying
+     * it, leaving the pointer null; if the state was already in the pool, the caller keeps it.
+     */
+    StateInfo *createOrAdoptInfo(std::unique_ptr<State> &&state);
 
     /* ---------------- Flagging of states with changes ----------------- */
     /** Resets the change flags for the given StateInfo, and removes it from the set of affected
@@ -100,18 +116,110 @@ class StatePool {
     /** Returns the current set of affected states. */
     std::unordered_set<StateInfo *> getAffectedStates() const;
 
+    /* ------------------ Garbage collection ------------------- */
+    /** Pins the given state, so that it will not be deleted by collectGarbage() even if it isn't
+     * used by any history entry.
+     */
+    void pinInfo(StateInfo *stateInfo);
+    /** Removes a pin that was previously placed on the given state via pinInfo(). */
+    void unpinInfo(StateInfo *stateInfo);
+    /** Deletes every state that is unpinned, isn't used by any history entry, and isn't marked
+     * as affected by changes; returns the number of states deleted.
+     *
+     * The IDs of the remaining states are compacted back into 0 ... n-1 by moving the states with
+     * the highest IDs into the gaps, and the StateIndex is updated to match.
+     *
+     * NOTE: No other thread may use the pool while this is running, and any pointers to the
+     * deleted states become invalid.
+     */
+    long collectGarbage();
+
   private:
+    /* ------------------ Sharded storage ------------------- */
+    /** The number of bits of the hash used to pick a shard. */
+    static int const SHARD_BITS = 6;
+    /** The number of shards. */
+    static long const NUMBER_OF_SHARDS = 1L << SHARD_BITS;
+    /** The size of the first block of infos by ID; each later block is twice as big. */
+    static long const FIRST_BLOCK_SIZE = 1024;
+    /** The maximum number of blocks of infos by ID. */
+    static int const NUMBER_OF_BLOCKS = 48;
+
+    /** An entry in a chain of states whose hashes share a bucket; it never changes once it has
+     * been published.
+     */
+    struct ChainNode {
+        /** The mixed hash value of the state. */
+        std::size_t hash;
+        /** The info for the state. */
+        StateInfo *info;
+        /** The next entry in the chain. */
+        ChainNode const *next;
+    };
+    /** The hash table of a single shard. */
+    struct BucketTable {
+        /** Makes a new table with the given number of empty buckets. */
+        BucketTable(std::size_t size);
+        /** The number of buckets; always a power of two. */
+        std::size_t nBuckets;
+        /** The head of the chain of each bucket. */
+        std::unique_ptr<std::atomic<ChainNode const *>[]> buckets;
+    };
+    /** A shard of the pool. */
+    struct Shard {
+        Shard();
+        /** Guards insertion into this shard. */
+        std::mutex mutex;
+        /** The current hash table for this shard. */
+        std::atomic<BucketTable const *> table;
+        /** Every table made for this shard. When a table is replaced, the old one is kept, as
+         * lock-free readers may still be using it.
+         */
+        std::vector<std::unique_ptr<BucketTable>> tables;
+        /** Every chain node made for this shard, including those of the old tables. */
+        std::deque<ChainNode> nodes;
+        /** The infos owned by this shard. */
+        std::vector<std::unique_ptr<StateInfo>> infos;
+    };
+
+    /** Returns the given state hash, mixed so that both its high and low bits are usable. */
+    static std::size_t mixHash(std::size_t hash);
+    /** Returns the shard for the given mixed hash. */
+    Shard &getShard(std::size_t hash) const;
+    /** Looks up the given state in the given table, without locking. */
+    static StateInfo *find(BucketTable const *table, std::size_t hash, State const &state);
+    /** Adds a chain node for the given info to the given shard, which must be locked, growing
+     * its table if needed.
+     */
+    static void insertNode(Shard &shard, std::size_t hash, StateInfo *info);
+    /** Returns the slot that stores the info with the given ID, allocating its block if
+     * requested; returns nullptr if the block doesn't exist yet and allocate is false.
+     */
+    std::atomic<StateInfo *> *getSlot(long id, bool allocate) const;
+    /** Returns true iff the given state can be deleted by collectGarbage(). */
+    static bool isGarbage(StateInfo const *stateInfo);
+    /** Drops the deleted infos from the given shard, and rebuilds its hash table from scratch. */
+    static void rebuildShard(Shard &shard);
+
     /* ------------------ Mutators for the pool ------------------- */
     /** Takes possession of the given StateInfo and adds it to the pool. */
     StateInfo *add(std::unique_ptr<StateInfo> stateInfo);
+    /** Adds the given StateInfo unless an equal state is already in the pool; returns the info in
+     * the pool, and whether it was newly added.
+     */
+    std::pair<StateInfo *, bool> insert(std::unique_ptr<StateInfo> stateInfo);
 
   private:
-    /** An unordered mapping of states to their associated StateInfo. */
-    StateInfoMap stateInfoMap_;
-    /** The vector that actually stores the StateInfo; also allows lookup of states by ID. */
-    std::vector<std::unique_ptr<StateInfo>> statesByIndex_;
+    /** The shards, which hold the infos and map states to them. */
+    std::unique_ptr<Shard[]> shards_;
+    /** The next ID to hand out; this is also the number of states in the pool. */
+    std::atomic<long> nextId_;
+    /** The blocks of infos by ID; block k holds FIRST_BLOCK_SIZE * 2^k infos. */
+    mutable std::atomic<std::atomic<StateInfo *> *> blocks_[NUMBER_OF_BLOCKS];
     /** The StateIndex used by this pool. */
     std::unique_ptr<StateIndex> stateIndex_;
+    /** Guards the StateIndex, which needn't be thread-safe itself. */
+    std::mutex stateIndexMutex_;
 
     /** The set of states currently marked as affected by changes. */
     std::unordered_set<StateInfo *> changedStates_;
@@ -0,0 +1,129 @@
+/** @file TreeReclaimer.cpp
+ *
+ * Contains the implementation of the TreeReclaimer class.
+ */
+#include "solver/TreeReclaimer.hpp"
+
+#include <iterator>                     // for make_move_iterator
+#include <memory>                       // for unique_ptr
+#include <utility>                      // for move
+#include <vector>                       // for vector
+
+#include "solver/ActionNode.hpp"
+#include "solver/BeliefNode.hpp"
+#include "solver/BeliefTree.hpp"
+#include "solver/Histories.hpp"
+#include "solver/HistoryEntry.hpp"
+#include "solver/HistorySequence.hpp"
+
+namespace solver {
+TreeReclaimer::Garbage::Garbage() :
+        subtrees(),
+        sequences(),
+        unindexedNodes(),
+        beliefNodes(),
+        actionNodes() {
+}
+
+TreeReclaimer::TreeReclaimer() :
+        pending_(),
+        running_(nullptr),
+        retired_(),
+        thread_() {
+}
+
+TreeReclaimer::~TreeReclaimer() {
+    reclaimAll();
+}
+
+void TreeReclaimer::addSubtree(std::unique_ptr<BeliefNode> root, BeliefTree *tree,
+        Histories *histories) {
+    pending_.subtrees.push_back(Subtree { std::move(root), tree, histories });
+}
+void TreeReclaimer::add(std::vector<std::unique_ptr<HistorySequence>> sequences) {
+    if (pending_.sequences.empty()) {
+        pending_.sequences = std::move(sequences);
+    } else {
+        pending_.sequences.insert(pending_.sequences.end(),
+                std::make_move_iterator(sequences.begin()),
+                std::make_move_iterator(sequences.end()));
+    }
+}
+void TreeReclaimer::add(std::unique_ptr<BeliefNode> node, std::vector<BeliefNode *> nodes) {
+    if (pending_.unindexedNodes.empty()) {
+        pending_.unindexedNodes = std::move(nodes);
+    } else {
+        pending_.unindexedNodes.insert(pending_.unindexedNodes.end(), nodes.begin(),
+                nodes.end());
+    }
+    pending_.beliefNodes.push_back(std::move(node));
+}
+void TreeReclaimer::add(std::unique_ptr<ActionNode> node) {
+    pending_.actionNodes.push_back(std::move(node));
+}
+
+void TreeReclaimer::start() {
+    finish();
+    // The subtrees retired by the last thread are freed by this one.
+    for (std::unique_ptr<BeliefNode> &root : retired_) {
+        pending_.beliefNodes.push_back(std::move(root));
+    }
+    retired_.clear();
+    if (pending_.subtrees.empty() && pending_.sequences.empty()
+            && pending_.beliefNodes.empty() && pending_.actionNodes.empty()) {
+        return;
+    }
+    // The thread takes the garbage with it.
+    running_ = std::make_shared<Garbage>(std::move(pending_));
+    pending_ = Garbage();
+    std::shared_ptr<Garbage> garbage = running_;
+    thread_ = std::thread([garbage] () {
+        reclaim(*garbage);
+    });
+}
+
+void TreeReclaimer::finish() {
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    if (running_ != nullptr) {
+        for (Subtree &subtree : running_->subtrees) {
+            retired_.push_back(std::move(subtree.root));
+        }
+        running_ = nullptr;
+    }
+}
+
+void TreeReclaimer::reclaimAll() {
+    finish();
+    reclaim(pending_);
+    pending_ = Garbage();
+    retired_.clear();
+}
+
+/* ============================ PRIVATE ============================ */
+
+void TreeReclaimer::reclaim(Garbage &garbage) {
+    for (Subtree &subtree : garbage.subtrees) {
+        // The nodes leave the index first, so that lookups stop finding them before their
+        // particles start to change.
+        subtree.tree->removeDetachedSubtree(subtree.root.get());
+        // Erasing a sequence removes its particle from the root, so the entries are copied.
+        std::vector<HistoryEntry *> entries(subtree.root->particles_.begin(),
+                subtree.root->particles_.end());
+        for (HistoryEntry *entry : entries) {
+            subtree.histories->releaseSequence(entry->owningSequence_)->erase();
+        }
+    }
+    for (std::unique_ptr<HistorySequence> &sequence : garbage.sequences) {
+        sequence->erase();
+    }
+    garbage.sequences.clear();
+    for (BeliefNode *node : garbage.unindexedNodes) {
+        node->id_ = -1;
+    }
+    garbage.unindexedNodes.clear();
+    garbage.beliefNodes.clear();
+    garbage.actionNodes.clear();
+}
+} /* namespace solver */
@@ -0,0 +1,124 @@
+/** @file TreeReclaimer.hpp
+ *
+ * Contains the TreeReclaimer class, which frees pruned parts of a belief tree, and the histories
+ * that went through them, in a background thread.
+ */
+#ifndef SOLVER_TREERECLAIMER_HPP_
+#define SOLVER_TREERECLAIMER_HPP_
+
+#include <memory>                       // for unique_ptr
+#include <thread>
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+namespace solver {
+class ActionNode;
+class BeliefNode;
+class BeliefTree;
+class Histories;
+class HistorySequence;
+
+/** Frees detached subtrees of a belief tree, and the history sequences that went into them,
+ * in a background thread.
+ *
+ * Freeing a large subtree takes a long time, so rather than doing it between receiving an
+ * observation and starting to search again, the Solver just unlinks the subtree and hands it
+ * over via the add methods; start() then does everything else in a new background thread, while
+ * the search carries on.
+ *
+ * For a subtree handed over with addSubtree(), the background thread removes the nodes of the
+ * subtree from the index of the BeliefTree, and then releases every sequence going through the
+ * root from the Histories and erases it. The index is only changed while holding the tree's node
+ * creation mutex, which is also held by every lookup in the index. Since the erased sequences
+ * also start in the ancestors of the root, their particles change while this is running; the
+ * Solver has to call finish() before it reads the particles of any of those nodes without holding
+ * their mutexes. A search may have looked up one of the removed nodes just before, so these nodes
+ * are only freed by the next background thread, i.e. after the search has finished.
+ *
+ * Anything handed over with the other add methods must already have been removed from the
+ * index and deregistered from any nodes that are staying, and is freed straight away.
+ *
+ * Since the background thread deregisters the sequences from their states, anything that
+ * looks at which history entries use a state (e.g. applying changes or collecting garbage in
+ * the StatePool) must call finish() first. The tree, the histories, and the allocators for the
+ * nodes and history entries must also outlive the reclamation; reclaimAll() frees everything
+ * before they are replaced.
+ */
+class TreeReclaimer {
+  public:
+    /** Constructs a reclaimer with nothing to free. */
+    TreeReclaimer();
+    /** Frees everything that was handed over, waiting for the background thread if needed. */
+    ~TreeReclaimer();
+    _NO_COPY_OR_MOVE(TreeReclaimer);
+
+    /** Hands over a belief node that has been unlinked from its parent in the given tree,
+     * whose histories are all in the given Histories.
+     */
+    void addSubtree(std::unique_ptr<BeliefNode> root, BeliefTree *tree, Histories *histories);
+    /** Hands over detached history sequences, to be erased and freed. */
+    void add(std::vector<std::unique_ptr<HistorySequence>> sequences);
+    /** Hands over a detached belief node, to be freed along with its subtree; the given nodes,
+     * which must include all of the nodes in that subtree, are marked as removed from the index
+     * first.
+     */
+    void add(std::unique_ptr<BeliefNode> node, std::vector<BeliefNode *> nodes);
+    /** Hands over a detached action node, to be freed along with its subtree. */
+    void add(std::unique_ptr<ActionNode> node);
+
+    /** Starts reclaiming everything handed over so far in a background thread; any previous
+     * reclamation is finished first.
+     */
+    void start();
+    /** Waits until everything handed over before the last call to start() has been reclaimed,
+     * apart from the subtree nodes that are left for the next background thread to free.
+     */
+    void finish();
+    /** Reclaims and frees everything that has been handed over, in this thread if it hasn't
+     * been started yet.
+     */
+    void reclaimAll();
+
+  private:
+    /** A subtree handed over by addSubtree(). */
+    struct Subtree {
+        /** The root of the subtree. */
+        std::unique_ptr<BeliefNode> root;
+        /** The tree whose index the nodes are in. */
+        BeliefTree *tree;
+        /** The histories that the sequences through the root belong to. */
+        Histories *histories;
+    };
+
+    /** The parts of a tree that are waiting to be freed. */
+    struct Garbage {
+        Garbage();
+
+        /** The subtrees whose histories and index entries have yet to be removed. */
+        std::vector<Subtree> subtrees;
+        /** The history sequences, which are freed first. */
+        std::vector<std::unique_ptr<HistorySequence>> sequences;
+        /** The belief nodes to mark as removed from the index before freeing them. */
+        std::vector<BeliefNode *> unindexedNodes;
+        /** The detached belief nodes. */
+        std::vector<std::unique_ptr<BeliefNode>> beliefNodes;
+        /** The detached action nodes. */
+        std::vector<std::unique_ptr<ActionNode>> actionNodes;
+    };
+
+    /** Reclaims the given garbage; the roots of its subtrees are left for the caller. */
+    static void reclaim(Garbage &garbage);
+
+    /** The garbage that has been handed over, but not yet passed to a background thread. */
+    Garbage pending_;
+    /** The garbage being reclaimed by the background thread, if any. */
+    std::shared_ptr<Garbage> running_;
+    /** The subtrees that have been removed from their index, and can be freed next time. */
+    std::vector<std::unique_ptr<BeliefNode>> retired_;
+    /** The thread reclaiming the last batch of garbage, if any. */
+    std::thread thread_;
+};
+} /* namespace solver */
+
+#endif /* SOLVER_TREERECLAIMER_HPP_ */
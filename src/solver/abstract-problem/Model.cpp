@@ -28,7 +28,7 @@
 #include "solver/mappings/observations/ObservationPool.hpp"
 
 #include "solver/indexing/StateIndex.hpp"
-#include "solver/indexing/RTree.hpp"
+#include "solver/indexing/PackedRTree.hpp"
 
 #include "solver/changes/DefaultHistoryCorrector.hpp"
 #include "solver/changes/HistoryCorrector.hpp"
@@ -172,8 +172,8 @@ std::unique_ptr<Action> Model::getRolloutAction(HistoryEntry const */*entry*/,
 
 /* ------- Customization of more complex solver functionality  --------- */
 std::unique_ptr<StateIndex> Model::createStateIndex() {
-    // Use an RTree, with the correct # of state variables.
-    return std::make_unique<RTree>(getOptions()->numberOfStateVariables);
+    // Use a PackedRTree, with the correct # of state variables.
+    return std::make_unique<PackedRTree>(getOptions()->numberOfStateVariables);
 }
 
 std::unique_ptr<HistoryCorrector> Model::createHistoryCorrector(Solver *solver) {
@@ -213,4 +213,8 @@ std::unique_ptr<Serializer> Model::createSerializer(Solver */*solver*/) {
     // Optional; not implemented.
     return nullptr;
 }
+std::unique_ptr<Model> Model::createWorkerModel(RandomGenerator */*randGen*/) {
+    // Optional; not implemented.
+    return nullptr;
+}
 } /* namespace solver */
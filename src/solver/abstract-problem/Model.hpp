@@ -285,8 +285,8 @@ public:
     /** Creates a StateIndex, which manages searching for states that have been used in a
      * StatePool.
      *
-     * By default, this method uses an R*-Tree, as implemented in libspatialindex, in order to
-     * allow range-based queries for the states.
+     * By default, this method uses a PackedRTree in order to allow range-based queries for the
+     * states.
      */
     virtual std::unique_ptr<StateIndex> createStateIndex();
 
@@ -363,6 +363,17 @@ public:
      */
     virtual std::unique_ptr<Serializer> createSerializer(Solver *solver);
 
+    /** Creates an independent copy of this model, which uses the given random number generator.
+     *
+     * This is used for root-parallel search (see Options::nThreads) - each additional search
+     * thread runs its own Solver with its own copy of the model, so that no model state is shared
+     * between threads. The copies are kept for as long as the Solver, and later changes are
+     * applied to them via applyChanges() without a solver (see Solver::applyChangesToWorkers()).
+     *
+     * By default this returns a null pointer, in which case the search will only use one thread.
+     */
+    virtual std::unique_ptr<Model> createWorkerModel(RandomGenerator *randGen);
+
 private:
     /** A string representing the name of this POMDP problem. */
     std::string problemName_;
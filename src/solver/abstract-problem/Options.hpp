@@ -44,11 +44,19 @@ struct Options : options::BaseOptions {
     bool useStateIndex = true;
     /** Whether to completely re-build the tree from scratch if changes occur. */
     bool resetOnChanges = false;
+    /** The maximum wall-clock time (in milliseconds) to spend revising histories when changes
+     * occur; 0 => no limit.
+     *
+     * Any histories that haven't been revised by then are left stale, and are revised before
+     * later searches instead, starting with those nearest the belief being searched from (see
+     * Solver::applyChanges()).
+     */
+    double changeTimeout = 0;
     /** The minimum number of particles to maintain in the active belief node. */
     unsigned long minParticleCount = 1000;
     /** The number of new histories to generate on each search step. */
     unsigned long historiesPerStep = 1000;
-    /** The maximum time (in milliseconds) to spend on each search step. */
+    /** The maximum wall-clock time (in milliseconds) to spend on each search step. */
     double stepTimeout = 1000;
     /** The maximum depth to search, relative to the current belief node. */
     long maximumDepth = 100;
@@ -56,6 +64,30 @@ struct Options : options::BaseOptions {
      * relative to the current belief.
      */
     bool isAbsoluteHorizon = false;
+    /** The smallest change in the value of a belief that is passed on to its parent during a
+     * deferred backup; smaller changes are held back until they add up to more than this.
+     * 0 => every change is passed on.
+     */
+    double backupTolerance = 0.0;
+    /** The number of threads to use for parallel search. By default each additional thread
+     * searches its own copy of the tree, and the root statistics are merged when the search ends.
+     */
+    long nThreads = 1;
+    /** True if the extra search threads should share a single tree (tree-parallel search)
+     * instead of each searching their own copy (root-parallel search).
+     *
+     * In this mode the search strategy and heuristic must be safe to use from several threads at
+     * once; the standard UCB and rollout steps are. The history corrector is also used from
+     * several threads at once, as histories are then revised in parallel after model changes.
+     */
+    bool useTreeParallelSearch = false;
+    /** True if the agent should keep searching in the background while its chosen action is
+     * being carried out (see Agent::startPondering()).
+     *
+     * This only helps when carrying out an action takes real time, e.g. in the ROS node; the
+     * Simulator steps its model instantly, so it ignores this setting.
+     */
+    bool usePondering = false;
 
     /* ----------------------- TAPIR output modes ------------------- */
     /** True iff color output is allowed. */
@@ -0,0 +1,97 @@
+/** @file Recyclable.hpp
+ *
+ * Defines the Recyclable class template, which lets a model opt in to reusing the memory for its
+ * states, actions and observations from one step to the next.
+ */
+#ifndef SOLVER_RECYCLABLE_HPP_
+#define SOLVER_RECYCLABLE_HPP_
+
+#include <cstddef>                      // for size_t
+
+#include <new>                          // for operator new, operator delete
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+namespace solver {
+/** A base class that makes objects of type T (which must derive from Recyclable<T>) reuse the
+ * memory of previously deleted objects of the same type, instead of calling malloc every time.
+ *
+ * Every step of a search or simulation creates a new state, observation and action, most of
+ * which are thrown away almost immediately; with this base class, those short-lived objects are
+ * simply recycled via a small per-thread free list. Using it is as simple as adding it as an
+ * extra base class, e.g.
+ *
+ *     class MyState : public solver::VectorState, public solver::Recyclable<MyState>
+ *
+ * Objects can be freed on a different thread from the one that allocated them; the memory is
+ * then reused by the thread that freed it. Objects of a subclass of T (which are bigger than a T)
+ * are allocated on the heap as usual.
+ */
+template<typename T>
+class Recyclable {
+  public:
+    /** The maximum number of free blocks each thread keeps for reuse. */
+    static std::size_t const MAX_FREE_BLOCKS = 4096;
+
+    /** Allocates an object, reusing the memory of a deleted one if possible. */
+    static void *operator new(std::size_t size) {
+        if (size == sizeof(T)) {
+            std::vector<void *> &blocks = getFreeBlocks().blocks;
+            if (!blocks.empty()) {
+                void *block = blocks.back();
+                blocks.pop_back();
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    /** Frees an object, keeping its memory for reuse if possible. */
+    static void operator delete(void *pointer, std::size_t size) {
+        if (pointer == nullptr) {
+            return;
+        }
+        if (size == sizeof(T)) {
+            std::vector<void *> &blocks = getFreeBlocks().blocks;
+            if (blocks.size() < MAX_FREE_BLOCKS) {
+                blocks.push_back(pointer);
+                return;
+            }
+        }
+        ::operator delete(pointer);
+    }
+
+  protected:
+    Recyclable() = default;
+    ~Recyclable() = default;
+
+  private:
+    /** The free blocks held by a single thread, which are released when the thread exits. */
+    struct FreeBlocks {
+        FreeBlocks() :
+                blocks() {
+        }
+        ~FreeBlocks() {
+            for (void *block : blocks) {
+                ::operator delete(block);
+            }
+        }
+        _NO_COPY_OR_MOVE(FreeBlocks);
+
+        /** The blocks available for reuse. */
+        std::vector<void *> blocks;
+    };
+
+    /** Returns the free blocks for the current thread. */
+    static FreeBlocks &getFreeBlocks() {
+        static thread_local FreeBlocks freeBlocks;
+        return freeBlocks;
+    }
+};
+
+template<typename T>
+std::size_t const Recyclable<T>::MAX_FREE_BLOCKS;
+} /* namespace solver */
+
+#endif /* SOLVER_RECYCLABLE_HPP_ */
@@ -18,12 +18,7 @@ double average(BeliefNode const *node) {
         return 0;
     }
 
-    double totalQValue = 0;
-    for (ActionMappingEntry const *entry : mapping->getVisitedEntries()) {
-        totalQValue += entry->getTotalQValue();
-    }
-
-    double averageQValue = totalQValue / mapping->getTotalVisitCount();
+    double averageQValue = mapping->getTotalQValue() / mapping->getTotalVisitCount();
     if (!std::isfinite(averageQValue)) {
         debug::show_message("Non-finite Q!");
     }
@@ -36,14 +31,7 @@ double max(BeliefNode const *node) {
         return 0;
     }
 
-    double maxQValue = -std::numeric_limits<double>::infinity();
-    for (ActionMappingEntry const *entry : mapping->getVisitedEntries()) {
-        double qValue = entry->getMeanQValue();
-        if (qValue > maxQValue) {
-            maxQValue = qValue;
-        }
-    }
-    return maxQValue;
+    return mapping->getMaxQEntry()->getMeanQValue();
 }
 
 double robust(BeliefNode const *node) {
@@ -52,19 +40,7 @@ double robust(BeliefNode const *node) {
         return 0;
     }
 
-    long maxVisitCount = 0;
-    double robustQValue = -std::numeric_limits<double>::infinity();
-    for (ActionMappingEntry const *entry : mapping->getVisitedEntries()) {
-        double visitCount = entry->getVisitCount();
-        double qValue = entry->getMeanQValue();
-        if (visitCount > maxVisitCount) {
-            maxVisitCount = visitCount;
-            robustQValue = qValue;
-        } else if (visitCount == maxVisitCount && qValue > robustQValue) {
-            robustQValue = qValue;
-        }
-    }
-    return robustQValue;
+    return mapping->getRobustEntry()->getMeanQValue();
 }
 } /* namespace estimators */
 
@@ -73,8 +49,8 @@ EstimationFunction::EstimationFunction(std::function<double(BeliefNode const *)>
 }
 
 void EstimationFunction::setValueEstimator(Solver */*solver*/, BeliefNode *node) {
-    std::unique_ptr<CachedValue<double>> cachedValue = std::make_unique<CachedValue<double>>(node,
-            function_);
+    std::unique_ptr<CachedValue<double>> cachedValue = allocate_unique<CachedValue<double>>(
+            node->getAllocator(), node, function_);
     node->setValueEstimator(cachedValue.get());
     node->addCachedValue(std::move(cachedValue));
 }
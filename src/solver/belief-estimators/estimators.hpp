@@ -8,6 +8,9 @@
  * average - the visit-weighted average of its action children
  * max - the maximum value of its action children
  * robust - the value of the action child with the greatest number of visits
+ *
+ * These get their values from the action mapping, so they take constant time for mappings that
+ * keep running statistics, such as DiscretizedActionMap.
  */
 #ifndef SOLVER_ESTIMATORS_HPP_
 #define SOLVER_ESTIMATORS_HPP_
@@ -8,10 +8,11 @@
 #include "global.hpp"
 
 #include "solver/BeliefNode.hpp"
+#include "solver/SlabAllocator.hpp"
 
 namespace solver {
 /** An interface class so that cached values can easily be stored in a vector. */
-class BaseCachedValue {
+class BaseCachedValue : public SlabAllocated {
 public:
     BaseCachedValue() = default;
     virtual ~BaseCachedValue() = default;
@@ -38,18 +38,16 @@ bool DefaultHistoryCorrector::reviseSequence(HistorySequence *sequence) {
     bool hitIllegalAction = false; // True iff we hit an illegal action.
     bool hitTerminalState = false; // True iff the sequence terminated prematurely.
 
-    std::vector<std::unique_ptr<HistoryEntry>>::iterator historyIterator =
-            (sequence->entrySequence_.begin() + sequence->startAffectedIdx_);
-    std::vector<std::unique_ptr<HistoryEntry>>::iterator firstUnchanged =
-            (sequence->entrySequence_.begin() + sequence->endAffectedIdx_ + 1);
+    long entryId = sequence->startAffectedIdx_;
+    long firstUnchangedId = sequence->endAffectedIdx_ + 1;
 
     // Extra variables for use in the iteration.
-    HistoryEntry *entry = historyIterator->get(); // The current history entry.
+    HistoryEntry *entry = sequence->getEntry(entryId); // The current history entry.
     State const *state = entry->getState(); // The current state.
     // The actual current node that should be associated with this history entry.
     BeliefNode *actualCurrentNode = entry->getAssociatedBeliefNode();
 
-    while (historyIterator != firstUnchanged) {
+    while (entryId != firstUnchangedId) {
         // Check for early termination.
         hitTerminalState = getModel()->isTerminal(*state);
         if (hitTerminalState || entry->action_ == nullptr) {
@@ -61,7 +59,7 @@ bool DefaultHistoryCorrector::reviseSequence(HistorySequence *sequence) {
             debug::show_message("ERROR: deleted state in updateSequence.");
         }
 
-        HistoryEntry *nextEntry = (historyIterator + 1)->get();
+        HistoryEntry *nextEntry = sequence->getEntry(entryId + 1);
         if (changes::has_flags(entry->changeFlags_, ChangeFlags::TRANSITION)) {
 
             // Check for illegal actions.
@@ -76,11 +74,12 @@ bool DefaultHistoryCorrector::reviseSequence(HistorySequence *sequence) {
             entry->transitionParameters_ = getModel()->generateTransition(*state, *entry->action_);
             std::unique_ptr<State> nextState = getModel()->generateNextState(*state,
                     *entry->action_, entry->transitionParameters_.get());
-            StateInfo *nextStateInfo = getSolver()->getStatePool()->createOrGetInfo(*nextState);
+            StateInfo *nextStateInfo = getSolver()->getStatePool()->createOrAdoptInfo(
+                    std::move(nextState));
             if (nextStateInfo != nextEntry->getStateInfo()) {
                 nextEntry->registerState(nextStateInfo);
-                if (historyIterator + 1 == firstUnchanged) {
-                    firstUnchanged++;
+                if (entryId + 1 == firstUnchangedId) {
+                    firstUnchangedId++;
                 }
                 entry->setChangeFlags(ChangeFlags::OBSERVATION | ChangeFlags::REWARD);
                 // Different state, so we must reset the flags.
@@ -130,14 +129,14 @@ bool DefaultHistoryCorrector::reviseSequence(HistorySequence *sequence) {
             // Diverged => create a new node.
             actualCurrentNode = actualCurrentNode->createOrGetChild(*entry->getAction(),
                     *entry->getObservation());
-            historyIterator++;
-            entry = historyIterator->get();
+            entryId++;
+            entry = sequence->getEntry(entryId);
             entry->registerNode(actualCurrentNode);
             state = entry->getState();
         } else {
             // No divergence => use the previously registered node.
-            historyIterator++;
-            entry = historyIterator->get();
+            entryId++;
+            entry = sequence->getEntry(entryId);
             actualCurrentNode = entry->getAssociatedBeliefNode();
             state = entry->getState();
         }
@@ -196,8 +195,8 @@ bool DefaultHistoryCorrector::reviseSequence(HistorySequence *sequence) {
         while (entry->getAction() != nullptr) {
             actualCurrentNode = actualCurrentNode->createOrGetChild(*entry->getAction(),
                     *entry->getObservation());
-            historyIterator++;
-            entry = historyIterator->get();
+            entryId++;
+            entry = sequence->getEntry(entryId);
             entry->registerNode(actualCurrentNode);
         }
 
@@ -23,6 +23,12 @@ class Model;
  * This class also allows for distinct handling of history sequences in batches - the default
  * reviseHistories() simply calls reviseSequence() on each individual sequence, but it can be
  * overridden for a different approach.
+ *
+ * With tree-parallel search, reviseHistories() is not used; instead, reviseSequence() is called
+ * from several threads at once on sequences that affect separate parts of the tree, with
+ * getModel() returning a separate model for each thread. It is also not used when
+ * Options::changeTimeout is set, since the histories are then revised one at a time until the
+ * time runs out.
  */
 class HistoryCorrector {
 public:
@@ -0,0 +1,235 @@
+/** @file BeliefEmbeddingIndex.cpp
+ *
+ * Contains the implementation of the BeliefEmbeddingIndex class.
+ */
+#include "solver/indexing/BeliefEmbeddingIndex.hpp"
+
+#include <algorithm>                    // for nth_element
+#include <cmath>                        // for sqrt
+#include <limits>                       // for numeric_limits
+#include <numeric>                      // for iota
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+#include "solver/BeliefNode.hpp"
+#include "solver/BeliefTree.hpp"
+#include "solver/Solver.hpp"
+
+namespace solver {
+namespace {
+/** The largest range of points that is searched linearly rather than split further. */
+std::size_t const MAX_LEAF_SIZE = 8;
+
+/** Returns the distance between two embeddings, as described for BeliefEmbeddingIndex. */
+double embedding_distance(std::vector<double> const &mean1, double spread1,
+        std::vector<double> const &mean2, double spread2) {
+    double distanceSquared = spread1 * spread1 + spread2 * spread2;
+    for (std::size_t i = 0; i < mean1.size(); i++) {
+        distanceSquared += (mean1[i] - mean2[i]) * (mean1[i] - mean2[i]);
+    }
+    return std::sqrt(distanceSquared);
+}
+} /* namespace */
+
+BeliefEmbeddingIndex::BeliefEmbeddingIndex(Solver *solver) :
+        solver_(solver),
+        nDimensions_(0),
+        points_(),
+        nodes_(),
+        nodeIds_(),
+        order_(),
+        splitDimensions_(),
+        nNodesAtRebuild_(-1),
+        nQueriesSinceRebuild_(0) {
+}
+
+BeliefNode *BeliefEmbeddingIndex::findNearest(BeliefNode *node, long maxCandidates,
+        double &distance) {
+    distance = std::numeric_limits<double>::infinity();
+    std::vector<double> mean;
+    double spread = node->getStateVectorMoments(mean);
+    if (spread < 0 || maxCandidates <= 0) {
+        return nullptr;
+    }
+
+    if (needsRebuild()) {
+        rebuild();
+    }
+    nQueriesSinceRebuild_++;
+    if (mean.size() + 1 != nDimensions_) {
+        return nullptr;
+    }
+
+    // The squared distance from (mean, 0) to a point is |mean1 - mean2|^2 + spread2^2, which
+    // ranks the points the same way as the full distance.
+    std::vector<double> query(mean);
+    query.push_back(0);
+    CandidateQueue candidates;
+    search(0, order_.size(), query, maxCandidates, candidates);
+
+    BeliefTree *tree = solver_->getPolicy();
+    BeliefNode *nearestNode = nullptr;
+    std::vector<double> otherMean;
+    for (; !candidates.empty(); candidates.pop()) {
+        std::size_t index = candidates.top().second;
+        BeliefNode *otherNode = nodes_[index];
+        // Skip the node itself, and any node that has left the tree since the index was built.
+        long id = nodeIds_[index];
+        if (otherNode == node || tree->getNode(id) != otherNode) {
+            continue;
+        }
+        double otherSpread = otherNode->getStateVectorMoments(otherMean);
+        if (otherSpread < 0) {
+            continue;
+        }
+        double otherDistance = embedding_distance(mean, spread, otherMean, otherSpread);
+        if (otherDistance < distance) {
+            distance = otherDistance;
+            nearestNode = otherNode;
+        }
+    }
+    return nearestNode;
+}
+
+double BeliefEmbeddingIndex::getDistance(BeliefNode *node1, BeliefNode *node2) {
+    std::vector<double> mean1, mean2;
+    double spread1 = node1->getStateVectorMoments(mean1);
+    double spread2 = node2->getStateVectorMoments(mean2);
+    if (spread1 < 0 || spread2 < 0 || mean1.size() != mean2.size()) {
+        return -1;
+    }
+    return embedding_distance(mean1, spread1, mean2, spread2);
+}
+
+/* ============================ PRIVATE ============================ */
+
+bool BeliefEmbeddingIndex::needsRebuild() const {
+    if (nNodesAtRebuild_ < 0) {
+        return true;
+    }
+    long nNodes = solver_->getPolicy()->getNumberOfNodes();
+    long allowedChange = nNodesAtRebuild_ / 4 + MAX_LEAF_SIZE;
+    return (nNodes > nNodesAtRebuild_ + allowedChange || nNodes < nNodesAtRebuild_ - allowedChange
+            || nQueriesSinceRebuild_ > nNodesAtRebuild_ + allowedChange);
+}
+
+void BeliefEmbeddingIndex::rebuild() {
+    nDimensions_ = 0;
+    points_.clear();
+    nodes_.clear();
+    nodeIds_.clear();
+
+    BeliefTree *tree = solver_->getPolicy();
+    long nNodes = tree->getNumberOfNodes();
+    std::vector<double> mean;
+    for (long id = 0; id < nNodes; id++) {
+        BeliefNode *node = tree->getNode(id);
+        // The tree may have shrunk since the nodes were counted.
+        if (node == nullptr) {
+            break;
+        }
+        double spread = node->getStateVectorMoments(mean);
+        if (spread < 0) {
+            continue;
+        }
+        if (nDimensions_ == 0) {
+            nDimensions_ = mean.size() + 1;
+        } else if (mean.size() + 1 != nDimensions_) {
+            continue;
+        }
+        points_.insert(points_.end(), mean.begin(), mean.end());
+        points_.push_back(spread);
+        nodes_.push_back(node);
+        nodeIds_.push_back(id);
+    }
+
+    order_.resize(nodes_.size());
+    std::iota(order_.begin(), order_.end(), 0);
+    splitDimensions_.assign(nodes_.size(), 0);
+    build(0, order_.size());
+
+    nNodesAtRebuild_ = nNodes;
+    nQueriesSinceRebuild_ = 0;
+}
+
+void BeliefEmbeddingIndex::build(std::size_t begin, std::size_t end) {
+    if (end - begin <= MAX_LEAF_SIZE) {
+        return;
+    }
+    // Split on the dimension in which the points are most spread out.
+    std::size_t splitDimension = 0;
+    double widestRange = -1;
+    for (std::size_t dim = 0; dim < nDimensions_; dim++) {
+        double low = std::numeric_limits<double>::infinity();
+        double high = -low;
+        for (std::size_t i = begin; i < end; i++) {
+            double value = getPoint(order_[i])[dim];
+            low = std::min(low, value);
+            high = std::max(high, value);
+        }
+        if (high - low > widestRange) {
+            widestRange = high - low;
+            splitDimension = dim;
+        }
+    }
+
+    std::size_t middle = begin + (end - begin) / 2;
+    std::nth_element(order_.begin() + begin, order_.begin() + middle, order_.begin() + end,
+            [this, splitDimension] (std::size_t a, std::size_t b) {
+                return getPoint(a)[splitDimension] < getPoint(b)[splitDimension];
+    });
+    splitDimensions_[middle] = splitDimension;
+    build(begin, middle);
+    build(middle + 1, end);
+}
+
+void BeliefEmbeddingIndex::search(std::size_t begin, std::size_t end,
+        std::vector<double> const &query, std::size_t maxCandidates,
+        CandidateQueue &candidates) const {
+    auto consider = [this, &query, maxCandidates, &candidates] (std::size_t index) {
+        double const *point = getPoint(index);
+        double distanceSquared = 0;
+        for (std::size_t dim = 0; dim < nDimensions_; dim++) {
+            distanceSquared += (query[dim] - point[dim]) * (query[dim] - point[dim]);
+        }
+        if (candidates.size() < maxCandidates) {
+            candidates.emplace(distanceSquared, index);
+        } else if (distanceSquared < candidates.top().first) {
+            candidates.pop();
+            candidates.emplace(distanceSquared, index);
+        }
+    };
+
+    if (end - begin <= MAX_LEAF_SIZE) {
+        for (std::size_t i = begin; i < end; i++) {
+            consider(order_[i]);
+        }
+        return;
+    }
+
+    std::size_t middle = begin + (end - begin) / 2;
+    std::size_t splitDimension = splitDimensions_[middle];
+    consider(order_[middle]);
+    double difference = query[splitDimension] - getPoint(order_[middle])[splitDimension];
+    // Search the side the query is on first; the other side only needs to be searched if it
+    // could hold a point nearer than the current candidates.
+    if (difference < 0) {
+        search(begin, middle, query, maxCandidates, candidates);
+    } else {
+        search(middle + 1, end, query, maxCandidates, candidates);
+    }
+    if (candidates.size() < maxCandidates
+            || difference * difference < candidates.top().first) {
+        if (difference < 0) {
+            search(middle + 1, end, query, maxCandidates, candidates);
+        } else {
+            search(begin, middle, query, maxCandidates, candidates);
+        }
+    }
+}
+
+double const *BeliefEmbeddingIndex::getPoint(std::size_t index) const {
+    return &points_[index * nDimensions_];
+}
+} /* namespace solver */
@@ -0,0 +1,94 @@
+/** @file BeliefEmbeddingIndex.hpp
+ *
+ * Contains the BeliefEmbeddingIndex class, which finds belief nodes that are similar to a given
+ * belief node, based on a compact summary of the state vectors of their particles.
+ */
+#ifndef SOLVER_BELIEFEMBEDDINGINDEX_HPP_
+#define SOLVER_BELIEFEMBEDDINGINDEX_HPP_
+
+#include <cstddef>                      // for size_t
+#include <queue>                        // for priority_queue
+#include <utility>                      // for pair
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+namespace solver {
+class BeliefNode;
+class Solver;
+
+/** An index of the belief nodes in a solver's tree, for finding approximate nearest neighbors.
+ *
+ * Each belief is embedded as the mean of the state vectors of its particles, together with their
+ * spread (see BeliefNode::getStateVectorMoments()); this requires the states to be VectorStates.
+ * The distance between two beliefs is the root-mean-square distance between pairs of their
+ * particles, which can be worked out exactly from the embeddings as
+ * sqrt(|mean1 - mean2|^2 + spread1^2 + spread2^2); this is an upper bound on the average
+ * pairwise distance used by BeliefNode::distL1Independent().
+ *
+ * The embeddings are kept in a k-d tree, which is rebuilt once the number of nodes in the tree
+ * has changed substantially, or after as many queries as there are nodes; this keeps the cost of
+ * rebuilding at logarithmic time per query. Since the embeddings change as particles are added,
+ * the k-d tree is only used to pick candidates, which are then compared using their current
+ * embeddings.
+ */
+class BeliefEmbeddingIndex {
+public:
+    /** Creates a new index for the belief tree of the given solver. */
+    BeliefEmbeddingIndex(Solver *solver);
+    ~BeliefEmbeddingIndex() = default;
+    _NO_COPY_OR_MOVE(BeliefEmbeddingIndex);
+
+    /** Returns the node nearest to the given node among the given number of candidates that were
+     * nearest when the index was last rebuilt, and sets distance to its distance from the given
+     * node. Returns nullptr if there is no such node, or if the node has no embedding.
+     */
+    BeliefNode *findNearest(BeliefNode *node, long maxCandidates, double &distance);
+
+    /** Returns the distance between the two given nodes, or a negative number if either of them
+     * has no embedding.
+     */
+    static double getDistance(BeliefNode *node1, BeliefNode *node2);
+
+private:
+    /** A candidate for a nearest neighbor - the squared distance, and the index of the point. */
+    typedef std::pair<double, std::size_t> Candidate;
+    /** The best candidates found so far, with the farthest at the top. */
+    typedef std::priority_queue<Candidate> CandidateQueue;
+
+    /** Returns true iff the index should be rebuilt before the next query. */
+    bool needsRebuild() const;
+    /** Rebuilds the index from the current nodes of the tree. */
+    void rebuild();
+    /** Builds the k-d tree over the given range of order_. */
+    void build(std::size_t begin, std::size_t end);
+    /** Searches the k-d tree over the given range of order_ for the points nearest to the given
+     * query point.
+     */
+    void search(std::size_t begin, std::size_t end, std::vector<double> const &query,
+            std::size_t maxCandidates, CandidateQueue &candidates) const;
+    /** Returns a pointer to the coordinates of the point with the given index. */
+    double const *getPoint(std::size_t index) const;
+
+    /** The solver whose tree this indexes. */
+    Solver *solver_;
+    /** The number of dimensions of each point - the state vector, followed by the spread. */
+    std::size_t nDimensions_;
+    /** The coordinates of all of the points, one after another. */
+    std::vector<double> points_;
+    /** The node for each point. */
+    std::vector<BeliefNode *> nodes_;
+    /** The ID of the node for each point, at the time the index was built. */
+    std::vector<long> nodeIds_;
+    /** The points in k-d tree order - each range is split at its middle element. */
+    std::vector<std::size_t> order_;
+    /** The dimension each range is split on, stored at the position of its middle element. */
+    std::vector<std::size_t> splitDimensions_;
+    /** The number of nodes in the tree when the index was last rebuilt. */
+    long nNodesAtRebuild_;
+    /** The number of queries since the index was last rebuilt. */
+    long nQueriesSinceRebuild_;
+};
+} /* namespace solver */
+
+#endif /* SOLVER_BELIEFEMBEDDINGINDEX_HPP_ */
@@ -0,0 +1,269 @@
+/** @file indexing/PackedRTree.cpp
+ *
+ * Contains the implementation of the PackedRTree class.
+ */
+#include "solver/indexing/PackedRTree.hpp"
+
+#include <algorithm>                    // for min, max, sort
+#include <cmath>                        // for ceil, pow
+#include <cstddef>                      // for size_t
+#include <numeric>                      // for iota
+#include <utility>                      // for move
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+#include "solver/StateInfo.hpp"
+
+#include "solver/abstract-problem/VectorState.hpp"
+#include "solver/indexing/SpatialIndexVisitor.hpp"
+
+namespace solver {
+namespace {
+/** The number of entries in each leaf, and the number of children of each node above them. */
+std::size_t const NODE_SIZE = 16;
+} /* namespace */
+
+PackedRTree::PackedRTree(unsigned int nSDim) :
+        StateIndex(),
+        nSDim_(nSDim),
+        points_(),
+        infos_(),
+        entriesById_(),
+        nPacked_(0),
+        nRemoved_(0),
+        levels_() {
+}
+
+void PackedRTree::reset() {
+    points_.clear();
+    infos_.clear();
+    entriesById_.clear();
+    nPacked_ = 0;
+    nRemoved_ = 0;
+    levels_.clear();
+}
+
+void PackedRTree::addStateInfo(StateInfo *stateInfo) {
+    std::vector<double> vectorData = static_cast<VectorState const *>(
+            stateInfo->getState())->asVector();
+    long id = stateInfo->getId();
+    if (id >= static_cast<long>(entriesById_.size())) {
+        entriesById_.resize(id + 1, -1);
+    }
+    entriesById_[id] = infos_.size();
+    points_.insert(points_.end(), vectorData.begin(), vectorData.begin() + nSDim_);
+    infos_.push_back(stateInfo);
+}
+
+void PackedRTree::removeStateInfo(StateInfo *stateInfo) {
+    long id = stateInfo->getId();
+    if (id < 0 || id >= static_cast<long>(entriesById_.size()) || entriesById_[id] < 0) {
+        debug::show_message("ERROR: Removing a state that isn't in the index!");
+        return;
+    }
+    std::size_t entry = entriesById_[id];
+    entriesById_[id] = -1;
+    if (entry < nPacked_) {
+        // The tree stays as it is until it is packed again.
+        infos_[entry] = nullptr;
+        nRemoved_++;
+        return;
+    }
+
+    // A new entry can simply be replaced by the last one.
+    std::size_t last = infos_.size() - 1;
+    if (entry != last) {
+        infos_[entry] = infos_[last];
+        std::copy(points_.begin() + last * nSDim_, points_.end(),
+                points_.begin() + entry * nSDim_);
+        entriesById_[infos_[entry]->getId()] = entry;
+    }
+    infos_.pop_back();
+    points_.resize(last * nSDim_);
+}
+
+void PackedRTree::boxQuery(SpatialIndexVisitor &visitor, std::vector<double> lowCorner,
+        std::vector<double> highCorner) {
+    std::vector<QueryBox> boxes;
+    boxes.push_back(QueryBox { std::move(lowCorner), std::move(highCorner), &visitor });
+    boxQueries(boxes);
+}
+
+void PackedRTree::boxQueries(std::vector<QueryBox> const &boxes) {
+    if (boxes.empty()) {
+        return;
+    }
+    if (needsRebuild()) {
+        rebuild();
+    }
+
+    // Copy the corners of the boxes into one array, in the same layout as the nodes.
+    std::vector<double> corners;
+    corners.reserve(2 * nSDim_ * boxes.size());
+    for (QueryBox const &box : boxes) {
+        corners.insert(corners.end(), box.lowCorner.begin(), box.lowCorner.begin() + nSDim_);
+        corners.insert(corners.end(), box.highCorner.begin(), box.highCorner.begin() + nSDim_);
+    }
+
+    // The last list holds every box, for the root and for the new entries.
+    std::vector<std::vector<std::size_t>> active(levels_.size() + 1);
+    active.back().resize(boxes.size());
+    std::iota(active.back().begin(), active.back().end(), 0);
+    if (!levels_.empty()) {
+        query(levels_.size() - 1, 0, corners, boxes, active);
+    }
+    for (std::size_t entry = nPacked_; entry < infos_.size(); entry++) {
+        visitEntry(entry, corners, boxes, active.back());
+    }
+}
+
+/* ============================ PRIVATE ============================ */
+
+bool PackedRTree::needsRebuild() const {
+    std::size_t nChanged = infos_.size() - nPacked_ + nRemoved_;
+    return nChanged > nPacked_ / 4 + NODE_SIZE;
+}
+
+void PackedRTree::rebuild() {
+    std::vector<std::size_t> order;
+    order.reserve(infos_.size() - nRemoved_);
+    for (std::size_t entry = 0; entry < infos_.size(); entry++) {
+        if (infos_[entry] != nullptr) {
+            order.push_back(entry);
+        }
+    }
+    sortTiles(order, 0, order.size(), 0);
+
+    // Move the entries into their new order.
+    std::vector<double> points;
+    points.reserve(order.size() * nSDim_);
+    std::vector<StateInfo *> infos;
+    infos.reserve(order.size());
+    for (std::size_t entry : order) {
+        entriesById_[infos_[entry]->getId()] = infos.size();
+        points.insert(points.end(), getPoint(entry), getPoint(entry) + nSDim_);
+        infos.push_back(infos_[entry]);
+    }
+    points_.swap(points);
+    infos_.swap(infos);
+    nPacked_ = infos_.size();
+    nRemoved_ = 0;
+
+    // Each leaf covers a run of entries, and each node above it covers a run of the nodes below.
+    levels_.clear();
+    if (nPacked_ == 0) {
+        return;
+    }
+    std::size_t nChildren = nPacked_;
+    do {
+        std::size_t nNodes = (nChildren + NODE_SIZE - 1) / NODE_SIZE;
+        std::vector<double> boxes(2 * nSDim_ * nNodes);
+        for (std::size_t node = 0; node < nNodes; node++) {
+            double *low = &boxes[2 * nSDim_ * node];
+            double *high = low + nSDim_;
+            std::size_t end = std::min(nChildren, (node + 1) * NODE_SIZE);
+            for (std::size_t child = node * NODE_SIZE; child < end; child++) {
+                double const *childLow = (levels_.empty() ? getPoint(child)
+                        : &levels_.back()[2 * nSDim_ * child]);
+                double const *childHigh = (levels_.empty() ? childLow : childLow + nSDim_);
+                for (std::size_t dim = 0; dim < nSDim_; dim++) {
+                    if (child == node * NODE_SIZE) {
+                        low[dim] = childLow[dim];
+                        high[dim] = childHigh[dim];
+                    } else {
+                        low[dim] = std::min(low[dim], childLow[dim]);
+                        high[dim] = std::max(high[dim], childHigh[dim]);
+                    }
+                }
+            }
+        }
+        levels_.push_back(std::move(boxes));
+        nChildren = nNodes;
+    } while (nChildren > 1);
+}
+
+void PackedRTree::sortTiles(std::vector<std::size_t> &order, std::size_t begin, std::size_t end,
+        std::size_t dim) {
+    std::sort(order.begin() + begin, order.begin() + end,
+            [this, dim] (std::size_t a, std::size_t b) {
+                return getPoint(a)[dim] < getPoint(b)[dim];
+    });
+    std::size_t nEntries = end - begin;
+    if (dim + 1 >= nSDim_ || nEntries <= NODE_SIZE) {
+        return;
+    }
+
+    // Cut the range into slabs of whole leaves, so that each of the remaining dimensions is cut
+    // into the same number of slabs.
+    std::size_t nLeaves = (nEntries + NODE_SIZE - 1) / NODE_SIZE;
+    std::size_t nSlabs = std::ceil(std::pow(nLeaves, 1.0 / (nSDim_ - dim)));
+    std::size_t slabSize = (nLeaves + nSlabs - 1) / nSlabs * NODE_SIZE;
+    for (std::size_t slabBegin = begin; slabBegin < end; slabBegin += slabSize) {
+        sortTiles(order, slabBegin, std::min(end, slabBegin + slabSize), dim + 1);
+    }
+}
+
+void PackedRTree::query(std::size_t level, std::size_t node, std::vector<double> const &corners,
+        std::vector<QueryBox> const &boxes, std::vector<std::vector<std::size_t>> &active) {
+    // Keep only the boxes from the parent's list that intersect this node.
+    double const *nodeLow = &levels_[level][2 * nSDim_ * node];
+    double const *nodeHigh = nodeLow + nSDim_;
+    std::vector<std::size_t> &nodeActive = active[level];
+    nodeActive.clear();
+    for (std::size_t index : active[level + 1]) {
+        double const *low = &corners[2 * nSDim_ * index];
+        double const *high = low + nSDim_;
+        bool intersects = true;
+        for (std::size_t dim = 0; dim < nSDim_; dim++) {
+            if (low[dim] > nodeHigh[dim] || high[dim] < nodeLow[dim]) {
+                intersects = false;
+                break;
+            }
+        }
+        if (intersects) {
+            nodeActive.push_back(index);
+        }
+    }
+    if (nodeActive.empty()) {
+        return;
+    }
+
+    std::size_t nChildren = (level == 0 ? nPacked_ : levels_[level - 1].size() / (2 * nSDim_));
+    std::size_t end = std::min(nChildren, (node + 1) * NODE_SIZE);
+    for (std::size_t child = node * NODE_SIZE; child < end; child++) {
+        if (level == 0) {
+            visitEntry(child, corners, boxes, nodeActive);
+        } else {
+            query(level - 1, child, corners, boxes, active);
+        }
+    }
+}
+
+void PackedRTree::visitEntry(std::size_t entry, std::vector<double> const &corners,
+        std::vector<QueryBox> const &boxes, std::vector<std::size_t> const &active) {
+    StateInfo *info = infos_[entry];
+    if (info == nullptr) {
+        return;
+    }
+    double const *point = getPoint(entry);
+    for (std::size_t index : active) {
+        double const *low = &corners[2 * nSDim_ * index];
+        double const *high = low + nSDim_;
+        bool isInside = true;
+        for (std::size_t dim = 0; dim < nSDim_; dim++) {
+            if (point[dim] < low[dim] || point[dim] > high[dim]) {
+                isInside = false;
+                break;
+            }
+        }
+        if (isInside) {
+            boxes[index].visitor->visit(info);
+        }
+    }
+}
+
+double const *PackedRTree::getPoint(std::size_t entry) const {
+    return &points_[entry * nSDim_];
+}
+} /* namespace solver */
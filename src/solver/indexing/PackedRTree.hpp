@@ -0,0 +1,120 @@
+/** @file indexing/PackedRTree.hpp
+ *
+ * Contains the PackedRTree class, which is an implementation of the StateIndex interface that
+ * keeps the state vectors in a bulk-loaded R-tree, without using libspatialindex.
+ */
+#ifndef SOLVER_PACKEDRTREE_HPP_
+#define SOLVER_PACKEDRTREE_HPP_
+
+#include <cstddef>                      // for size_t
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+#include "solver/indexing/StateIndex.hpp"
+
+namespace solver {
+class SpatialIndexVisitor;
+class StateInfo;
+
+/** An R-tree over the state vectors, which is packed using the Sort-Tile-Recursive (STR)
+ * algorithm of Leutenegger et al. ("STR: a simple and efficient algorithm for R-tree packing",
+ * 1997).
+ *
+ * The state vectors are stored one after another in a flat array, in the order of the leaves of
+ * the tree; each leaf is a run of consecutive entries, and each node at the next level up covers
+ * a run of consecutive nodes at the level below, so the tree itself is just an array of bounding
+ * boxes for each level.
+ *
+ * Adding a state only appends it to the end of the array, and removing a state only marks its
+ * entry as empty. The new entries are checked one by one in each query, and the tree is packed
+ * again before a query once the number of new and empty entries is large compared to the size of
+ * the tree; this means that building up the index costs amortized logarithmic time per state,
+ * and nothing at all until the first query.
+ *
+ * As for RTree, the query methods pass each StateInfo within the given boxes onto a visitor.
+ * boxQueries() handles many boxes in a single traversal of the tree, which is much faster than
+ * querying them one at a time when they overlap the same parts of the tree.
+ */
+class PackedRTree : public StateIndex {
+  public:
+    /** A box to query, together with the visitor for the states inside it. */
+    struct QueryBox {
+        /** The lowest corner of the box. */
+        std::vector<double> lowCorner;
+        /** The highest corner of the box. */
+        std::vector<double> highCorner;
+        /** The visitor to pass the states inside the box onto. */
+        SpatialIndexVisitor *visitor;
+    };
+
+    /** Constructs a new PackedRTree with the given number of state dimensions. */
+    PackedRTree(unsigned int nSDim);
+    virtual ~PackedRTree() = default;
+    _NO_COPY_OR_MOVE(PackedRTree);
+
+    /** Resets this PackedRTree, making it empty. */
+    virtual void reset() override;
+
+    /** Adds the given StateInfo to this PackedRTree.
+     * NOTE: the same StateInfo / same ID must not have been added since the last reset.
+     */
+    virtual void addStateInfo(StateInfo *stateInfo) override;
+
+    /** Removes the given StateInfo from this PackedRTree; it must have the same ID it had when
+     * it was added.
+     */
+    virtual void removeStateInfo(StateInfo *stateInfo) override;
+
+    /** Performs a range query on the tree. All StateInfo that are within the given box (including
+     * its boundary) will be passed on to the given visitor.
+     */
+    void boxQuery(SpatialIndexVisitor &visitor, std::vector<double> lowCorner,
+            std::vector<double> highCorner);
+
+    /** Performs a range query for each of the given boxes in a single traversal of the tree.
+     * This visits the same states as calling boxQuery() for each box in turn, so a state inside
+     * two of the boxes is visited twice, but the order of the visits is different.
+     */
+    void boxQueries(std::vector<QueryBox> const &boxes);
+
+  private:
+    /** Returns true iff the tree should be packed again before the next query. */
+    bool needsRebuild() const;
+    /** Packs all of the current entries into a new tree. */
+    void rebuild();
+    /** Sorts the given range of entries into STR order, starting from the given dimension. */
+    void sortTiles(std::vector<std::size_t> &order, std::size_t begin, std::size_t end,
+            std::size_t dim);
+
+    /** Visits the states in the given node at the given level that are inside the given boxes;
+     * active holds the indices of the boxes that intersect the node.
+     */
+    void query(std::size_t level, std::size_t node, std::vector<double> const &corners,
+            std::vector<QueryBox> const &boxes, std::vector<std::vector<std::size_t>> &active);
+    /** Visits the state in the given entry if it is inside any of the given boxes. */
+    void visitEntry(std::size_t entry, std::vector<double> const &corners,
+            std::vector<QueryBox> const &boxes, std::vector<std::size_t> const &active);
+    /** Returns a pointer to the coordinates of the given entry. */
+    double const *getPoint(std::size_t entry) const;
+
+    /** The number of state dimensions for this tree. */
+    std::size_t nSDim_;
+    /** The coordinates of each entry, one after another. */
+    std::vector<double> points_;
+    /** The StateInfo for each entry, or nullptr if it has been removed. */
+    std::vector<StateInfo *> infos_;
+    /** The entry for each StateInfo, by ID, or -1 if it isn't in the tree. */
+    std::vector<long> entriesById_;
+    /** The number of entries in the packed part of the array; the rest are new. */
+    std::size_t nPacked_;
+    /** The number of packed entries that have been removed. */
+    std::size_t nRemoved_;
+    /** The bounding boxes of the nodes at each level, from the leaves up to the root; each box is
+     * its lowest corner followed by its highest corner.
+     */
+    std::vector<std::vector<double>> levels_;
+};
+} /* namespace solver */
+
+#endif /* SOLVER_PACKEDRTREE_HPP_ */
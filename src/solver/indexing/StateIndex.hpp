@@ -2,10 +2,10 @@
  *
  * Defines an interface allowing states to be indexed in a custom manner.
  *
- * Currently the only provided implementation of this interface is the RTree, which is a wrapper
- * for the RTree class within libspatialindex.
+ * Two implementations of this interface are provided - the PackedRTree, which is used by default,
+ * and the RTree, which is a wrapper for the RTree class within libspatialindex.
  *
- * The RTree-based approach should be sufficient for most purposes, but you can easily make your
+ * The R-tree-based approach should be sufficient for most purposes, but you can easily make your
  * own implementation of this interface if need be.
  */
 #ifndef SOLVER_STATEINDEX_HPP_
@@ -0,0 +1,107 @@
+/** @file ActionMapping.cpp
+ *
+ * Contains the non-abstract methods of ActionMapping, including the default implementations of
+ * the entry selection methods.
+ */
+#include "solver/mappings/actions/ActionMapping.hpp"
+
+#include <cmath>                        // for log, sqrt, isfinite
+#include <limits>                       // for numeric_limits
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+#include "solver/ActionNode.hpp"
+
+#include "solver/mappings/actions/ActionMappingEntry.hpp"
+
+namespace solver {
+std::vector<ActionMappingEntry const *> ActionMapping::getChildEntries() const {
+    std::vector<ActionMappingEntry const *> entries;
+    forEachChildEntry([&entries] (ActionMappingEntry const *entry) {
+        entries.push_back(entry);
+    });
+    return entries;
+}
+
+std::vector<ActionMappingEntry const *> ActionMapping::getVisitedEntries() const {
+    std::vector<ActionMappingEntry const *> entries;
+    forEachVisitedEntry([&entries] (ActionMappingEntry const *entry) {
+        entries.push_back(entry);
+    });
+    return entries;
+}
+
+double ActionMapping::getTotalQValue() const {
+    double totalQValue = 0;
+    forEachVisitedEntry([&totalQValue] (ActionMappingEntry const *entry) {
+        totalQValue += entry->getTotalQValue();
+    });
+    return totalQValue;
+}
+
+ActionMappingEntry const *ActionMapping::getMaxQEntry() const {
+    ActionMappingEntry const *maxEntry = nullptr;
+    double maxQValue = -std::numeric_limits<double>::infinity();
+    forEachVisitedEntry([&maxEntry, &maxQValue] (ActionMappingEntry const *entry) {
+        double qValue = entry->getMeanQValue();
+        if (qValue > maxQValue) {
+            maxQValue = qValue;
+            maxEntry = entry;
+        }
+    });
+    return maxEntry;
+}
+
+ActionMappingEntry const *ActionMapping::getRobustEntry() const {
+    ActionMappingEntry const *robustEntry = nullptr;
+    long maxVisitCount = 0;
+    double robustQValue = -std::numeric_limits<double>::infinity();
+    forEachVisitedEntry([&] (ActionMappingEntry const *entry) {
+        long visitCount = entry->getVisitCount();
+        double qValue = entry->getMeanQValue();
+        if (visitCount > maxVisitCount) {
+            maxVisitCount = visitCount;
+            robustQValue = qValue;
+            robustEntry = entry;
+        } else if (visitCount == maxVisitCount && qValue > robustQValue) {
+            robustQValue = qValue;
+            robustEntry = entry;
+        }
+    });
+    return robustEntry;
+}
+
+ActionMappingEntry const *ActionMapping::getUcbEntry(double explorationCoefficient,
+        double virtualLoss) const {
+    ActionMappingEntry const *ucbEntry = nullptr;
+    double maxUcbValue = -std::numeric_limits<double>::infinity();
+    double logTotalVisits = std::log(getTotalVisitCount());
+    forEachVisitedEntry([&] (ActionMappingEntry const *entry) {
+        // Ignore illegal actions.
+        if (!entry->isLegal()) {
+            return;
+        }
+
+        double visitCount = entry->getVisitCount();
+        double meanQValue = entry->getMeanQValue();
+        ActionNode const *actionNode = entry->getActionNode();
+        if (actionNode != nullptr && actionNode->getVirtualLossCount() > 0) {
+            double nLosses = actionNode->getVirtualLossCount();
+            meanQValue -= nLosses * virtualLoss / (visitCount + nLosses);
+            visitCount += nLosses;
+        }
+
+        double tmpValue = meanQValue
+                + explorationCoefficient * std::sqrt(logTotalVisits / visitCount);
+        if (!std::isfinite(tmpValue)) {
+            debug::show_message("ERROR: Infinite/NaN value!?");
+        }
+        if (maxUcbValue < tmpValue) {
+            maxUcbValue = tmpValue;
+            ucbEntry = entry;
+        }
+    });
+    return ucbEntry;
+}
+} /* namespace solver */
@@ -12,7 +12,12 @@
 #ifndef SOLVER_ACTIONMAPPING_HPP_
 #define SOLVER_ACTIONMAPPING_HPP_
 
+#include <vector>                       // for vector
+
 #include "global.hpp"
+#include "FunctionRef.hpp"
+
+#include "solver/SlabAllocator.hpp"
 
 #include "solver/abstract-problem/Action.hpp"
 
@@ -29,7 +34,7 @@ class BeliefNode;
  * Each of these edges must also store the statistics for that edge - most notably, the visit
  * count and estimated Q-value.
  */
-class ActionMapping {
+class ActionMapping : public SlabAllocated {
 public:
     /** Creates a new ActionMapping, which will be owned by the given belief node. */
     ActionMapping(BeliefNode *owner) :
@@ -52,12 +57,27 @@ public:
     /** Returns the number of child action nodes owned by this mapping. */
     virtual long getNChildren() const = 0;
 
-    /** Deletes the child in the given entry, as well as the entire corresponding subtree. */
-    virtual void deleteChild(ActionMappingEntry const *entry) = 0;
+    /** Deletes the child in the given entry, as well as the entire corresponding subtree.
+     *
+     * The child is removed from this mapping and returned, so the caller can choose when to free
+     * it; if the return value is ignored, it is freed straight away.
+     */
+    virtual std::unique_ptr<ActionNode> deleteChild(ActionMappingEntry const *entry) = 0;
 
     /* -------------- Retrieval of mapping entries. ---------------- */
-    /** Returns all entries in this mapping that have a child node associated with them. */
-    virtual std::vector<ActionMappingEntry const *> getChildEntries() const = 0;
+    /** Calls the given function on each entry in this mapping that has a child node associated
+     * with it.
+     *
+     * Unlike getChildEntries(), this never allocates any memory. The function must not add or
+     * delete any entries of this mapping.
+     */
+    virtual void forEachChildEntry(
+            tapir::FunctionRef<void(ActionMappingEntry const *)> function) const = 0;
+    /** Returns all entries in this mapping that have a child node associated with them.
+     *
+     * This is a copy, so entries can safely be deleted while iterating over it.
+     */
+    std::vector<ActionMappingEntry const *> getChildEntries() const;
 
 
     /** Returns the number of entries in this mapping with a nonzero visit count.
@@ -68,12 +88,15 @@ public:
      */
     virtual long getNumberOfVisitedEntries() const = 0;
 
-    /** Returns a vector of all of the visited entries in this mapping.
+    /** Calls the given function on each of the visited entries in this mapping.
      *
      * Some of those entries might have null action nodes if the visit counts were initialized
-     * with nonzero values.
+     * with nonzero values. Unlike getVisitedEntries(), this never allocates any memory.
      */
-    virtual std::vector<ActionMappingEntry const *> getVisitedEntries() const = 0;
+    virtual void forEachVisitedEntry(
+            tapir::FunctionRef<void(ActionMappingEntry const *)> function) const = 0;
+    /** Returns a vector of all of the visited entries in this mapping. */
+    std::vector<ActionMappingEntry const *> getVisitedEntries() const;
 
     /** Returns the mapping entry associated with the given action, or nullptr if there is none. */
     virtual ActionMappingEntry *getEntry(Action const &action) = 0;
@@ -88,12 +111,43 @@ public:
     /* ------------------ Methods for unvisited actions ------------------- */
     /** Returns the next unvisited action to be tried for this node, or nullptr if there are no
      * more unvisited actions (that are legal).
+     *
+     * The returned action is claimed by the caller, so that other search threads holding the
+     * node's mutex afterwards are given a different one; it is only offered again if its visit
+     * count goes back to zero.
      */
     virtual std::unique_ptr<Action> getNextActionToTry() = 0;
 
     /* -------------- Retrieval of general statistics. ---------------- */
     /** Returns the total number of times children of this mapping have been visited. */
     virtual long getTotalVisitCount() const = 0;
+    /** Returns the sum of the total Q-values of the visited entries in this mapping.
+     *
+     * The default implementation adds them up via forEachVisitedEntry(); mappings that keep a
+     * running total should override this.
+     */
+    virtual double getTotalQValue() const;
+
+    /* ------------------ Selection of entries ------------------- */
+    /** Returns the visited entry with the highest mean Q-value, or nullptr if no entries have
+     * been visited; ties go to the entry that forEachVisitedEntry() visits first.
+     *
+     * The default implementation uses forEachVisitedEntry(); mappings that can do better
+     * should override this and the methods below.
+     */
+    virtual ActionMappingEntry const *getMaxQEntry() const;
+    /** Returns the visited entry with the highest visit count, with ties broken by the mean
+     * Q-value, or nullptr if no entries have been visited.
+     */
+    virtual ActionMappingEntry const *getRobustEntry() const;
+    /** Returns the legal visited entry with the highest UCB value, using the given exploration
+     * coefficient, or nullptr if there is none.
+     *
+     * Each virtual loss on an action (see ActionNode::getVirtualLossCount) counts as an extra
+     * visit with a value of virtualLoss below the current mean.
+     */
+    virtual ActionMappingEntry const *getUcbEntry(double explorationCoefficient,
+            double virtualLoss) const;
 
 private:
     /** The belief node that owns this mapping. */
@@ -9,6 +9,8 @@
 #ifndef SOLVER_ACTIONMAPPINGENTRY_HPP_
 #define SOLVER_ACTIONMAPPINGENTRY_HPP_
 
+#include "solver/SlabAllocator.hpp"
+
 #include "solver/abstract-problem/Action.hpp"
 
 namespace solver {
@@ -22,7 +24,7 @@ class ActionMapping;
  * update(), which updates the visit count and/or Q-value for this edge, and
  * setLegal(), which allows this edge to be made legal or illegal.
  */
-class ActionMappingEntry {
+class ActionMappingEntry : public SlabAllocated {
 public:
     ActionMappingEntry() = default;
     virtual ~ActionMappingEntry() = default;
@@ -31,6 +33,17 @@ public:
     virtual ActionMapping *getMapping() const = 0;
     /** Returns the action for this entry. */
     virtual std::unique_ptr<Action> getAction() const = 0;
+    /** Returns the action for this entry without copying it, or nullptr if this entry doesn't
+     * keep a single fixed action (e.g. if getAction() samples a new action each time), in which
+     * case getAction() must be used instead.
+     *
+     * The returned action remains valid for as long as this entry exists.
+     *
+     * The default implementation returns nullptr.
+     */
+    virtual Action const *peekAction() const {
+        return nullptr;
+    }
     /** Returns the action node for this entry. */
     virtual ActionNode *getActionNode() const = 0;
     /** Returns the visit count for this entry. */
@@ -34,7 +34,12 @@ class ActionPool {
 public:
     ActionPool() = default;
     virtual ~ActionPool() = default;
-    /** Creates an action mapping for the given belief node. */
+    /** Creates an action mapping for the given belief node.
+     *
+     * The search only creates mappings while holding the tree's node creation mutex, but pruned
+     * mappings are destroyed by the TreeReclaimer in the background, so a pool that keeps track
+     * of its mappings must guard that itself.
+     */
     virtual std::unique_ptr<ActionMapping> createActionMapping(BeliefNode *node) = 0;
 };
 } /* namespace solver */
@@ -62,12 +62,18 @@ std::vector<ActionMappingEntry const*> ContinuousActionContainerBase::getEntries
 	return std::move(result);
 }
 
+void ContinuousActionContainerBase::forEachEntry(tapir::FunctionRef<void(ContinuousActionMapEntry const*)> function) const {
+	for (ActionMappingEntry const* entry : getEntries()) {
+		function(static_cast<ContinuousActionMapEntry const*>(entry));
+	}
+}
+
 
 
 
 /* ---------------------- ContinuousActionPool ---------------------- */
 std::unique_ptr<ActionMapping> ContinuousActionPool::createActionMapping(BeliefNode *node) {
-    return std::make_unique<ContinuousActionMap>(node, this);
+    return allocate_unique<ContinuousActionMap>(node->getAllocator(), node, this);
 }
 
 std::unique_ptr<Action> ContinuousActionPool::createAction(const double* constructionDataVector, const BeliefNode* belief) const {
@@ -122,7 +128,7 @@ ContinuousActionMap::ContinuousActionMap(BeliefNode *owner, ContinuousActionPool
 	for (std::unique_ptr<ContinuousActionConstructionDataBase>& constructionData : fixed) {
 		auto& storage = (*entries)[*constructionData];
 		if (storage == nullptr) {
-		  storage = std::make_unique<ThisActionMapEntry>(this, std::move(constructionData), true);
+		  storage = allocate_unique<ThisActionMapEntry>(owner->getAllocator(), this, std::move(constructionData), true);
 		}
 		fixedEntries.push_back(storage.get());
 	}
@@ -144,7 +150,7 @@ ActionNode* ContinuousActionMap::createActionNode(Action const &baseAction) {
 
 	ThisActionMapEntry* entry = entries->at(action.getConstructionData()).get();
 
-	std::unique_ptr<ActionNode> actionNode = std::make_unique<ActionNode>(entry);
+	std::unique_ptr<ActionNode> actionNode = allocate_unique<ActionNode>(getOwner()->getAllocator(), entry);
 	ActionNode *node = actionNode.get();
 	entry->setChild(std::move(actionNode));
 
@@ -157,13 +163,18 @@ long ContinuousActionMap::getNChildren() const {
 	return nChildren;
 }
 
-void ContinuousActionMap::deleteChild(ActionMappingEntry const *entry) {
+std::unique_ptr<ActionNode> ContinuousActionMap::deleteChild(ActionMappingEntry const *entry) {
 	ThisActionMapEntry &discEntry = const_cast<ThisActionMapEntry &>(static_cast<ThisActionMapEntry const &>(*entry));
-	discEntry.deleteChild();
+	return discEntry.deleteChild();
 }
 
-std::vector<ActionMappingEntry const *> ContinuousActionMap::getChildEntries() const  {
-	return entries->getEntriesWithChildren();
+void ContinuousActionMap::forEachChildEntry(
+		tapir::FunctionRef<void(ActionMappingEntry const *)> function) const {
+	entries->forEachEntry([&function](ContinuousActionMapEntry const* entry) {
+		if (entry->getChild() != nullptr) {
+			function(entry);
+		}
+	});
 }
 
 
@@ -171,8 +182,16 @@ long ContinuousActionMap::getNumberOfVisitedEntries() const {
 	return numberOfVisitedEntries;
 }
 
-std::vector<ActionMappingEntry const *> ContinuousActionMap::getVisitedEntries() const {
-	return entries->getEntriesWithNonzeroVisitCount();
+void ContinuousActionMap::forEachVisitedEntry(
+		tapir::FunctionRef<void(ActionMappingEntry const *)> function) const {
+	entries->forEachEntry([&function](ContinuousActionMapEntry const* entry) {
+		if (entry->getVisitCount() > 0) {
+			if (!entry->isLegal()) {
+				debug::show_message("WARNING: Illegal entry with nonzero visit count!");
+			}
+			function(entry);
+		}
+	});
 }
 
 ActionMappingEntry *ContinuousActionMap::getEntry(Action const &baseAction) {
@@ -193,7 +212,7 @@ ContinuousActionMap::ThisActionMapEntry* ContinuousActionMap::getActionMapEntry(
 ContinuousActionMap::ThisActionMapEntry* ContinuousActionMap::createOrGetActionMapEntry(const double* constructionDataVector) {
 	auto& entry = (*entries)[constructionDataVector];
 	if (entry == nullptr) {
-		entry = std::make_unique<ThisActionMapEntry>(this, pool->createActionConstructionData(constructionDataVector, getOwner()), true);
+		entry = allocate_unique<ThisActionMapEntry>(getOwner()->getAllocator(), this, pool->createActionConstructionData(constructionDataVector, getOwner()), true);
 	}
 	return entry.get();
 }
@@ -209,6 +228,10 @@ long ContinuousActionMap::getTotalVisitCount() const {
 	return totalVisitCount;
 }
 
+double ContinuousActionMap::getTotalQValue() const {
+	return totalQValue;
+}
+
 std::unique_ptr<Action> ContinuousActionMap::getNextActionToTry() {
 	class NoNextActionToTry: public std::exception {
 		virtual const char* what() const noexcept {
@@ -276,6 +299,7 @@ bool ContinuousActionMapEntry::update(long deltaNVisits, double deltaTotalQ) {
 
 	// Update the total Q
 	totalQValue_ += deltaTotalQ;
+	map->totalQValue += deltaTotalQ;
 
 	// Update the mean Q
 	double oldMeanQ = meanQValue_;
@@ -297,8 +321,8 @@ void ContinuousActionMapEntry::setChild(std::unique_ptr<ActionNode>&& child) {
 	childNode = std::move(child);
 }
 
-void ContinuousActionMapEntry::deleteChild() {
-	childNode.reset();
+std::unique_ptr<ActionNode> ContinuousActionMapEntry::deleteChild() {
+	return std::move(childNode);
 }
 
 const ActionNode* ContinuousActionMapEntry::getChild() const {
@@ -394,6 +418,7 @@ void ContinuousActionTextSerializer::loadActionMapping(ContinuousActionMap &map,
     		}
     		storage = std::move(entry);
     	}
+    	map.totalQValue = map.ActionMapping::getTotalQValue();
     }
 
     {
@@ -133,7 +133,12 @@ public:
 	 */
 	virtual std::vector<ActionMappingEntry const*> getEntriesWithNonzeroVisitCount() const;
 
-
+	/** call the given function on each entry of the container.
+	 *
+	 * The default implementation uses getEntries(), which allocates; an implementation should
+	 * override this to iterate over its entries directly.
+	 */
+	virtual void forEachEntry(tapir::FunctionRef<void(ContinuousActionMapEntry const*)> function) const;
 };
 
 
@@ -172,6 +177,7 @@ public:
 	virtual std::vector<ActionMappingEntry const*> getEntries() const override;
 	virtual std::vector<ActionMappingEntry const*> getEntriesWithChildren() const override;
 	virtual std::vector<ActionMappingEntry const*> getEntriesWithNonzeroVisitCount() const override;
+	virtual void forEachEntry(tapir::FunctionRef<void(ContinuousActionMapEntry const*)> function) const override;
 private:
 	std::unordered_map<CONSTRUCTION_DATA, std::unique_ptr<ContinuousActionMapEntry>, Comparator, Comparator> container = {};
 };
@@ -371,13 +377,15 @@ public:
 	virtual long getNChildren() const override;
 
 	// TODO: This is not const. double check the interface. I think this should be changed everywhere in tapir...
-	virtual void deleteChild(ActionMappingEntry const *entry) override;
+	virtual std::unique_ptr<ActionNode> deleteChild(ActionMappingEntry const *entry) override;
 
 	/* -------------- Retrieval of mapping entries. ---------------- */
-	virtual std::vector<ActionMappingEntry const *> getChildEntries() const override;
+	virtual void forEachChildEntry(
+			tapir::FunctionRef<void(ActionMappingEntry const *)> function) const override;
 
 	virtual long getNumberOfVisitedEntries() const override;
-	virtual std::vector<ActionMappingEntry const *> getVisitedEntries() const override;
+	virtual void forEachVisitedEntry(
+			tapir::FunctionRef<void(ActionMappingEntry const *)> function) const override;
 	virtual ActionMappingEntry *getEntry(Action const &action) override;
 	virtual ActionMappingEntry const *getEntry(Action const &action) const override;
 
@@ -392,6 +400,7 @@ public:
 
 	/* -------------- Retrieval of general statistics. ---------------- */
 	virtual long getTotalVisitCount() const override;
+	virtual double getTotalQValue() const override;
 
 
 	/* The chooserData
@@ -420,6 +429,9 @@ protected:
 	/** The total of the visit counts of all of the individual entries. */
 	long totalVisitCount = 0;
 
+	/** The total of the Q-values of all of the individual entries. */
+	double totalQValue = 0;
+
 	/** Stores references to the entries that are considered fixed */
 	std::vector<ThisActionMapEntry*> fixedEntries;
 
@@ -460,7 +472,7 @@ public:
 	virtual void setLegal(bool legal) override;
 
 	void setChild(std::unique_ptr<ActionNode>&& child);
-	void deleteChild();
+	std::unique_ptr<ActionNode> deleteChild();
 	const ActionNode* getChild() const;
 
 	const ThisActionConstructionData& getConstructionData() const;
@@ -607,6 +619,14 @@ inline std::vector<ActionMappingEntry const*> ContinuousActionContainer<CONSTRUC
 }
 
 
+template<class CONSTRUCTION_DATA>
+inline void ContinuousActionContainer<CONSTRUCTION_DATA>::forEachEntry(tapir::FunctionRef<void(ContinuousActionMapEntry const*)> function) const {
+	for(auto& i : container) {
+		function(i.second.get());
+	}
+}
+
+
 /* ------------------- ChooserDataBase ------------------- */
 template<class Derived>
 bool ChooserDataBase<Derived>::initialisationDummy = (ChooserDataBase<Derived>::registerType(), true);
@@ -5,6 +5,7 @@
 #include "solver/mappings/actions/discretized_actions.hpp"
 
 #include <algorithm>
+#include <array>
 #include <cmath>
 
 #include <iostream>
@@ -24,10 +25,44 @@
 #include "solver/mappings/actions/ActionMappingEntry.hpp"
 #include "solver/mappings/actions/ActionPool.hpp"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 namespace solver {
+namespace {
+/** The number of visit counts whose logarithm is precomputed for UCB. */
+long const LOG_TABLE_SIZE = 4096;
+
+/** Returns a table of the logarithms of 0, 1, ..., LOG_TABLE_SIZE - 1. */
+std::array<double, LOG_TABLE_SIZE> make_log_table() {
+    std::array<double, LOG_TABLE_SIZE> table;
+    for (long i = 0; i < LOG_TABLE_SIZE; i++) {
+        table[i] = std::log(i);
+    }
+    return table;
+}
+
+/** The logarithms of small visit counts. */
+std::array<double, LOG_TABLE_SIZE> const LOG_TABLE = make_log_table();
+
+/** Returns the logarithm of the given visit count. */
+double log_visit_count(long visitCount) {
+    if (visitCount < LOG_TABLE_SIZE) {
+        return LOG_TABLE[visitCount];
+    }
+    return std::log(visitCount);
+}
+} /* namespace */
+
 /* ---------------------- DiscretizedActionPool ---------------------- */
 std::unique_ptr<ActionMapping> DiscretizedActionPool::createActionMapping(BeliefNode *node) {
-    return std::make_unique<DiscretizedActionMap>(node, this, createBinSequence(node));
+    return allocate_unique<DiscretizedActionMap>(node->getAllocator(), node, this,
+            createBinSequence(node));
+}
+
+Action const *DiscretizedActionPool::peekBinAction(long /*binNumber*/) {
+    return nullptr;
 }
 
 /* ---------------------- DiscretizedActionMap ---------------------- */
@@ -36,26 +71,39 @@ DiscretizedActionMap::DiscretizedActionMap(BeliefNode *owner, DiscretizedActionP
         ActionMapping(owner),
                 pool_(pool),
                 numberOfBins_(pool_->getNumberOfBins()),
-                entries_(std::make_unique<DiscretizedActionMapEntry[]>(numberOfBins_)),
+                entries_(allocate_unique_array<DiscretizedActionMapEntry>(
+                        owner->getAllocator(), numberOfBins_)),
+                statistics_(SlabAllocator::allocate(owner->getAllocator(), numberOfBins_
+                        * (2 * sizeof(double) + sizeof(long) + sizeof(bool)))),
+                totalQValues_(static_cast<double *>(statistics_)),
+                meanQValues_(totalQValues_ + numberOfBins_),
+                visitCounts_(reinterpret_cast<long *>(meanQValues_ + numberOfBins_)),
+                isLegal_(reinterpret_cast<bool *>(visitCounts_ + numberOfBins_)),
                 nChildren_(0),
                 numberOfVisitedEntries_(0),
                 binSequence_(binSequence.begin(), binSequence.end()),
-                totalVisitCount_(0) {
+                totalVisitCount_(0),
+                totalQValue_(0),
+                maxQBin_(-1),
+                robustBin_(-1) {
     for (int i = 0; i < numberOfBins_; i++) {
         DiscretizedActionMapEntry &entry = entries_[i];
         entry.binNumber_ = i;
         entry.map_ = this;
-        entry.isLegal_ = false;
+        totalQValues_[i] = 0;
+        meanQValues_[i] = 0;
+        visitCounts_[i] = 0;
+        isLegal_[i] = false;
     }
 
     // Only entries in the sequence are legal.
     for (long binNumber : binSequence_) {
-        entries_[binNumber].isLegal_ = true;
+        isLegal_[binNumber] = true;
     }
 }
 
-// Default destructor.
 DiscretizedActionMap::~DiscretizedActionMap() {
+    SlabAllocator::deallocate(statistics_);
 }
 
 ActionNode* DiscretizedActionMap::getActionNode(Action const &action) const {
@@ -66,7 +114,8 @@ ActionNode* DiscretizedActionMap::createActionNode(Action const &action) {
     long code = static_cast<DiscretizedPoint const &>(action).getBinNumber();
     DiscretizedActionMapEntry &entry = entries_[code];
 
-    std::unique_ptr<ActionNode> actionNode = std::make_unique<ActionNode>(&entry);
+    std::unique_ptr<ActionNode> actionNode = allocate_unique<ActionNode>(
+            getOwner()->getAllocator(), &entry);
     ActionNode *node = actionNode.get();
     entry.childNode_ = std::move(actionNode);
 
@@ -77,43 +126,41 @@ long DiscretizedActionMap::getNChildren() const {
     return nChildren_;
 }
 
-void DiscretizedActionMap::deleteChild(ActionMappingEntry const *entry) {
+std::unique_ptr<ActionNode> DiscretizedActionMap::deleteChild(ActionMappingEntry const *entry) {
     DiscretizedActionMapEntry &discEntry = const_cast<DiscretizedActionMapEntry &>(
                 static_cast<DiscretizedActionMapEntry const &>(*entry));
 
     // Perform a negative update on the entry.
-    discEntry.update(-discEntry.visitCount_, -discEntry.totalQValue_);
+    long binNumber = discEntry.binNumber_;
+    discEntry.update(-visitCounts_[binNumber], -totalQValues_[binNumber]);
 
-    // Now delete the child node.
-    discEntry.childNode_ = nullptr;
+    // Now remove the child node.
+    return std::move(discEntry.childNode_);
 }
 
 
-std::vector<ActionMappingEntry const *> DiscretizedActionMap::getChildEntries() const  {
-    std::vector<ActionMappingEntry const *> returnEntries;
+void DiscretizedActionMap::forEachChildEntry(
+        tapir::FunctionRef<void(ActionMappingEntry const *)> function) const {
     for (int i = 0; i < numberOfBins_; i++) {
         DiscretizedActionMapEntry const &entry = entries_[i];
         if (entry.childNode_ != nullptr) {
-            returnEntries.push_back(&entry);
+            function(&entry);
         }
     }
-    return returnEntries;
 }
 long DiscretizedActionMap::getNumberOfVisitedEntries() const {
     return numberOfVisitedEntries_;
 }
-std::vector<ActionMappingEntry const *> DiscretizedActionMap::getVisitedEntries() const {
-    std::vector<ActionMappingEntry const *> returnEntries;
+void DiscretizedActionMap::forEachVisitedEntry(
+        tapir::FunctionRef<void(ActionMappingEntry const *)> function) const {
     for (int i = 0; i < numberOfBins_; i++) {
-        DiscretizedActionMapEntry const &entry = entries_[i];
-        if (entry.visitCount_ > 0) {
-            if (!entry.isLegal_) {
+        if (visitCounts_[i] > 0) {
+            if (!isLegal_[i]) {
                 debug::show_message("WARNING: Illegal entry with nonzero visit count!");
             }
-            returnEntries.push_back(&entry);
+            function(&entries_[i]);
         }
     }
-    return returnEntries;
 }
 ActionMappingEntry *DiscretizedActionMap::getEntry(Action const &action) {
     long code = static_cast<DiscretizedPoint const &>(action).getBinNumber();
@@ -130,14 +177,171 @@ std::unique_ptr<Action> DiscretizedActionMap::getNextActionToTry() {
     if (binSequence_.size() == 0) {
         return nullptr;
     }
-    // Otherwise we sample a new action using the first bin to be tried.
-    return pool_->sampleAnAction(binSequence_.getFirst());
+    // Otherwise we sample a new action using the first bin to be tried; it is taken out of the
+    // sequence now, so that concurrent searches through this node expand different bins.
+    long binNumber = binSequence_.getFirst();
+    binSequence_.remove(binNumber);
+    return pool_->sampleAnAction(binNumber);
 }
 
 long DiscretizedActionMap::getTotalVisitCount() const {
     return totalVisitCount_;
 }
 
+double DiscretizedActionMap::getTotalQValue() const {
+    return totalQValue_;
+}
+
+ActionMappingEntry const *DiscretizedActionMap::getMaxQEntry() const {
+    if (maxQBin_ == UNKNOWN_BIN) {
+        maxQBin_ = -1;
+        for (long i = 0; i < numberOfBins_; i++) {
+            if (hasHigherQValue(i, maxQBin_)) {
+                maxQBin_ = i;
+            }
+        }
+    }
+    return maxQBin_ < 0 ? nullptr : &entries_[maxQBin_];
+}
+
+ActionMappingEntry const *DiscretizedActionMap::getRobustEntry() const {
+    if (robustBin_ == UNKNOWN_BIN) {
+        robustBin_ = -1;
+        for (long i = 0; i < numberOfBins_; i++) {
+            if (isMoreRobust(i, robustBin_)) {
+                robustBin_ = i;
+            }
+        }
+    }
+    return robustBin_ < 0 ? nullptr : &entries_[robustBin_];
+}
+
+ActionMappingEntry const *DiscretizedActionMap::getUcbEntry(double explorationCoefficient,
+        double virtualLoss) const {
+    // The virtual losses are kept by the action nodes, so the general version has to deal with
+    // them.
+    if (getOwner()->getVirtualLossCount() > 0) {
+        return ActionMapping::getUcbEntry(explorationCoefficient, virtualLoss);
+    }
+
+    double logTotalVisits = log_visit_count(totalVisitCount_);
+    long ucbBin = -1;
+    double maxUcbValue = -std::numeric_limits<double>::infinity();
+    long binNumber = 0;
+#if defined(__SSE2__)
+    // Two bins at a time; each lane keeps the first of its bins with the highest value.
+    if (numberOfBins_ >= 2) {
+        __m128d const logN = _mm_set1_pd(logTotalVisits);
+        __m128d const coefficient = _mm_set1_pd(explorationCoefficient);
+        __m128d const zero = _mm_setzero_pd();
+        __m128d const two = _mm_set1_pd(2);
+        __m128d bestValues = _mm_set1_pd(-std::numeric_limits<double>::infinity());
+        __m128d bestBins = _mm_set1_pd(-1);
+        __m128d bins = _mm_set_pd(1, 0);
+        for (; binNumber + 1 < numberOfBins_; binNumber += 2) {
+            __m128d counts = _mm_set_pd(visitCounts_[binNumber + 1], visitCounts_[binNumber]);
+            __m128d legal = _mm_castsi128_pd(_mm_set_epi64x(-isLegal_[binNumber + 1],
+                    -isLegal_[binNumber]));
+            __m128d values = _mm_add_pd(_mm_loadu_pd(meanQValues_ + binNumber),
+                    _mm_mul_pd(coefficient, _mm_sqrt_pd(_mm_div_pd(logN, counts))));
+            // Only legal, visited bins can be chosen.
+            __m128d isBetter = _mm_and_pd(_mm_and_pd(legal, _mm_cmpgt_pd(counts, zero)),
+                    _mm_cmpgt_pd(values, bestValues));
+            bestValues = _mm_or_pd(_mm_and_pd(isBetter, values),
+                    _mm_andnot_pd(isBetter, bestValues));
+            bestBins = _mm_or_pd(_mm_and_pd(isBetter, bins), _mm_andnot_pd(isBetter, bestBins));
+            bins = _mm_add_pd(bins, two);
+        }
+        double laneValues[2], laneBins[2];
+        _mm_storeu_pd(laneValues, bestValues);
+        _mm_storeu_pd(laneBins, bestBins);
+        for (int lane = 0; lane < 2; lane++) {
+            if (laneBins[lane] < 0) {
+                continue;
+            }
+            // Ties go to the lower bin number, as they would in a sequential scan.
+            if (laneValues[lane] > maxUcbValue
+                    || (laneValues[lane] == maxUcbValue && laneBins[lane] < ucbBin)) {
+                maxUcbValue = laneValues[lane];
+                ucbBin = laneBins[lane];
+            }
+        }
+    }
+#endif
+    for (; binNumber < numberOfBins_; binNumber++) {
+        if (!isLegal_[binNumber] || visitCounts_[binNumber] <= 0) {
+            continue;
+        }
+        double value = meanQValues_[binNumber]
+                + explorationCoefficient * std::sqrt(logTotalVisits / visitCounts_[binNumber]);
+        if (value > maxUcbValue) {
+            maxUcbValue = value;
+            ucbBin = binNumber;
+        }
+    }
+
+    if (ucbBin >= 0 && !std::isfinite(maxUcbValue)) {
+        debug::show_message("ERROR: Infinite/NaN value!?");
+    }
+    return ucbBin < 0 ? nullptr : &entries_[ucbBin];
+}
+
+bool DiscretizedActionMap::hasHigherQValue(long binNumber, long otherBinNumber) const {
+    if (visitCounts_[binNumber] <= 0) {
+        return false;
+    }
+    if (otherBinNumber < 0) {
+        return true;
+    }
+    // Ties go to the lower bin number, as they would in a sequential scan.
+    double qValue = meanQValues_[binNumber];
+    double otherQValue = meanQValues_[otherBinNumber];
+    return qValue > otherQValue || (qValue == otherQValue && binNumber < otherBinNumber);
+}
+
+bool DiscretizedActionMap::isMoreRobust(long binNumber, long otherBinNumber) const {
+    if (visitCounts_[binNumber] <= 0) {
+        return false;
+    }
+    if (otherBinNumber < 0) {
+        return true;
+    }
+    long visitCount = visitCounts_[binNumber];
+    long otherVisitCount = visitCounts_[otherBinNumber];
+    if (visitCount != otherVisitCount) {
+        return visitCount > otherVisitCount;
+    }
+    return hasHigherQValue(binNumber, otherBinNumber);
+}
+
+void DiscretizedActionMap::updateBestBins(long binNumber, long oldVisitCount,
+        double oldMeanQValue) {
+    long visitCount = visitCounts_[binNumber];
+    double meanQValue = meanQValues_[binNumber];
+
+    if (maxQBin_ != UNKNOWN_BIN) {
+        if (binNumber == maxQBin_) {
+            // If the best bin got worse, another bin may be better now.
+            if (visitCount <= 0 || meanQValue < oldMeanQValue) {
+                maxQBin_ = UNKNOWN_BIN;
+            }
+        } else if (hasHigherQValue(binNumber, maxQBin_)) {
+            maxQBin_ = binNumber;
+        }
+    }
+
+    if (robustBin_ != UNKNOWN_BIN) {
+        if (binNumber == robustBin_) {
+            if (visitCount < oldVisitCount
+                    || (visitCount == oldVisitCount && meanQValue < oldMeanQValue)) {
+                robustBin_ = UNKNOWN_BIN;
+            }
+        } else if (isMoreRobust(binNumber, robustBin_)) {
+            robustBin_ = binNumber;
+        }
+    }
+}
+
 /* ------------------- DiscretizedActionMapEntry ------------------- */
 ActionMapping *DiscretizedActionMapEntry::getMapping() const {
     return map_;
@@ -145,20 +349,23 @@ ActionMapping *DiscretizedActionMapEntry::getMapping() const {
 std::unique_ptr<Action> DiscretizedActionMapEntry::getAction() const {
     return map_->pool_->sampleAnAction(binNumber_);
 }
+Action const *DiscretizedActionMapEntry::peekAction() const {
+    return map_->pool_->peekBinAction(binNumber_);
+}
 ActionNode *DiscretizedActionMapEntry::getActionNode() const {
     return childNode_.get();
 }
 long DiscretizedActionMapEntry::getVisitCount() const {
-    return visitCount_;
+    return map_->visitCounts_[binNumber_];
 }
 double DiscretizedActionMapEntry::getTotalQValue() const {
-    return totalQValue_;
+    return map_->totalQValues_[binNumber_];
 }
 double DiscretizedActionMapEntry::getMeanQValue() const {
-    return meanQValue_;
+    return map_->meanQValues_[binNumber_];
 }
 bool DiscretizedActionMapEntry::isLegal() const {
-    return isLegal_;
+    return map_->isLegal_[binNumber_];
 }
 
 
@@ -176,45 +383,54 @@ bool DiscretizedActionMapEntry::update(long deltaNVisits, double deltaTotalQ) {
         debug::show_message("ERROR: Non-finite delta value!");
     }
 
-    if (deltaNVisits > 0 && !isLegal_) {
+    bool isLegal = map_->isLegal_[binNumber_];
+    if (deltaNVisits > 0 && !isLegal) {
         debug::show_message("ERROR: Visiting an illegal action!");
     }
 
     // Update the visit counts
-    if (visitCount_ == 0 && deltaNVisits > 0) {
+    long &visitCount = map_->visitCounts_[binNumber_];
+    long oldVisitCount = visitCount;
+    if (visitCount == 0 && deltaNVisits > 0) {
         map_->numberOfVisitedEntries_++;
         // Now that we've tried it at least once, we don't have to try it again.
         map_->binSequence_.remove(binNumber_);
     }
-    visitCount_ += deltaNVisits;
+    visitCount += deltaNVisits;
     map_->totalVisitCount_ += deltaNVisits;
-    if (visitCount_ == 0 && deltaNVisits < 0) {
+    if (visitCount == 0 && deltaNVisits < 0) {
         map_->numberOfVisitedEntries_--;
         // Newly unvisited and legal => must try it.
-        if (isLegal_) {
+        if (isLegal) {
             map_->binSequence_.add(binNumber_);
         }
     }
 
     // Update the total Q
-    totalQValue_ += deltaTotalQ;
+    double &totalQValue = map_->totalQValues_[binNumber_];
+    totalQValue += deltaTotalQ;
+    map_->totalQValue_ += deltaTotalQ;
 
     // Update the mean Q
-    double oldMeanQ = meanQValue_;
-    if (visitCount_ <= 0) {
-        meanQValue_ = -std::numeric_limits<double>::infinity();
+    double &meanQValue = map_->meanQValues_[binNumber_];
+    double oldMeanQ = meanQValue;
+    if (visitCount <= 0) {
+        meanQValue = -std::numeric_limits<double>::infinity();
     } else {
-        meanQValue_ = totalQValue_ / visitCount_;
+        meanQValue = totalQValue / visitCount;
     }
-    return meanQValue_ != oldMeanQ;
+
+    map_->updateBestBins(binNumber_, oldVisitCount, oldMeanQ);
+    return meanQValue != oldMeanQ;
 }
 
 void DiscretizedActionMapEntry::setLegal(bool legal) {
-    if (!isLegal_) {
+    bool &isLegal = map_->isLegal_[binNumber_];
+    if (!isLegal) {
         if (legal) {
             // illegal => legal
-            isLegal_ = true;
-            if (visitCount_ == 0) {
+            isLegal = true;
+            if (map_->visitCounts_[binNumber_] == 0) {
                 // Newly legal and unvisited => must try it.
                 map_->binSequence_.add(binNumber_);
             }
@@ -222,7 +438,7 @@ void DiscretizedActionMapEntry::setLegal(bool legal) {
     } else {
         if (!legal) {
             // legal => illegal
-            isLegal_ = false;
+            isLegal = false;
             map_->binSequence_.remove(binNumber_);
         }
     }
@@ -258,13 +474,13 @@ void DiscretizedActionTextSerializer::saveActionMapping(
     long visitedCount = 0;
     for (int i = 0; i < discMap.numberOfBins_; i++) {
         DiscretizedActionMapEntry const &entry = discMap.entries_[i];
-        if (entry.visitCount_ > 0) {
+        if (discMap.visitCounts_[i] > 0) {
             visitedCount++;
         }
         // An entry is saved if it has a node, or a nonzero visit count.
-        if (entry.visitCount_ > 0 || entry.childNode_ != nullptr) {
+        if (discMap.visitCounts_[i] > 0 || entry.childNode_ != nullptr) {
             entriesByValue.emplace(
-                    std::make_pair(entry.meanQValue_, entry.binNumber_), &entry);
+                    std::make_pair(discMap.meanQValues_[i], entry.binNumber_), &entry);
         }
     }
     if (visitedCount != discMap.getNumberOfVisitedEntries()) {
@@ -293,8 +509,8 @@ void DiscretizedActionTextSerializer::saveActionMapping(
 
 std::unique_ptr<ActionMapping>
 DiscretizedActionTextSerializer::loadActionMapping(BeliefNode *owner, std::istream &is) {
-    std::unique_ptr<DiscretizedActionMap> discMap = std::make_unique<DiscretizedActionMap>(
-            owner,
+    std::unique_ptr<DiscretizedActionMap> discMap = allocate_unique<DiscretizedActionMap>(
+            owner->getAllocator(), owner,
             static_cast<DiscretizedActionPool *>(getSolver()->getActionPool()),
             std::vector<long> { });
     loadActionMapping(*discMap, is);
@@ -355,14 +571,15 @@ void DiscretizedActionTextSerializer::loadActionMapping(DiscretizedActionMap &di
         DiscretizedActionMapEntry &entry = discMap.entries_[binNumber];
         entry.binNumber_ = binNumber;
         entry.map_ = &discMap;
-        entry.meanQValue_ = meanQValue;
-        entry.visitCount_ = visitCount;
-        entry.totalQValue_ = totalQValue;
-        entry.isLegal_ = (legalString != "ILLEGAL");
+        discMap.meanQValues_[binNumber] = meanQValue;
+        discMap.visitCounts_[binNumber] = visitCount;
+        discMap.totalQValues_[binNumber] = totalQValue;
+        discMap.isLegal_[binNumber] = (legalString != "ILLEGAL");
 
         // Read in the action node itself.
         if (hasChild) {
-            entry.childNode_ = std::make_unique<ActionNode>(&entry);
+            entry.childNode_ = allocate_unique<ActionNode>(discMap.getOwner()->getAllocator(),
+                    &entry);
             ActionNode *node = entry.childNode_.get();
             load(*node, is);
         }
@@ -370,8 +587,18 @@ void DiscretizedActionTextSerializer::loadActionMapping(DiscretizedActionMap &di
 
     // Any bins we are supposed to try must be considered legal.
     for (long binNumber : discMap.binSequence_) {
-        discMap.entries_[binNumber].isLegal_ = true;
+        discMap.isLegal_[binNumber] = true;
+    }
+
+    // The running statistics have to be worked out from the loaded entries.
+    discMap.totalQValue_ = 0;
+    for (long i = 0; i < discMap.numberOfBins_; i++) {
+        if (discMap.visitCounts_[i] > 0) {
+            discMap.totalQValue_ += discMap.totalQValues_[i];
+        }
     }
+    discMap.maxQBin_ = DiscretizedActionMap::UNKNOWN_BIN;
+    discMap.robustBin_ = DiscretizedActionMap::UNKNOWN_BIN;
 }
 
 } /* namespace solver */
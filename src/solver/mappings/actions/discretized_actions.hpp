@@ -68,6 +68,15 @@ class DiscretizedActionPool: public solver::ActionPool {
 
     /** Samples an action from bin with the given number. */
     virtual std::unique_ptr<Action> sampleAnAction(long binNumber) = 0;
+    /** Returns the only action in the bin with the given number without copying it, or nullptr
+     * if the bin can hold more than one action.
+     *
+     * The returned action must remain valid for as long as this pool exists; it is used to
+     * avoid copying actions during the search.
+     *
+     * The default implementation returns nullptr.
+     */
+    virtual Action const *peekBinAction(long binNumber);
 
     /** Creates an initial sequence of bins to try for the given belief node. This has two effects:
      * - The getNextActionToTry() method will return these actions in the given order
@@ -85,6 +94,16 @@ class DiscretizedActionPool: public solver::ActionPool {
  *
  * This class stores its mapping entries in an array whose size is determined at runtime based on
  * the # of bins in the action pool.
+ *
+ * The statistics for the entries are kept by the mapping itself, in one array per statistic,
+ * so that choosing an action only needs to scan a few contiguous arrays rather than calling
+ * virtual methods on each entry.
+ *
+ * The mapping also keeps a running total of the Q-values, and remembers which entries have the
+ * highest mean Q-value and the highest visit count; these are updated along with each entry, so
+ * the value estimators don't need to look at every entry. The remembered entry is only
+ * forgotten when its own statistics get worse, in which case the next query scans the arrays
+ * again.
  */
 class DiscretizedActionMap: public solver::ActionMapping {
   public:
@@ -109,24 +128,51 @@ class DiscretizedActionMap: public solver::ActionMapping {
     virtual ActionNode *createActionNode(Action const &action) override;
     virtual long getNChildren() const override;
 
-    virtual void deleteChild(ActionMappingEntry const *entry) override;
+    virtual std::unique_ptr<ActionNode> deleteChild(ActionMappingEntry const *entry) override;
 
     /* -------------- Retrieval of mapping entries. ---------------- */
-    virtual std::vector<ActionMappingEntry const *> getChildEntries() const override;
+    virtual void forEachChildEntry(
+            tapir::FunctionRef<void(ActionMappingEntry const *)> function) const override;
 
     virtual long getNumberOfVisitedEntries() const override;
-    virtual std::vector<ActionMappingEntry const *> getVisitedEntries() const override;
+    virtual void forEachVisitedEntry(
+            tapir::FunctionRef<void(ActionMappingEntry const *)> function) const override;
     virtual ActionMappingEntry *getEntry(Action const &action) override;
     virtual ActionMappingEntry const *getEntry(Action const &action) const override;
 
     /* ----------------- Methods for unvisited actions ------------------- */
-    /** Returns the next action to be tried for this node, or nullptr if there are no more. */
+    /** Removes the next bin to be tried from the bin sequence, and returns an action sampled
+     * from it, or nullptr if there are no more.
+     */
     virtual std::unique_ptr<Action> getNextActionToTry() override;
 
     /* -------------- Retrieval of general statistics. ---------------- */
     virtual long getTotalVisitCount() const override;
+    virtual double getTotalQValue() const override;
+
+    /* ------------------ Selection of entries ------------------- */
+    virtual ActionMappingEntry const *getMaxQEntry() const override;
+    virtual ActionMappingEntry const *getRobustEntry() const override;
+    virtual ActionMappingEntry const *getUcbEntry(double explorationCoefficient,
+            double virtualLoss) const override;
 
   protected:
+    /** The value of maxQBin_ or robustBin_ when the best bin is not known. */
+    static long const UNKNOWN_BIN = -2;
+
+    /** Returns true iff the first bin has a higher mean Q-value than the second, which may
+     * be -1 if there is no such bin; unvisited bins are never better.
+     */
+    bool hasHigherQValue(long binNumber, long otherBinNumber) const;
+    /** Returns true iff the first bin is more robust (more visits, then a higher mean Q-value)
+     * than the second, which may be -1 if there is no such bin; unvisited bins are never better.
+     */
+    bool isMoreRobust(long binNumber, long otherBinNumber) const;
+    /** Updates the remembered best bins after the given bin has been updated from the given
+     * previous visit count and mean Q-value.
+     */
+    void updateBestBins(long binNumber, long oldVisitCount, double oldMeanQValue);
+
     /** The pool associated with this mapping. */
     DiscretizedActionPool *pool_;
 
@@ -134,6 +180,18 @@ class DiscretizedActionMap: public solver::ActionMapping {
     long numberOfBins_;
     /** The array of mapping entries - the bin number corresponds to the position in the array. */
     std::unique_ptr<DiscretizedActionMapEntry[]> entries_;
+
+    /** The single block of memory that holds all of the statistics arrays below. */
+    void *statistics_;
+    /** The total Q-value for each bin. */
+    double *totalQValues_;
+    /** The mean Q-value for each bin => should be equal to totalQValue / visitCount */
+    double *meanQValues_;
+    /** The visit count for each bin. */
+    long *visitCounts_;
+    /** True for each bin whose action is legal. */
+    bool *isLegal_;
+
     /** The number of action node children that have been created. */
     long nChildren_;
     /** The number of entries with nonzero visit counts. */
@@ -144,13 +202,20 @@ class DiscretizedActionMap: public solver::ActionMapping {
 
     /** The total of the visit counts of all of the individual entries. */
     long totalVisitCount_;
+    /** The total of the Q-values of all of the individual entries. */
+    double totalQValue_;
+
+    /** The visited bin with the highest mean Q-value, -1 if there is none, or UNKNOWN_BIN. */
+    mutable long maxQBin_;
+    /** The visited bin with the most visits, -1 if there is none, or UNKNOWN_BIN. */
+    mutable long robustBin_;
 };
 
 
 /** A concrete class implementing ActionMappingEntry for a discretized action space.
  *
- * Each entry stores its bin number and a reference back to its parent map, as well as a child node,
- * visit count, total and mean Q-values, and a flag for whether or not the action is legal.
+ * Each entry stores its bin number and a reference back to its parent map, as well as a child node;
+ * the visit count, total and mean Q-values, and legality of the action are stored by the map.
  */
 class DiscretizedActionMapEntry : public solver::ActionMappingEntry {
     friend class DiscretizedActionMap;
@@ -159,6 +224,7 @@ class DiscretizedActionMapEntry : public solver::ActionMappingEntry {
   public:
     virtual ActionMapping *getMapping() const override;
     virtual std::unique_ptr<Action> getAction() const override;
+    virtual Action const *peekAction() const override;
     virtual ActionNode *getActionNode() const override;
     virtual long getVisitCount() const override;
     virtual double getTotalQValue() const override;
@@ -178,14 +244,6 @@ class DiscretizedActionMapEntry : public solver::ActionMappingEntry {
     DiscretizedActionMap *map_ = nullptr;
     /** The child action node, if one exists. */
     std::unique_ptr<ActionNode> childNode_ = nullptr;
-    /** The visit count for this edge. */
-    long visitCount_ = 0;
-    /** The total Q-value for this edge. */
-    double totalQValue_ = 0;
-    /** The mean Q-value for this edge => should be equal to totalQValue_ / visitCount_ */
-    double meanQValue_ = 0;
-    /** True iff this edge is legal. */
-    bool isLegal_ = false; // Entries are illegal by default.
 };
 
 /** A partial implementation of the Serializer interface which provides serialization methods for
@@ -20,6 +20,9 @@ std::unique_ptr<Action> EnumeratedActionPool::sampleAnAction(
         long binNumber) {
     return allActions_[binNumber]->copy();
 }
+Action const *EnumeratedActionPool::peekBinAction(long binNumber) {
+    return allActions_[binNumber].get();
+}
 
 std::vector<long> EnumeratedActionPool::createBinSequence(BeliefNode */*node*/) {
     std::vector<long> bins;
@@ -45,6 +45,8 @@ class EnumeratedActionPool : public solver::DiscretizedActionPool {
 
     virtual long getNumberOfBins() override;
     virtual std::unique_ptr<Action> sampleAnAction(long binNumber) override;
+    /** Each bin holds exactly one action, so this returns that action. */
+    virtual Action const *peekBinAction(long binNumber) override;
     /** This provides a default implementation of createBinSequence(), which works by simply
      * creating a vector of all the bins [0, 1, ..., getNumberOfBins()-1], and shuffling that
      * vector.
@@ -0,0 +1,41 @@
+/** @file ObservationIndex.hpp
+ *
+ * Defines the ObservationIndex interface, which allows the entries of an observation mapping to
+ * be looked up by their distance to a given observation.
+ */
+#ifndef SOLVER_OBSERVATIONINDEX_HPP_
+#define SOLVER_OBSERVATIONINDEX_HPP_
+
+#include "global.hpp"
+
+#include "solver/abstract-problem/Observation.hpp"
+
+namespace solver {
+class ObservationMappingEntry;
+
+/** An interface for an index of observation mapping entries, which finds the entry whose
+ * observation is nearest to a given observation, as measured by Observation::distanceTo().
+ *
+ * The index doesn't own the entries; each entry must be removed from the index before it is
+ * destroyed, and its observation must not change while it is in the index.
+ */
+class ObservationIndex {
+public:
+    ObservationIndex() = default;
+    virtual ~ObservationIndex() = default;
+    _NO_COPY_OR_MOVE(ObservationIndex);
+
+    /** Adds the given entry to this index. */
+    virtual void addEntry(ObservationMappingEntry *entry) = 0;
+    /** Removes the given entry from this index. */
+    virtual void removeEntry(ObservationMappingEntry const *entry) = 0;
+
+    /** Returns the entry whose observation is nearest to the given observation, or nullptr if
+     * there is no entry within the given maximum distance.
+     */
+    virtual ObservationMappingEntry *findNearest(Observation const &obs,
+            double maxDistance) const = 0;
+};
+} /* namespace solver */
+
+#endif /* SOLVER_OBSERVATIONINDEX_HPP_ */
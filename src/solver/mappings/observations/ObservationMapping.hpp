@@ -13,8 +13,12 @@
 #define SOLVER_OBSERVATIONMAPPING_HPP_
 
 #include <memory>                       // for unique_ptr
+#include <vector>                       // for vector
 
 #include "global.hpp"
+#include "FunctionRef.hpp"
+
+#include "solver/SlabAllocator.hpp"
 
 #include "solver/abstract-problem/Observation.hpp"              // for Observation
 #include "solver/mappings/observations/ObservationMappingEntry.hpp"
@@ -29,7 +33,7 @@ class BeliefNode;
  * Each of these edges must also store the statistics for that edge - in this case, this only
  * consists of the visit count for that edge.
  */
-class ObservationMapping {
+class ObservationMapping : public SlabAllocated {
 public:
     /** Creates a new ObservationMapping, which will be owned by the given ActionNode. */
     ObservationMapping(ActionNode *owner) :
@@ -52,12 +56,32 @@ public:
     /** Returns the number of child nodes associated with this mapping. */
     virtual long getNChildren() const = 0;
 
-    /** Deletes the given entry from this mapping, as well as the entire corresponding subtree. */
-    virtual void deleteChild(ObservationMappingEntry const *entry) = 0;
+    /** Deletes the given entry from this mapping, as well as the entire corresponding subtree.
+     *
+     * The child node is removed from this mapping and returned, so the caller can choose when to
+     * free it; if the return value is ignored, it is freed straight away.
+     */
+    virtual std::unique_ptr<BeliefNode> deleteChild(ObservationMappingEntry const *entry) = 0;
 
     /* -------------- Retrieval of mapping entries. ---------------- */
-    /** Returns a vector of all the entries in this mapping that have an associated child node. */
-    virtual std::vector<ObservationMappingEntry const *> getChildEntries() const = 0;
+    /** Calls the given function on each entry in this mapping that has an associated child node.
+     *
+     * Unlike getChildEntries(), this never allocates any memory. The function must not add or
+     * delete any entries of this mapping.
+     */
+    virtual void forEachChildEntry(
+            tapir::FunctionRef<void(ObservationMappingEntry const *)> function) const = 0;
+    /** Returns a vector of all the entries in this mapping that have an associated child node.
+     *
+     * This is a copy, so entries can safely be deleted while iterating over it.
+     */
+    std::vector<ObservationMappingEntry const *> getChildEntries() const {
+        std::vector<ObservationMappingEntry const *> entries;
+        forEachChildEntry([&entries] (ObservationMappingEntry const *entry) {
+            entries.push_back(entry);
+        });
+        return entries;
+    }
 
     /** Returns the mapping entry associated with the given observation. */
     virtual ObservationMappingEntry *getEntry(Observation const &obs) = 0;
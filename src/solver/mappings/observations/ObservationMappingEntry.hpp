@@ -12,6 +12,8 @@
 
 #include "global.hpp"
 
+#include "solver/SlabAllocator.hpp"
+
 #include "solver/abstract-problem/Observation.hpp"              // for Observation
 
 namespace solver {
@@ -29,15 +31,21 @@ class ObservationMapping;
  * Apart from grouping observations together, the primary purpose of this entry is to store
  * a visit count - i.e. the number of times this edge has been visited during searching.
  */
-class ObservationMappingEntry {
+class ObservationMappingEntry : public SlabAllocated {
 public:
     ObservationMappingEntry() = default;
     virtual ~ObservationMappingEntry() = default;
 
     /** Returns the mapping this entry belongs to. */
     virtual ObservationMapping *getMapping() const = 0;
-    /** Returns the observation for this entry. */
-    virtual std::unique_ptr<Observation> getObservation() const = 0;
+    /** Returns the observation for this entry, without copying it; the reference remains valid
+     * for as long as this entry exists.
+     */
+    virtual Observation const &peekObservation() const = 0;
+    /** Returns a copy of the observation for this entry. */
+    std::unique_ptr<Observation> getObservation() const {
+        return peekObservation().copy();
+    }
     /** Returns the belief node for this entry. */
     virtual BeliefNode *getBeliefNode() const = 0;
     /** Returns the visit count for this entry. */
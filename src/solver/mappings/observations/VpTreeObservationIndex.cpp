@@ -0,0 +1,216 @@
+/** @file VpTreeObservationIndex.cpp
+ *
+ * Contains the implementation of the VpTreeObservationIndex class.
+ */
+#include "solver/mappings/observations/VpTreeObservationIndex.hpp"
+
+#include <algorithm>                    // for find, nth_element
+#include <memory>                       // for unique_ptr
+#include <utility>                      // for move
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+#include "solver/abstract-problem/Observation.hpp"
+
+#include "solver/mappings/observations/ObservationMappingEntry.hpp"
+
+namespace solver {
+namespace {
+/** The largest number of entries kept in a leaf before it is split. */
+std::size_t const MAX_BUCKET_SIZE = 8;
+} /* namespace */
+
+/** A node of the tree; a node is a leaf iff it has no children. */
+struct VpTreeObservationIndex::Node {
+    Node() :
+            bucket(),
+            vantageEntry(nullptr),
+            removedObservation(nullptr),
+            vantagePoint(nullptr),
+            radius(0),
+            inside(nullptr),
+            outside(nullptr) {
+    }
+    _NO_COPY_OR_MOVE(Node);
+
+    /** Returns true iff this node is a leaf. */
+    bool isLeaf() const {
+        return inside == nullptr;
+    }
+
+    /** The entries in this leaf. */
+    std::vector<ObservationMappingEntry *> bucket;
+
+    /** The entry of the vantage point, or nullptr if that entry has been removed. */
+    ObservationMappingEntry *vantageEntry;
+    /** A copy of the observation of the vantage point, once its entry has been removed. */
+    std::unique_ptr<Observation> removedObservation;
+    /** The observation of the vantage point. */
+    Observation const *vantagePoint;
+    /** Entries within this distance of the vantage point go inside; the rest go outside. */
+    double radius;
+    /** The subtree of entries inside the radius. */
+    std::unique_ptr<Node> inside;
+    /** The subtree of entries outside the radius. */
+    std::unique_ptr<Node> outside;
+};
+
+VpTreeObservationIndex::VpTreeObservationIndex() :
+        root_(std::make_unique<Node>()),
+        nEntries_(0),
+        nRemovedVantagePoints_(0) {
+}
+
+// Defined here because Node is incomplete in the header.
+VpTreeObservationIndex::~VpTreeObservationIndex() {
+}
+
+void VpTreeObservationIndex::addEntry(ObservationMappingEntry *entry) {
+    addEntry(root_.get(), entry);
+    nEntries_++;
+}
+
+void VpTreeObservationIndex::removeEntry(ObservationMappingEntry const *entry) {
+    Observation const &obs = entry->peekObservation();
+    Node *node = root_.get();
+    // Follow the same path that the entry took when it was added.
+    while (!node->isLeaf()) {
+        if (node->vantageEntry == entry) {
+            node->removedObservation = obs.copy();
+            node->vantagePoint = node->removedObservation.get();
+            node->vantageEntry = nullptr;
+            nEntries_--;
+            nRemovedVantagePoints_++;
+            if (nRemovedVantagePoints_ > nEntries_) {
+                rebuild();
+            }
+            return;
+        }
+        double distance = node->vantagePoint->distanceTo(obs);
+        node = (distance <= node->radius ? node->inside : node->outside).get();
+    }
+    std::vector<ObservationMappingEntry *> &bucket = node->bucket;
+    std::vector<ObservationMappingEntry *>::iterator it = std::find(bucket.begin(), bucket.end(),
+            entry);
+    if (it == bucket.end()) {
+        debug::show_message("ERROR: Removing an entry that isn't in the index!");
+        return;
+    }
+    bucket.erase(it);
+    nEntries_--;
+}
+
+ObservationMappingEntry *VpTreeObservationIndex::findNearest(Observation const &obs,
+        double maxDistance) const {
+    double bestDistance = maxDistance;
+    ObservationMappingEntry *bestEntry = nullptr;
+    search(root_.get(), obs, bestDistance, bestEntry);
+    return bestEntry;
+}
+
+/* ============================ PRIVATE ============================ */
+
+void VpTreeObservationIndex::addEntry(Node *node, ObservationMappingEntry *entry) {
+    Observation const &obs = entry->peekObservation();
+    while (!node->isLeaf()) {
+        double distance = node->vantagePoint->distanceTo(obs);
+        node = (distance <= node->radius ? node->inside : node->outside).get();
+    }
+    node->bucket.push_back(entry);
+    if (node->bucket.size() > MAX_BUCKET_SIZE) {
+        split(node);
+    }
+}
+
+void VpTreeObservationIndex::split(Node *node) {
+    std::vector<ObservationMappingEntry *> const &bucket = node->bucket;
+    // The oldest entry in the bucket becomes the vantage point.
+    ObservationMappingEntry *vantageEntry = bucket.front();
+    Observation const *vantagePoint = &vantageEntry->peekObservation();
+
+    std::vector<double> distances;
+    for (std::size_t i = 1; i < bucket.size(); i++) {
+        distances.push_back(vantagePoint->distanceTo(bucket[i]->peekObservation()));
+    }
+    std::vector<double> sortedDistances(distances);
+    std::vector<double>::iterator median = (
+            sortedDistances.begin() + (sortedDistances.size() - 1) / 2);
+    std::nth_element(sortedDistances.begin(), median, sortedDistances.end());
+    double radius = *median;
+
+    std::unique_ptr<Node> inside = std::make_unique<Node>();
+    std::unique_ptr<Node> outside = std::make_unique<Node>();
+    for (std::size_t i = 1; i < bucket.size(); i++) {
+        (distances[i - 1] <= radius ? inside : outside)->bucket.push_back(bucket[i]);
+    }
+    // If every entry is at the same distance the split is useless, so we just keep the bucket.
+    if (outside->bucket.empty()) {
+        return;
+    }
+
+    node->bucket.clear();
+    node->bucket.shrink_to_fit();
+    node->vantageEntry = vantageEntry;
+    node->vantagePoint = vantagePoint;
+    node->radius = radius;
+    node->inside = std::move(inside);
+    node->outside = std::move(outside);
+}
+
+void VpTreeObservationIndex::search(Node const *node, Observation const &obs,
+        double &bestDistance, ObservationMappingEntry *&bestEntry) {
+    if (node->isLeaf()) {
+        for (ObservationMappingEntry *entry : node->bucket) {
+            double distance = entry->peekObservation().distanceTo(obs);
+            if (distance <= bestDistance) {
+                bestDistance = distance;
+                bestEntry = entry;
+            }
+        }
+        return;
+    }
+
+    double distance = node->vantagePoint->distanceTo(obs);
+    if (node->vantageEntry != nullptr && distance <= bestDistance) {
+        bestDistance = distance;
+        bestEntry = node->vantageEntry;
+    }
+    // By the triangle inequality, a side can only hold a nearer entry if the query is within
+    // bestDistance of the boundary between the two sides; the nearer side is searched first.
+    if (distance <= node->radius) {
+        search(node->inside.get(), obs, bestDistance, bestEntry);
+        if (distance + bestDistance >= node->radius) {
+            search(node->outside.get(), obs, bestDistance, bestEntry);
+        }
+    } else {
+        search(node->outside.get(), obs, bestDistance, bestEntry);
+        if (distance - bestDistance <= node->radius) {
+            search(node->inside.get(), obs, bestDistance, bestEntry);
+        }
+    }
+}
+
+void VpTreeObservationIndex::collectEntries(Node const *node,
+        std::vector<ObservationMappingEntry *> &entries) {
+    if (node->isLeaf()) {
+        entries.insert(entries.end(), node->bucket.begin(), node->bucket.end());
+        return;
+    }
+    if (node->vantageEntry != nullptr) {
+        entries.push_back(node->vantageEntry);
+    }
+    collectEntries(node->inside.get(), entries);
+    collectEntries(node->outside.get(), entries);
+}
+
+void VpTreeObservationIndex::rebuild() {
+    std::vector<ObservationMappingEntry *> entries;
+    collectEntries(root_.get(), entries);
+    root_ = std::make_unique<Node>();
+    nRemovedVantagePoints_ = 0;
+    for (ObservationMappingEntry *entry : entries) {
+        addEntry(root_.get(), entry);
+    }
+}
+} /* namespace solver */
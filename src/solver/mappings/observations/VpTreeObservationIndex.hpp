@@ -0,0 +1,69 @@
+/** @file VpTreeObservationIndex.hpp
+ *
+ * Contains the VpTreeObservationIndex class, which implements ObservationIndex using a
+ * vantage-point tree.
+ */
+#ifndef SOLVER_VPTREEOBSERVATIONINDEX_HPP_
+#define SOLVER_VPTREEOBSERVATIONINDEX_HPP_
+
+#include <memory>                       // for unique_ptr
+#include <vector>                       // for vector
+
+#include "global.hpp"
+
+#include "solver/abstract-problem/Observation.hpp"
+
+#include "solver/mappings/observations/ObservationIndex.hpp"
+
+namespace solver {
+/** An ObservationIndex which stores the entries in a vantage-point tree; this only relies on
+ * Observation::distanceTo(), which must be a metric (in particular, it must satisfy the triangle
+ * inequality) for the results to be exact.
+ *
+ * Each leaf of the tree holds a small bucket of entries; when a bucket grows too large, its oldest
+ * entry becomes a vantage point, and the other entries are split into those inside and outside
+ * the median distance from it. Searches can then skip any side that the triangle inequality
+ * shows to be too far away, which makes them take logarithmic time on typical data.
+ *
+ * A vantage point whose entry is removed keeps a copy of its observation so that the tree
+ * doesn't need to be restructured; once these outnumber the entries, the tree is rebuilt.
+ */
+class VpTreeObservationIndex : public ObservationIndex {
+public:
+    /** Creates a new, empty index. */
+    VpTreeObservationIndex();
+    virtual ~VpTreeObservationIndex();
+    _NO_COPY_OR_MOVE(VpTreeObservationIndex);
+
+    virtual void addEntry(ObservationMappingEntry *entry) override;
+    virtual void removeEntry(ObservationMappingEntry const *entry) override;
+    virtual ObservationMappingEntry *findNearest(Observation const &obs,
+            double maxDistance) const override;
+
+private:
+    struct Node;
+
+    /** Adds the given entry to the subtree rooted at the given node. */
+    void addEntry(Node *node, ObservationMappingEntry *entry);
+    /** Splits the bucket of the given leaf around a vantage point, if it can be split. */
+    void split(Node *node);
+    /** Searches the subtree rooted at the given node for an entry nearer to the given observation
+     * than bestDistance, and updates bestDistance and bestEntry if one is found.
+     */
+    static void search(Node const *node, Observation const &obs, double &bestDistance,
+            ObservationMappingEntry *&bestEntry);
+    /** Adds all of the entries in the subtree rooted at the given node to the given vector. */
+    static void collectEntries(Node const *node, std::vector<ObservationMappingEntry *> &entries);
+    /** Rebuilds the tree from the entries that are still in it. */
+    void rebuild();
+
+    /** The root of the tree. */
+    std::unique_ptr<Node> root_;
+    /** The number of entries in this index. */
+    long nEntries_;
+    /** The number of vantage points whose entries have been removed. */
+    long nRemovedVantagePoints_;
+};
+} /* namespace solver */
+
+#endif /* SOLVER_VPTREEOBSERVATIONINDEX_HPP_ */
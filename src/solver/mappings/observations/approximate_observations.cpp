@@ -21,6 +21,7 @@
 
 #include "solver/mappings/observations/ObservationPool.hpp"
 #include "solver/mappings/observations/ObservationMapping.hpp"
+#include "solver/mappings/observations/VpTreeObservationIndex.hpp"
 
 namespace solver {
 /* --------------------- ApproximateObservationPool --------------------- */
@@ -31,16 +32,22 @@ ApproximateObservationPool::ApproximateObservationPool(Solver *solver, double ma
 
 std::unique_ptr<ObservationMapping> ApproximateObservationPool::createObservationMapping(
         ActionNode *owner) {
-    return std::make_unique<ApproximateObservationMap>(owner, solver_, maxDistance_);
+    return allocate_unique<ApproximateObservationMap>(solver_->getPolicy()->getAllocator(),
+            owner, solver_, maxDistance_, createObservationIndex());
+}
+
+std::unique_ptr<ObservationIndex> ApproximateObservationPool::createObservationIndex() {
+    return std::make_unique<VpTreeObservationIndex>();
 }
 
 /* ---------------------- ApproximateObservationMap ---------------------- */
 ApproximateObservationMap::ApproximateObservationMap(ActionNode *owner, Solver *solver,
-        double maxDistance) :
+        double maxDistance, std::unique_ptr<ObservationIndex> index) :
         ObservationMapping(owner),
         solver_(solver),
         maxDistance_(maxDistance),
         entries_(),
+        index_(std::move(index)),
         totalVisitCount_(0) {
 }
 
@@ -52,12 +59,14 @@ BeliefNode* ApproximateObservationMap::getBelief(Observation const &obs) const {
     return entry->getBeliefNode();
 }
 BeliefNode* ApproximateObservationMap::createBelief(const Observation& obs) {
+    SlabAllocator *allocator = solver_->getPolicy()->getAllocator();
     std::unique_ptr<ApproximateObservationMapEntry> entry = (
-            std::make_unique<ApproximateObservationMapEntry>());
+            allocate_unique<ApproximateObservationMapEntry>(allocator));
     entry->map_ = this;
     entry->observation_ = obs.copy();
-    entry->childNode_ = std::make_unique<BeliefNode>(entry.get(), solver_);
+    entry->childNode_ = allocate_unique<BeliefNode>(allocator, entry.get(), solver_);
     BeliefNode *node = entry->childNode_.get();
+    index_->addEntry(entry.get());
     entries_.push_back(std::move(entry));
     return node;
 }
@@ -65,8 +74,13 @@ long ApproximateObservationMap::getNChildren() const {
     return entries_.size();
 }
 
-void ApproximateObservationMap::deleteChild(ObservationMappingEntry const *entry) {
+std::unique_ptr<BeliefNode> ApproximateObservationMap::deleteChild(
+        ObservationMappingEntry const *entry) {
     totalVisitCount_ -= entry->getVisitCount(); // Negate the visit count
+    std::unique_ptr<BeliefNode> childNode = std::move(
+            const_cast<ApproximateObservationMapEntry &>(
+                    static_cast<ApproximateObservationMapEntry const &>(*entry)).childNode_);
+    index_->removeEntry(entry);
     int lastEntryNo = entries_.size() - 1;
     for (int i = 0; i < lastEntryNo; i++) {
         ApproximateObservationMapEntry *otherEntry = entries_[i].get();
@@ -78,14 +92,14 @@ void ApproximateObservationMap::deleteChild(ObservationMappingEntry const *entry
     }
     // Remove the last entry.
     entries_.pop_back();
+    return childNode;
 }
 
-std::vector<ObservationMappingEntry const *> ApproximateObservationMap::getChildEntries() const {
-    std::vector<ObservationMappingEntry const *> returnEntries;
+void ApproximateObservationMap::forEachChildEntry(
+        tapir::FunctionRef<void(ObservationMappingEntry const *)> function) const {
     for (std::unique_ptr<ApproximateObservationMapEntry> const &entry : entries_) {
-        returnEntries.push_back(entry.get());
+        function(entry.get());
     }
-    return returnEntries;
 }
 ObservationMappingEntry *ApproximateObservationMap::getEntry(Observation const &obs) {
     ApproximateObservationMap const * constThis = const_cast<ApproximateObservationMap const *>(this);
@@ -93,16 +107,7 @@ ObservationMappingEntry *ApproximateObservationMap::getEntry(Observation const &
     return const_cast<ObservationMappingEntry *>(result);
 }
 ObservationMappingEntry const *ApproximateObservationMap::getEntry(Observation const &obs) const {
-    double shortestDistance = maxDistance_;
-    ApproximateObservationMapEntry const *bestEntry = nullptr;
-    for (std::unique_ptr<ApproximateObservationMapEntry> const &entry : entries_) {
-        double distance = entry->observation_->distanceTo(obs);
-        if (distance <= shortestDistance) {
-            shortestDistance = distance;
-            bestEntry = entry.get();
-        }
-    }
-    return bestEntry;
+    return index_->findNearest(obs, maxDistance_);
 }
 
 long ApproximateObservationMap::getTotalVisitCount() const {
@@ -113,8 +118,8 @@ long ApproximateObservationMap::getTotalVisitCount() const {
 ObservationMapping *ApproximateObservationMapEntry::getMapping() const {
     return map_;
 }
-std::unique_ptr<Observation> ApproximateObservationMapEntry::getObservation() const {
-    return observation_->copy();
+Observation const &ApproximateObservationMapEntry::peekObservation() const {
+    return *observation_;
 }
 BeliefNode *ApproximateObservationMapEntry::getBeliefNode() const {
     return childNode_.get();
@@ -190,14 +195,17 @@ std::unique_ptr<ObservationMapping> ApproximateObservationTextSerializer::loadOb
         entryStream >> visitCount;
 
         // Create the entry with appropriate values.
+        SlabAllocator *allocator = getSolver()->getPolicy()->getAllocator();
         std::unique_ptr<ApproximateObservationMapEntry> entry = (
-                std::make_unique<ApproximateObservationMapEntry>());
+                allocate_unique<ApproximateObservationMapEntry>(allocator));
         entry->map_ = &approxMap;
         entry->observation_ = std::move(obs);
         entry->visitCount_ = visitCount;
-        entry->childNode_ = std::make_unique<BeliefNode>(childId, entry.get(), getSolver());
+        entry->childNode_ = allocate_unique<BeliefNode>(allocator, childId, entry.get(),
+                getSolver());
 
-        // Add the entry to the vector.
+        // Add the entry to the index and the vector.
+        approxMap.index_->addEntry(entry.get());
         approxMap.entries_.push_back(std::move(entry));
     }
     // Read the last line for the closing brace.
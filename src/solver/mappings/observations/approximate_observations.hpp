@@ -3,11 +3,11 @@
  * Provides an implementation of the observation mapping interface that is designed for
  * continuous observation spaces.
  *
- * WARNING: This implementation is currently quite rough; it needs better algorithms and data
- * structures (e.g. some kind of algorithm for dynamic clustering of observations).
+ * WARNING: This implementation is currently quite rough; it needs better algorithms (e.g. some
+ * kind of algorithm for dynamic clustering of observations).
  *
- * Currently, it works by storing the observation entries in a vector, and comparing every new
- * observation to all of the previous ones - this is clearly rather inefficient.
+ * Currently, it works by grouping each new observation with the nearest of the previous ones, if
+ * it is close enough; the nearest observation is found via an ObservationIndex.
  */
 #ifndef SOLVER_APPROXIMATE_OBSERVATIONS_HPP_
 #define SOLVER_APPROXIMATE_OBSERVATIONS_HPP_
@@ -21,6 +21,7 @@
 
 #include "solver/serialization/Serializer.hpp"
 
+#include "solver/mappings/observations/ObservationIndex.hpp"
 #include "solver/mappings/observations/ObservationPool.hpp"
 #include "solver/mappings/observations/ObservationMapping.hpp"
 
@@ -51,6 +52,14 @@ class ApproximateObservationPool: public solver::ObservationPool {
 
     virtual std::unique_ptr<ObservationMapping> createObservationMapping(ActionNode *owner) override;
 
+    /** Creates the index which a new mapping will use to find the nearest entry to an
+     * observation.
+     *
+     * The default implementation creates a VpTreeObservationIndex, which requires distanceTo() to
+     * be a metric; this can be overridden to use an index suited to a specific observation space.
+     */
+    virtual std::unique_ptr<ObservationIndex> createObservationIndex();
+
   private:
     /** The solver. */
     Solver *solver_;
@@ -60,13 +69,14 @@ class ApproximateObservationPool: public solver::ObservationPool {
 
 /** A concrete class implementing ObservationMapping for a continuous set of observations.
  *
- * The mapping entries are stored in a vector; entries are then looked up by iterating over the
- * vector and finding the first entry that is within the maximum distance.
+ * The mapping entries are stored in a vector, and also added to an ObservationIndex; entries are
+ * then looked up by using the index to find the nearest entry that is within the maximum
+ * distance.
  *
  * In effect, each entry is a sphere in the observation space, which is centered at the first
  * observation used to make that entry, and has a radius of the given maximum distance.
  *
- * Note that this is sensitive to the order in which the entries are stored, because there may
+ * Note that this is sensitive to the order in which the entries are made, because there may
  * be more than one entry that meets the distance criterion for a given observation.
  */
 class ApproximateObservationMap: public solver::ObservationMapping {
@@ -75,9 +85,11 @@ class ApproximateObservationMap: public solver::ObservationMapping {
     friend class ApproximateObservationTextSerializer;
 
     /** Creates a new ApproximateObservationMap which will be owned by the given ActionNode, and
-     * for which the maximum distance for an entry to "match" is the given distance.
+     * for which the maximum distance for an entry to "match" is the given distance; the given
+     * index will be used to look up entries.
      */
-    ApproximateObservationMap(ActionNode *owner, Solver *solver, double maxDistance);
+    ApproximateObservationMap(ActionNode *owner, Solver *solver, double maxDistance,
+            std::unique_ptr<ObservationIndex> index);
     virtual ~ApproximateObservationMap() = default;
     _NO_COPY_OR_MOVE(ApproximateObservationMap);
 
@@ -86,10 +98,12 @@ class ApproximateObservationMap: public solver::ObservationMapping {
     virtual BeliefNode *createBelief(Observation const &obs) override;
     virtual long getNChildren() const override;
 
-    virtual void deleteChild(ObservationMappingEntry const *entry) override;
+    virtual std::unique_ptr<BeliefNode> deleteChild(ObservationMappingEntry const *entry)
+            override;
 
     /* -------------- Retrieval of mapping entries. ---------------- */
-    virtual std::vector<ObservationMappingEntry const *> getChildEntries() const override;
+    virtual void forEachChildEntry(
+            tapir::FunctionRef<void(ObservationMappingEntry const *)> function) const override;
     virtual ObservationMappingEntry *getEntry(Observation const &obs) override;
     virtual ObservationMappingEntry const *getEntry(Observation const &obs) const override;
 
@@ -104,6 +118,8 @@ class ApproximateObservationMap: public solver::ObservationMapping {
     double maxDistance_;
     /** The vector of entries for this mapping. */
     std::vector<std::unique_ptr<ApproximateObservationMapEntry>> entries_;
+    /** The index used to find the nearest entry to an observation. */
+    std::unique_ptr<ObservationIndex> index_;
 
     /** The total number of visits over all of the entries in this mapping. */
     long totalVisitCount_;
@@ -119,7 +135,7 @@ class ApproximateObservationMapEntry : public solver::ObservationMappingEntry {
     friend class ApproximateObservationTextSerializer;
 public:
     virtual ObservationMapping *getMapping() const override;
-    virtual std::unique_ptr<Observation> getObservation() const override;
+    virtual Observation const &peekObservation() const override;
     virtual BeliefNode *getBeliefNode() const override;
     virtual long getVisitCount() const override;
 
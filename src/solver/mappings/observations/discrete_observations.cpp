@@ -5,6 +5,8 @@
 #include "solver/mappings/observations/discrete_observations.hpp"
 
 #include <algorithm>
+#include <cstddef>                      // for size_t
+#include <cstdint>                      // for uint64_t
 #include <iostream>
 #include <memory>
 #include <string>
@@ -29,14 +31,17 @@ DiscreteObservationPool::DiscreteObservationPool(Solver *solver) :
 }
 
 std::unique_ptr<ObservationMapping> DiscreteObservationPool::createObservationMapping(ActionNode *owner) {
-    return std::make_unique<DiscreteObservationMap>(owner, solver_);
+    return allocate_unique<DiscreteObservationMap>(solver_->getPolicy()->getAllocator(), owner,
+            solver_);
 }
 
 /* ---------------------- DiscreteObservationMap ---------------------- */
 DiscreteObservationMap::DiscreteObservationMap(ActionNode *owner, Solver *solver) :
         ObservationMapping(owner),
         solver_(solver),
-        childMap_(),
+        slots_(),
+        tableBits_(0),
+        nEntries_(0),
         totalVisitCount_(0) {
 }
 
@@ -49,57 +54,142 @@ BeliefNode* DiscreteObservationMap::getBelief(Observation const &obs) const {
     }
 }
 BeliefNode* DiscreteObservationMap::createBelief(const Observation& obs) {
+    SlabAllocator *allocator = solver_->getPolicy()->getAllocator();
     std::unique_ptr<DiscreteObservationMapEntry> entry = (
-          std::make_unique<DiscreteObservationMapEntry>());
+          allocate_unique<DiscreteObservationMapEntry>(allocator));
     entry->map_ = this;
     entry->observation_ = obs.copy();
-    entry->childNode_ = std::make_unique<BeliefNode>(entry.get(), solver_);
+    entry->childNode_ = allocate_unique<BeliefNode>(allocator, entry.get(), solver_);
     BeliefNode *node = entry->childNode_.get();
 
-    childMap_.emplace(obs.copy(), std::move(entry));
+    insertEntry(obs.hash(), std::move(entry));
     return node;
 }
 long DiscreteObservationMap::getNChildren() const {
-    return childMap_.size();
+    return nEntries_;
 }
 
-void DiscreteObservationMap::deleteChild(ObservationMappingEntry const *entry) {
+std::unique_ptr<BeliefNode> DiscreteObservationMap::deleteChild(
+        ObservationMappingEntry const *entry) {
     totalVisitCount_ -= entry->getVisitCount(); // Negate the visit count.
-    childMap_.erase(childMap_.find(entry->getObservation())); // Now delete the entry altogether.
+    Observation const &obs = entry->peekObservation();
+    std::unique_ptr<DiscreteObservationMapEntry> ownEntry = eraseSlot(findSlot(obs, obs.hash()));
+    return std::move(ownEntry->childNode_);
 }
 
-std::vector<ObservationMappingEntry const *> DiscreteObservationMap::getChildEntries() const {
-    std::vector<ObservationMappingEntry const *> returnEntries;
-    for (ChildMap::value_type const &mapEntry : childMap_) {
-        returnEntries.push_back(mapEntry.second.get());
+void DiscreteObservationMap::forEachChildEntry(
+        tapir::FunctionRef<void(ObservationMappingEntry const *)> function) const {
+    for (Slot const &slot : slots_) {
+        if (slot.entry != nullptr) {
+            function(slot.entry.get());
+        }
     }
-    return returnEntries;
 }
 ObservationMappingEntry *DiscreteObservationMap::getEntry(Observation const &obs) {
-    try {
-        return childMap_.at(obs.copy()).get();
-    } catch (const std::out_of_range &oor) {
-        return nullptr;
-    }
+    long index = findSlot(obs, obs.hash());
+    return index < 0 ? nullptr : slots_[index].entry.get();
 }
 ObservationMappingEntry const *DiscreteObservationMap::getEntry(Observation const &obs) const {
-    try {
-        return childMap_.at(obs.copy()).get();
-    } catch (const std::out_of_range &oor) {
-        return nullptr;
-    }
+    long index = findSlot(obs, obs.hash());
+    return index < 0 ? nullptr : slots_[index].entry.get();
 }
 
 long DiscreteObservationMap::getTotalVisitCount() const {
     return totalVisitCount_;
 }
 
+/* ============================ PRIVATE ============================ */
+
+DiscreteObservationMap::Slot::Slot() :
+        hash(0),
+        entry(nullptr) {
+}
+
+DiscreteObservationMap::Slot::Slot(std::size_t theHash,
+        std::unique_ptr<DiscreteObservationMapEntry> theEntry) :
+        hash(theHash),
+        entry(std::move(theEntry)) {
+}
+
+long DiscreteObservationMap::findSlot(Observation const &obs, std::size_t hash) const {
+    if (tableBits_ == 0) {
+        return -1;
+    }
+    std::size_t mask = slots_.size() - 1;
+    for (std::size_t i = getHomeSlot(hash); slots_[i].entry != nullptr; i = (i + 1) & mask) {
+        Slot const &slot = slots_[i];
+        if (slot.hash == hash && slot.entry->observation_->equals(obs)) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+std::size_t DiscreteObservationMap::getHomeSlot(std::size_t hash) const {
+    // Fibonacci hashing spreads out observations whose hashes are small consecutive numbers.
+    std::uint64_t mixed = static_cast<std::uint64_t>(hash) * 0x9E3779B97F4A7C15ULL;
+    return static_cast<std::size_t>(mixed >> (64 - tableBits_));
+}
+
+void DiscreteObservationMap::insertEntry(std::size_t hash,
+        std::unique_ptr<DiscreteObservationMapEntry> entry) {
+    // The table is kept at most half full.
+    if (tableBits_ == 0) {
+        rehash(MIN_TABLE_BITS);
+    } else if (2 * static_cast<std::size_t>(nEntries_ + 1) > slots_.size()) {
+        rehash(tableBits_ + 1);
+    }
+    placeEntry(hash, std::move(entry));
+    nEntries_++;
+}
+
+void DiscreteObservationMap::placeEntry(std::size_t hash,
+        std::unique_ptr<DiscreteObservationMapEntry> entry) {
+    std::size_t mask = slots_.size() - 1;
+    std::size_t i = getHomeSlot(hash);
+    while (slots_[i].entry != nullptr) {
+        i = (i + 1) & mask;
+    }
+    slots_[i].hash = hash;
+    slots_[i].entry = std::move(entry);
+}
+
+void DiscreteObservationMap::rehash(int tableBits) {
+    std::vector<Slot> oldSlots;
+    oldSlots.swap(slots_);
+    tableBits_ = tableBits;
+    slots_.resize(std::size_t(1) << tableBits);
+    for (Slot &slot : oldSlots) {
+        if (slot.entry != nullptr) {
+            placeEntry(slot.hash, std::move(slot.entry));
+        }
+    }
+}
+
+std::unique_ptr<DiscreteObservationMapEntry> DiscreteObservationMap::eraseSlot(long index) {
+    std::unique_ptr<DiscreteObservationMapEntry> entry = std::move(slots_[index].entry);
+    nEntries_--;
+
+    // Shift back any later entries in the same run that could be in the hole; this keeps every
+    // entry reachable from its home slot without needing tombstones.
+    std::size_t mask = slots_.size() - 1;
+    std::size_t hole = index;
+    for (std::size_t i = (hole + 1) & mask; slots_[i].entry != nullptr; i = (i + 1) & mask) {
+        std::size_t home = getHomeSlot(slots_[i].hash);
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            slots_[hole] = std::move(slots_[i]);
+            hole = i;
+        }
+    }
+    return entry;
+}
+
 /* ----------------- DiscreteObservationMapEntry ----------------- */
 ObservationMapping *DiscreteObservationMapEntry::getMapping() const {
     return map_;
 }
-std::unique_ptr<Observation> DiscreteObservationMapEntry::getObservation() const {
-    return observation_->copy();
+Observation const &DiscreteObservationMapEntry::peekObservation() const {
+    return *observation_;
 }
 BeliefNode *DiscreteObservationMapEntry::getBeliefNode() const {
     return childNode_.get();
@@ -132,12 +222,15 @@ void DiscreteObservationTextSerializer::saveObservationMapping(
     os << discMap.getNChildren() << " observation children; ";
     os << discMap.getTotalVisitCount() << " visits {" << std::endl;
     std::vector<std::string> lines;
-    for (DiscreteObservationMap::ChildMap::value_type const &entry : discMap.childMap_) {
+    for (DiscreteObservationMap::Slot const &slot : discMap.slots_) {
+        if (slot.entry == nullptr) {
+            continue;
+        }
         std::ostringstream sstr;
         sstr << "\t";
-        saveObservation(entry.first.get(), sstr);
-        sstr << " -> NODE " << entry.second->childNode_->getId();
-        sstr << "; " << entry.second->visitCount_ << " visits";
+        saveObservation(slot.entry->observation_.get(), sstr);
+        sstr << " -> NODE " << slot.entry->childNode_->getId();
+        sstr << "; " << slot.entry->visitCount_ << " visits";
         sstr << std::endl;
         lines.push_back(sstr.str());
     }
@@ -175,15 +268,18 @@ std::unique_ptr<ObservationMapping> DiscreteObservationTextSerializer::loadObser
         entryStream >> visitCount;
 
         // Create the mapping entry and set its values.
+        SlabAllocator *allocator = getSolver()->getPolicy()->getAllocator();
         std::unique_ptr<DiscreteObservationMapEntry> entry = (
-                    std::make_unique<DiscreteObservationMapEntry>());
+                    allocate_unique<DiscreteObservationMapEntry>(allocator));
         entry->map_ = &discMap;
         entry->observation_ = std::move(obs);
-        entry->childNode_ = std::make_unique<BeliefNode>(childId, entry.get(), getSolver());
+        entry->childNode_ = allocate_unique<BeliefNode>(allocator, childId, entry.get(),
+                getSolver());
         entry->visitCount_ = visitCount;
 
         // Add the entry to the map
-        discMap.childMap_.emplace(entry->observation_->copy(), std::move(entry));
+        std::size_t hash = entry->observation_->hash();
+        discMap.insertEntry(hash, std::move(entry));
     }
     // Read the last line for the closing brace.
     std::getline(is, line);
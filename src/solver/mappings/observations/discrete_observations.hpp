@@ -3,16 +3,17 @@
  * Provides an implementation of the observation mapping interface that is designed for a space
  * of discrete observations, which could potentially be relatively large but only sparsely used.
  *
- * This is achieved by storing the mapping as a hash table (std::unordered_set), in which the
- * observations can be looked up via a hash function. Doing so allows entries to be stored only
- * for the observations that are actually encountered.
+ * This is achieved by storing the mapping as a hash table, in which the observations can be
+ * looked up via a hash function. Doing so allows entries to be stored only for the observations
+ * that are actually encountered.
  */
 #ifndef SOLVER_DISCRETE_OBSERVATIONS_HPP_
 #define SOLVER_DISCRETE_OBSERVATIONS_HPP_
 
+#include <cstddef>                      // for size_t
 #include <iostream>
 #include <memory>
-#include <unordered_map>
+#include <vector>
 
 #include "solver/BeliefNode.hpp"
 
@@ -48,8 +49,13 @@ class DiscreteObservationPool: public solver::ObservationPool {
 
 /** A concrete class implementing ObservationMapping for a discrete set of observations.
  *
- * The mapping entries are stored in a hash table (std::unordered_set), which maps each observation
- * to its associated entry in the mapping, or nullptr if there is no entry yet.
+ * The mapping entries are stored in an open-addressing hash table with linear probing, in which
+ * each slot holds the hash of its observation next to the entry, so that most probes don't need
+ * to call the virtual equals() method of the observation.
+ *
+ * Most action nodes only have a few observation children, so the table starts out small, and is
+ * only allocated once the first entry is added. Even for a few entries, probing the table is
+ * faster than searching them linearly (see bench_obsmap).
  */
 class DiscreteObservationMap: public solver::ObservationMapping {
   public:
@@ -66,10 +72,12 @@ class DiscreteObservationMap: public solver::ObservationMapping {
     virtual BeliefNode *createBelief(Observation const &obs) override;
     virtual long getNChildren() const override;
 
-    virtual void deleteChild(ObservationMappingEntry const *entry) override;
+    virtual std::unique_ptr<BeliefNode> deleteChild(ObservationMappingEntry const *entry)
+            override;
 
     /* -------------- Retrieval of mapping entries. ---------------- */
-    virtual std::vector<ObservationMappingEntry const *> getChildEntries() const override;
+    virtual void forEachChildEntry(
+            tapir::FunctionRef<void(ObservationMappingEntry const *)> function) const override;
     virtual ObservationMappingEntry *getEntry(Observation const &obs) override;
     virtual ObservationMappingEntry const *getEntry(Observation const &obs) const override;
 
@@ -80,32 +88,43 @@ class DiscreteObservationMap: public solver::ObservationMapping {
     /** The solver. */
     Solver *solver_;
 
-    /** A hashing operator that works on unique_ptr<Observation> by calling the virtual hash method
-     * of the observation itself.
-     */
-    struct HashContents {
-        std::size_t operator()(std::unique_ptr<Observation> const &obs) const {
-            return obs->hash();
-        }
-    };
+    /** The number of bits in the size of the table when the first entry is added. */
+    static int const MIN_TABLE_BITS = 2;
 
-    /** An equality operator compares unique_ptr<Observation> by calling the virtual equals() method
-     * of the observation.
-     */
-    struct EqualContents {
-        std::size_t operator()(std::unique_ptr<Observation> const &o1,
-                std::unique_ptr<Observation> const &o2) const {
-            return o1->equals(*o2);
-        }
-    };
+    /** A slot in the table of entries; the slot is empty iff the entry is null. */
+    struct Slot {
+        /** Makes an empty slot. */
+        Slot();
+        /** Makes a slot holding the given entry, whose observation has the given hash. */
+        Slot(std::size_t theHash, std::unique_ptr<DiscreteObservationMapEntry> theEntry);
 
-    /** A typedef to make the syntax for this mapping type less verbose. */
-    typedef std::unordered_map<std::unique_ptr<Observation>,
-            std::unique_ptr<DiscreteObservationMapEntry>,
-            HashContents, EqualContents> ChildMap;
+        /** The hash of the observation for the entry. */
+        std::size_t hash;
+        /** The entry in this slot. */
+        std::unique_ptr<DiscreteObservationMapEntry> entry;
+    };
 
-    /** The mapping of observations to their entries. */
-    ChildMap childMap_;
+    /** Returns the index of the slot holding the entry for the given observation, which has the
+     * given hash, or -1 if there is no such entry.
+     */
+    long findSlot(Observation const &obs, std::size_t hash) const;
+    /** Returns the index of the slot at which a search for the given hash starts. */
+    std::size_t getHomeSlot(std::size_t hash) const;
+    /** Adds the given entry, whose observation has the given hash. */
+    void insertEntry(std::size_t hash, std::unique_ptr<DiscreteObservationMapEntry> entry);
+    /** Places the given entry into the first free slot for its hash; this requires a table. */
+    void placeEntry(std::size_t hash, std::unique_ptr<DiscreteObservationMapEntry> entry);
+    /** Moves all of the entries into a new table with 2^tableBits slots. */
+    void rehash(int tableBits);
+    /** Removes the entry from the slot with the given index, and returns it. */
+    std::unique_ptr<DiscreteObservationMapEntry> eraseSlot(long index);
+
+    /** The slots holding the entries; this is empty until the first entry is added. */
+    std::vector<Slot> slots_;
+    /** The number of bits in the size of the table, or 0 if there is no table yet. */
+    int tableBits_;
+    /** The number of entries in this mapping. */
+    long nEntries_;
 
     /** The total visit count for all of the entries. */
     long totalVisitCount_;
@@ -123,7 +142,7 @@ class DiscreteObservationMapEntry : public solver::ObservationMappingEntry {
 
 public:
     virtual ObservationMapping *getMapping() const override;
-    virtual std::unique_ptr<Observation> getObservation() const override;
+    virtual Observation const &peekObservation() const override;
     virtual BeliefNode *getBeliefNode() const override;
     virtual long getVisitCount() const override;
 
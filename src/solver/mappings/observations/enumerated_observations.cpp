@@ -31,7 +31,8 @@ EnumeratedObservationPool::EnumeratedObservationPool(Solver *solver,
 
 std::unique_ptr<ObservationMapping>
     EnumeratedObservationPool::createObservationMapping(ActionNode *owner) {
-    return std::make_unique<EnumeratedObservationMap>(owner, solver_, observations_);
+    return allocate_unique<EnumeratedObservationMap>(solver_->getPolicy()->getAllocator(),
+            owner, solver_, observations_);
 }
 
 
@@ -42,7 +43,8 @@ EnumeratedObservationMap::EnumeratedObservationMap(ActionNode *owner, Solver *so
                 solver_(solver),
                 allObservations_(allObservations),
                 nObservations_(allObservations.size()),
-                entries_(std::make_unique<EnumeratedObservationMapEntry[]>(nObservations_)),
+                entries_(allocate_unique_array<EnumeratedObservationMapEntry>(
+                        solver_->getPolicy()->getAllocator(), nObservations_)),
                 nChildren_(0),
                 totalVisitCount_(0) {
     for (int i = 0; i < nObservations_; i++) {
@@ -62,7 +64,8 @@ BeliefNode* EnumeratedObservationMap::createBelief(
         const Observation& obs) {
     long code = static_cast<DiscretizedPoint const &>(obs).getBinNumber();
     EnumeratedObservationMapEntry &entry = entries_[code];
-    entry.childNode_ = std::make_unique<BeliefNode>(&entry, solver_);
+    entry.childNode_ = allocate_unique<BeliefNode>(solver_->getPolicy()->getAllocator(), &entry,
+            solver_);
     nChildren_++;
     return entry.getBeliefNode();
 }
@@ -70,21 +73,21 @@ long EnumeratedObservationMap::getNChildren() const {
     return nChildren_;
 }
 
-void EnumeratedObservationMap::deleteChild(ObservationMappingEntry const *entry) {
+std::unique_ptr<BeliefNode> EnumeratedObservationMap::deleteChild(
+        ObservationMappingEntry const *entry) {
     totalVisitCount_ -= entry->getVisitCount(); // Negate the visit count.
-    // Now delete the child node.
-    const_cast<EnumeratedObservationMapEntry &>(
-            static_cast<EnumeratedObservationMapEntry const &>(*entry)).childNode_ = nullptr;
+    // Now remove the child node.
+    return std::move(const_cast<EnumeratedObservationMapEntry &>(
+            static_cast<EnumeratedObservationMapEntry const &>(*entry)).childNode_);
 }
 
-std::vector<ObservationMappingEntry const *> EnumeratedObservationMap::getChildEntries() const {
-    std::vector<ObservationMappingEntry const *> returnEntries;
+void EnumeratedObservationMap::forEachChildEntry(
+        tapir::FunctionRef<void(ObservationMappingEntry const *)> function) const {
     for (int i = 0; i < nObservations_; i++) {
         if (entries_[i].childNode_ != nullptr) {
-            returnEntries.push_back(&entries_[i]);
+            function(&entries_[i]);
         }
     }
-    return returnEntries;
 }
 ObservationMappingEntry *EnumeratedObservationMap::getEntry(Observation const &obs) {
     long code = static_cast<DiscretizedPoint const &>(obs).getBinNumber();
@@ -103,9 +106,9 @@ long EnumeratedObservationMap::getTotalVisitCount() const {
 ObservationMapping *EnumeratedObservationMapEntry::getMapping() const {
     return map_;
 }
-std::unique_ptr<Observation> EnumeratedObservationMapEntry::getObservation() const {
+Observation const &EnumeratedObservationMapEntry::peekObservation() const {
     EnumeratedObservationMap const &enumMap = static_cast<EnumeratedObservationMap const &>(*map_);
-    return enumMap.allObservations_[index_]->copy();
+    return *enumMap.allObservations_[index_];
 }
 BeliefNode *EnumeratedObservationMapEntry::getBeliefNode() const {
     return childNode_.get();
@@ -143,7 +146,7 @@ void EnumeratedObservationTextSerializer::saveObservationMapping(
         EnumeratedObservationMapEntry const &entry = enumMap.entries_[i];
         if (entry.childNode_ != nullptr) {
             os << "\t";
-            saveObservation(entry.getObservation().get(), os);
+            saveObservation(&entry.peekObservation(), os);
             os << " -> NODE " << entry.childNode_->getId();
             os << "; " << entry.visitCount_ << " visits";
             os << std::endl;
@@ -181,7 +184,8 @@ getSolver()->getObservationPool()->createObservationMapping(owner));
         // Create the child node for the entry and set its visit count.
         long code = static_cast<DiscretizedPoint const &>(*obs).getBinNumber();
         EnumeratedObservationMapEntry &entry = enumMap.entries_[code];
-        entry.childNode_ = std::make_unique<BeliefNode>(childId, &entry, getSolver());
+        entry.childNode_ = allocate_unique<BeliefNode>(getSolver()->getPolicy()->getAllocator(),
+                childId, &entry, getSolver());
         enumMap.nChildren_++;
         entry.visitCount_ = visitCount;
     }
@@ -81,10 +81,12 @@ class EnumeratedObservationMap: public solver::ObservationMapping {
     virtual BeliefNode *createBelief(Observation const &obs) override;
     virtual long getNChildren() const override;
 
-    virtual void deleteChild(ObservationMappingEntry const *entry) override;
+    virtual std::unique_ptr<BeliefNode> deleteChild(ObservationMappingEntry const *entry)
+            override;
 
     /* -------------- Retrieval of mapping entries. ---------------- */
-    virtual std::vector<ObservationMappingEntry const *> getChildEntries() const override;
+    virtual void forEachChildEntry(
+            tapir::FunctionRef<void(ObservationMappingEntry const *)> function) const override;
     virtual ObservationMappingEntry *getEntry(Observation const &obs) override;
     virtual ObservationMappingEntry const *getEntry(Observation const &obs) const override;
 
@@ -122,7 +124,7 @@ class EnumeratedObservationMapEntry : public solver::ObservationMappingEntry {
 
 public:
     virtual ObservationMapping *getMapping() const override;
-    virtual std::unique_ptr<Observation> getObservation() const override;
+    virtual Observation const &peekObservation() const override;
     virtual BeliefNode *getBeliefNode() const override;
     virtual long getVisitCount() const override;
 
@@ -4,6 +4,7 @@
  */
 #include "solver/search/action-choosers/choosers.hpp"
 
+#include "solver/ActionNode.hpp"
 #include "solver/BeliefNode.hpp"
 
 #include "solver/mappings/actions/ActionMapping.hpp"
@@ -11,66 +12,27 @@
 
 namespace solver {
 namespace choosers {
-std::unique_ptr<Action> max_action(BeliefNode const *node) {
-    std::unique_ptr<Action> maxAction = nullptr;
-    double maxQValue = -std::numeric_limits<double>::infinity();
-
-    ActionMapping *mapping = node->getMapping();
-    for (ActionMappingEntry const *entry : mapping->getVisitedEntries()) {
-        double qValue = entry->getMeanQValue();
-        if (qValue > maxQValue) {
-            maxQValue = qValue;
-            maxAction = entry->getAction();
-        }
+namespace {
+/** Returns the action for the given entry, or nullptr if there is no entry. */
+std::unique_ptr<Action> get_action(ActionMappingEntry const *entry) {
+    if (entry == nullptr) {
+        return nullptr;
     }
-    return std::move(maxAction);
+    return entry->getAction();
 }
+} /* namespace */
 
-std::unique_ptr<Action> robust_action(BeliefNode const *node) {
-    std::unique_ptr<Action> robustAction = nullptr;
-    long maxVisitCount = 0;
-    double robustQValue = -std::numeric_limits<double>::infinity();
-
-    ActionMapping *mapping = node->getMapping();
-    for (ActionMappingEntry const *entry : mapping->getVisitedEntries()) {
-        double visitCount = entry->getVisitCount();
-        double qValue = entry->getMeanQValue();
-        if (visitCount > maxVisitCount) {
-            maxVisitCount = visitCount;
-            robustQValue = qValue;
-            robustAction = entry->getAction();
-        } else if (visitCount == maxVisitCount && qValue > robustQValue) {
-            robustQValue = qValue;
-            robustAction = entry->getAction();
-        }
-    }
-    return std::move(robustAction);
+std::unique_ptr<Action> max_action(BeliefNode const *node) {
+    return get_action(node->getMapping()->getMaxQEntry());
 }
 
-std::unique_ptr<Action> ucb_action(BeliefNode const *node, double explorationCoefficient) {
-    std::unique_ptr<Action> ucbAction = nullptr;
-    double maxUcbValue = -std::numeric_limits<double>::infinity();
-
-    ActionMapping *mapping = node->getMapping();
-    for (ActionMappingEntry const *entry : mapping->getVisitedEntries()) {
-        // Ignore illegal actions.
-        if (!entry->isLegal()) {
-            continue;
-        }
+std::unique_ptr<Action> robust_action(BeliefNode const *node) {
+    return get_action(node->getMapping()->getRobustEntry());
+}
 
-        double tmpValue = entry->getMeanQValue()
-                + explorationCoefficient
-                        * std::sqrt(
-                                std::log(mapping->getTotalVisitCount()) / entry->getVisitCount());
-        if (!std::isfinite(tmpValue)) {
-            debug::show_message("ERROR: Infinite/NaN value!?");
-        }
-        if (maxUcbValue < tmpValue) {
-            maxUcbValue = tmpValue;
-            ucbAction = entry->getAction();
-        }
-    }
-    return std::move(ucbAction);
+std::unique_ptr<Action> ucb_action(BeliefNode const *node, double explorationCoefficient,
+        double virtualLoss) {
+    return get_action(node->getMapping()->getUcbEntry(explorationCoefficient, virtualLoss));
 }
 } /* namespace choosers */
 } /* namespace solver */
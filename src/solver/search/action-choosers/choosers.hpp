@@ -20,8 +20,14 @@ namespace choosers {
 std::unique_ptr<Action> max_action(BeliefNode const *node);
 /** Returns the action with the highest visit count (ties are broken by max. value) */
 std::unique_ptr<Action> robust_action(BeliefNode const *node);
-/** Returns the action with the highest UCB value, using the given exploration coefficient. */
-std::unique_ptr<Action> ucb_action(BeliefNode const *node, double explorationCoefficient);
+/** Returns the action with the highest UCB value, using the given exploration coefficient.
+ *
+ * Each virtual loss on an action (see ActionNode::getVirtualLossCount) counts as an extra visit
+ * with a value of virtualLoss below the current mean, so that concurrent search threads will
+ * spread out across different branches.
+ */
+std::unique_ptr<Action> ucb_action(BeliefNode const *node, double explorationCoefficient,
+        double virtualLoss = 0);
 } /* namespace choosers */
 } /* namespace solver */
 
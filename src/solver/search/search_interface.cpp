@@ -9,6 +9,7 @@
 
 #include <functional>
 #include <memory>
+#include <vector>
 
 #include "solver/BeliefNode.hpp"
 #include "solver/BeliefTree.hpp"
@@ -110,18 +111,33 @@ SearchStatus BasicSearchStrategy::extendAndBackup(HistorySequence *sequence, lon
         return SearchStatus::ERROR;
     }
 
+    // In tree-parallel search, each step holds a virtual loss until the sequence is backed up.
+    Options const *options = solver_->getOptions();
+    bool useVirtualLoss = options->useTreeParallelSearch && options->nThreads > 1;
+    std::vector<HistoryEntry const *> virtualLossEntries;
+
+    tapir::Deadline const &deadline = solver_->getSearchDeadline();
     while (true) {
         if (currentNode->getDepth() >= maximumDepth) {
             // We've hit the depth limit, so we can't generate any more steps in the sequence.
             status = SearchStatus::OUT_OF_STEPS;
             break;
         }
+        if (currentEntry != firstEntry && deadline.hasExpired()) {
+            // Out of time => cut the sequence short, and finish it with the heuristic.
+            status = SearchStatus::OUT_OF_STEPS;
+            break;
+        }
         // Step the search forward.
         Model::StepResult result = generator->getStep(currentEntry, currentEntry->getState(),
                 currentNode->getHistoricalData());
 
         // Null action => stop the search.
         if (result.action == nullptr) {
+            if (status == SearchStatus::FINISHED) {
+                // The generator has already estimated the value of the last state.
+                currentEntry->immediateReward_ = result.reward;
+            }
             break;
         }
 
@@ -134,10 +150,15 @@ SearchStatus BasicSearchStrategy::extendAndBackup(HistorySequence *sequence, lon
         // Create the child belief node, and set the current node to be that node.
         BeliefNode *nextNode = currentNode->createOrGetChild(*currentEntry->action_,
                 *currentEntry->observation_);
+        if (useVirtualLoss) {
+            currentNode->addVirtualLoss(*currentEntry->action_, +1);
+            virtualLossEntries.push_back(currentEntry);
+        }
         currentNode = nextNode;
 
         // Now we create a new history entry and step the history forward.
-        StateInfo *nextStateInfo = solver_->getStatePool()->createOrGetInfo(*result.nextState);
+        StateInfo *nextStateInfo = solver_->getStatePool()->createOrAdoptInfo(
+                std::move(result.nextState));
         currentEntry = sequence->addEntry();
 
         // Register the new history entry with its state, and with its associated belief node.
@@ -179,6 +200,10 @@ SearchStatus BasicSearchStrategy::extendAndBackup(HistorySequence *sequence, lon
         }
     }
 
+    for (HistoryEntry const *entry : virtualLossEntries) {
+        entry->getAssociatedBeliefNode()->addVirtualLoss(*entry->getAction(), -1);
+    }
+
     // Finally, we just return the status.
     return status;
 }
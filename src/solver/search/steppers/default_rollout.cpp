@@ -5,29 +5,224 @@
  */
 #include "solver/search/steppers/default_rollout.hpp"
 
+#include <algorithm>
+
 #include "solver/BeliefNode.hpp"
 #include "solver/HistoryEntry.hpp"
 #include "solver/HistorySequence.hpp"
 #include "solver/Solver.hpp"
 
+#include "solver/abstract-problem/HistoricalData.hpp"
 #include "solver/abstract-problem/Model.hpp"
+#include "solver/abstract-problem/Options.hpp"
 
 #include "solver/mappings/actions/ActionPool.hpp"
 #include "solver/mappings/actions/ActionMapping.hpp"
 
 namespace solver {
+/* ------------------------- RolloutWorkerPool ------------------------- */
+RolloutWorkerPool::RolloutWorkerPool(Solver *solver, long nWorkers) :
+            solver_(solver),
+            nWorkers_(nWorkers),
+            areModelsMade_(false),
+            workersMutex_(),
+            randGens_(),
+            models_(),
+            callerHeuristics_(),
+            threads_(),
+            mutex_(),
+            hasWork_(),
+            hasFinished_(),
+            batches_(),
+            isStopping_(false) {
+}
+
+RolloutWorkerPool::~RolloutWorkerPool() {
+    stopWorkers();
+}
+
+double RolloutWorkerPool::getMeanReturn(Model *model, HistoryEntry const *entry,
+        State const &state, HistoricalData const *data, long maxNSteps, long nRollouts) {
+    startWorkers();
+    HeuristicFunction const &heuristic = getHeuristic(model);
+
+    Batch batch { entry, &state, data, maxNSteps, nRollouts, nRollouts, 0.0 };
+    std::unique_lock<std::mutex> lock(mutex_);
+    batches_.push_back(&batch);
+    hasWork_.notify_all();
+
+    // Help out with our own batch until all of its rollouts have been claimed.
+    while (batch.nUnclaimed > 0) {
+        claimRollout(&batch);
+        lock.unlock();
+        double value = doRollout(model, heuristic, batch);
+        lock.lock();
+        batch.totalReturn += value;
+        batch.nUnfinished--;
+    }
+    hasFinished_.wait(lock, [&batch] () { return batch.nUnfinished == 0; });
+    return batch.totalReturn / nRollouts;
+}
+
+void RolloutWorkerPool::applyChanges(std::vector<std::unique_ptr<ModelChange>> const &changes) {
+    std::lock_guard<std::mutex> lock(workersMutex_);
+    // The threads are restarted when they're next needed, with the new heuristics.
+    stopWorkers();
+    callerHeuristics_.clear();
+    for (std::unique_ptr<Model> &workerModel : models_) {
+        workerModel->applyChanges(changes, nullptr);
+    }
+}
+
+void RolloutWorkerPool::claimRollout(Batch *batch) {
+    batch->nUnclaimed--;
+    if (batch->nUnclaimed == 0) {
+        batches_.erase(std::find(batches_.begin(), batches_.end(), batch));
+    }
+}
+
+HeuristicFunction const &RolloutWorkerPool::getHeuristic(Model *model) {
+    std::lock_guard<std::mutex> lock(workersMutex_);
+    auto it = callerHeuristics_.find(model);
+    if (it == callerHeuristics_.end()) {
+        it = callerHeuristics_.emplace(model, model->getHeuristicFunction()).first;
+    }
+    return it->second;
+}
+
+double RolloutWorkerPool::doRollout(Model *model, HeuristicFunction const &heuristic,
+        Batch const &batch) {
+    double discountFactor = solver_->getOptions()->discountFactor;
+    HistoryEntry const *entry = batch.entry;
+    State const *state = batch.state;
+    HistoricalData const *data = batch.data;
+
+    // These own the states and data made along the way.
+    std::unique_ptr<State> currentState = nullptr;
+    std::unique_ptr<HistoricalData> currentData = nullptr;
+
+    double totalReturn = 0;
+    double discount = 1.0;
+    for (long step = 0; ; step++) {
+        if (step >= batch.maxNSteps || (step > 0 && solver_->getSearchDeadline().hasExpired())) {
+            // Out of steps or out of time => finish with the heuristic, as a serial rollout does.
+            totalReturn += discount * heuristic(entry, state, data);
+            break;
+        }
+        std::unique_ptr<Action> action = model->getRolloutAction(entry, state, data);
+        if (action == nullptr) {
+            break;
+        }
+        Model::StepResult result = model->generateStep(*state, *action);
+        totalReturn += discount * result.reward;
+        if (result.isTerminal) {
+            break;
+        }
+        discount *= discountFactor;
+
+        // Only the first step has a history entry.
+        entry = nullptr;
+        if (data != nullptr) {
+            currentData = data->createChild(*action, *result.observation);
+            data = currentData.get();
+        }
+        currentState = std::move(result.nextState);
+        state = currentState.get();
+    }
+    return totalReturn;
+}
+
+void RolloutWorkerPool::startWorkers() {
+    std::lock_guard<std::mutex> lock(workersMutex_);
+    if (!threads_.empty()) {
+        return;
+    }
+    if (!areModelsMade_) {
+        // The models are kept up to date via applyChanges(), so they are only made once.
+        areModelsMade_ = true;
+        Model *model = solver_->getModel();
+        for (long i = 0; i < nWorkers_; i++) {
+            // Each worker gets its own RNG stream, seeded from the model's.
+            std::unique_ptr<RandomGenerator> randGen = std::make_unique<RandomGenerator>(
+                    (*model->getRandomGenerator())());
+            std::unique_ptr<Model> workerModel = model->createWorkerModel(randGen.get());
+            if (workerModel == nullptr) {
+                debug::show_message("WARNING: This model cannot create worker models;"
+                        " rollouts will not run in parallel.");
+                break;
+            }
+            randGens_.push_back(std::move(randGen));
+            models_.push_back(std::move(workerModel));
+        }
+    }
+    if (models_.empty()) {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> queueLock(mutex_);
+        isStopping_ = false;
+    }
+    for (std::unique_ptr<Model> &workerModel : models_) {
+        threads_.emplace_back(&RolloutWorkerPool::runWorker, this, workerModel.get(),
+                workerModel->getHeuristicFunction());
+    }
+}
+
+void RolloutWorkerPool::stopWorkers() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        isStopping_ = true;
+    }
+    hasWork_.notify_all();
+    for (std::thread &thread : threads_) {
+        thread.join();
+    }
+    threads_.clear();
+}
+
+void RolloutWorkerPool::runWorker(Model *model, HeuristicFunction heuristic) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        hasWork_.wait(lock, [this] () { return isStopping_ || !batches_.empty(); });
+        if (isStopping_) {
+            return;
+        }
+        Batch *batch = batches_.front();
+        claimRollout(batch);
+        lock.unlock();
+        double value = doRollout(model, heuristic, *batch);
+        lock.lock();
+        batch->totalReturn += value;
+        batch->nUnfinished--;
+        if (batch->nUnfinished == 0) {
+            hasFinished_.notify_all();
+        }
+    }
+}
+
 /* ------------------------- DefaultRolloutGenerator ------------------------- */
 DefaultRolloutGenerator::DefaultRolloutGenerator(SearchStatus &status,
-        Solver *solver, long maxNSteps) :
+        Solver *solver, long maxNSteps, RolloutWorkerPool *pool, long nRollouts) :
             StepGenerator(status),
             model_(solver->getModel()),
             maxNSteps_(maxNSteps),
-            currentNSteps_(0) {
+            currentNSteps_(0),
+            pool_(pool),
+            nRollouts_(nRollouts) {
     status_ = SearchStatus::INITIAL;
 }
 
 Model::StepResult DefaultRolloutGenerator::getStep(HistoryEntry const *entry, State const *state,
         HistoricalData const *data) {
+    if (pool_ != nullptr) {
+        // The rollouts aren't added to the tree; their mean return is the value of this state.
+        status_ = SearchStatus::FINISHED;
+        Model::StepResult result;
+        result.reward = pool_->getMeanReturn(model_, entry, *state, data, maxNSteps_, nRollouts_);
+        return result;
+    }
+
     // If we've hit the step limit, we don't generate any more steps.
     if (currentNSteps_ >= maxNSteps_) {
         status_ = SearchStatus::OUT_OF_STEPS;
@@ -41,14 +236,20 @@ Model::StepResult DefaultRolloutGenerator::getStep(HistoryEntry const *entry, St
 }
 
 /* ------------------------- DefaultRolloutFactory ------------------------- */
-DefaultRolloutFactory::DefaultRolloutFactory(Solver *solver, long maxNSteps) :
+DefaultRolloutFactory::DefaultRolloutFactory(Solver *solver, long maxNSteps, long nRollouts) :
             solver_(solver),
-            maxNSteps_(maxNSteps) {
+            maxNSteps_(maxNSteps),
+            nRollouts_(nRollouts),
+            pool_(nullptr) {
+    if (nRollouts_ > 1) {
+        pool_ = solver_->getRolloutWorkerPool();
+    }
 }
 
 std::unique_ptr<StepGenerator> DefaultRolloutFactory::createGenerator(SearchStatus &status,
         HistoryEntry const */*entry*/, State const */*state*/, HistoricalData const */*data*/) {
-    return std::make_unique<DefaultRolloutGenerator>(status, solver_, maxNSteps_);
+    return std::make_unique<DefaultRolloutGenerator>(status, solver_, maxNSteps_, pool_,
+            nRollouts_);
 }
 
 } /* namespace solver */
@@ -6,6 +6,18 @@
 #ifndef SOLVER_DEFAULTROLLOUTSTRATEGY_HPP_
 #define SOLVER_DEFAULTROLLOUTSTRATEGY_HPP_
 
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "global.hpp"
+
+#include "solver/abstract-problem/heuristics/HeuristicFunction.hpp"
+
 #include "solver/search/SearchStatus.hpp"
 #include "solver/search/search_interface.hpp"
 
@@ -14,15 +26,110 @@ class HistoricalData;
 class HistorySequence;
 class Solver;
 
+/** A pool of worker threads for running many independent rollouts from the same state at once.
+ *
+ * Each worker has its own copy of the model, made via Model::createWorkerModel(); the thread that
+ * requests the rollouts also runs some of them itself, using its own model. If the model cannot
+ * create worker models all of the rollouts are simply run by the requesting thread.
+ *
+ * A rollout that is cut short by its step limit or by the search deadline is finished with the
+ * model's heuristic value for its last state, just as a serial rollout would be.
+ */
+class RolloutWorkerPool {
+public:
+    /** Makes a new pool with the given number of worker threads for the given solver; the threads
+     * are only started when they are first needed.
+     */
+    RolloutWorkerPool(Solver *solver, long nWorkers);
+    ~RolloutWorkerPool();
+    _NO_COPY_OR_MOVE(RolloutWorkerPool);
+
+    /** Runs the given number of independent rollouts of at most maxNSteps steps, starting from
+     * the given state, and returns the mean of their discounted returns.
+     *
+     * The given model is the one belonging to the calling thread.
+     */
+    double getMeanReturn(Model *model, HistoryEntry const *entry, State const &state,
+            HistoricalData const *data, long maxNSteps, long nRollouts);
+    /** Applies the given changes to the models of the worker threads, which must be idle. */
+    void applyChanges(std::vector<std::unique_ptr<ModelChange>> const &changes);
+
+private:
+    /** A group of rollouts requested by a single call to getMeanReturn(). */
+    struct Batch {
+        HistoryEntry const *entry;
+        State const *state;
+        HistoricalData const *data;
+        long maxNSteps;
+        /** The number of rollouts that have yet to be claimed by a thread. */
+        long nUnclaimed;
+        /** The number of rollouts that have yet to finish. */
+        long nUnfinished;
+        /** The sum of the returns of the finished rollouts. */
+        double totalReturn;
+    };
+
+    /** Claims one rollout from the given batch; the pool mutex must be held. */
+    void claimRollout(Batch *batch);
+    /** Returns the heuristic function of the given model belonging to a requesting thread. */
+    HeuristicFunction const &getHeuristic(Model *model);
+    /** Runs a single rollout of the given batch using the given model and its heuristic. */
+    double doRollout(Model *model, HeuristicFunction const &heuristic, Batch const &batch);
+    /** Starts the worker threads if they have not been started, making their models first if
+     * they have not been made.
+     */
+    void startWorkers();
+    /** Stops and joins all of the worker threads; their models are kept. */
+    void stopWorkers();
+    /** The main loop of a worker thread, which will use the given model and heuristic. */
+    void runWorker(Model *model, HeuristicFunction heuristic);
+
+    /** The associated solver. */
+    Solver *solver_;
+    /** The number of worker threads to use. */
+    long nWorkers_;
+    /** True iff the models for the worker threads have been made. */
+    bool areModelsMade_;
+
+    /** Guards the starting and stopping of the worker threads, and changes to their models. */
+    std::mutex workersMutex_;
+    /** The random number generators for the worker models. */
+    std::vector<std::unique_ptr<RandomGenerator>> randGens_;
+    /** The models used by the worker threads. */
+    std::vector<std::unique_ptr<Model>> models_;
+    /** The heuristic functions of the models of the requesting threads. */
+    std::unordered_map<Model *, HeuristicFunction> callerHeuristics_;
+    /** The worker threads. */
+    std::vector<std::thread> threads_;
+
+    /** Guards the batch queue and the contents of the batches. */
+    std::mutex mutex_;
+    /** Notifies the workers that there are rollouts to run, or that they should stop. */
+    std::condition_variable hasWork_;
+    /** Notifies requesting threads that a batch is complete. */
+    std::condition_variable hasFinished_;
+    /** The batches that still have unclaimed rollouts. */
+    std::deque<Batch *> batches_;
+    /** True iff the worker threads have been asked to stop. */
+    bool isStopping_;
+};
+
 /** A StepGenerator implementation that simply queries the model for a rollout action at each
  * time step.
+ *
+ * If a RolloutWorkerPool is given, the generator instead runs several independent rollouts in
+ * parallel, without adding them to the tree, and finishes the history with the mean of their
+ * returns as the value of the final state.
  */
 class DefaultRolloutGenerator: public StepGenerator {
 public:
     /** Makes a new DefaultRolloutGenerator, which will be associated with the given solver, and
      * will only take the specified maximum # of steps in depth.
+     *
+     * If pool is not null, nRollouts rollouts will be run using the pool.
      */
-    DefaultRolloutGenerator(SearchStatus &status, Solver *solver, long maxNSteps);
+    DefaultRolloutGenerator(SearchStatus &status, Solver *solver, long maxNSteps,
+            RolloutWorkerPool *pool = nullptr, long nRollouts = 1);
     virtual ~DefaultRolloutGenerator() = default;
     _NO_COPY_OR_MOVE(DefaultRolloutGenerator);
 
@@ -36,14 +143,23 @@ private:
     long maxNSteps_;
     /** The number of steps taken so far. */
     long currentNSteps_;
+    /** The pool used to run the rollouts in parallel, or nullptr for a single serial rollout. */
+    RolloutWorkerPool *pool_;
+    /** The number of rollouts to run in the pool. */
+    long nRollouts_;
 };
 
 
 /** A factory class to create instances of DefaultRolloutGenerator. */
 class DefaultRolloutFactory: public StepGeneratorFactory {
 public:
-    /** Creates a new rollout factory with the given solver, and the given max # of steps. */
-    DefaultRolloutFactory(Solver *solver, long maxNSteps);
+    /** Creates a new rollout factory with the given solver, and the given max # of steps.
+     *
+     * If nRollouts is greater than one, each history will be finished with the mean return of
+     * that many rollouts; they are run in parallel in the pool of the solver (see
+     * Solver::getRolloutWorkerPool()).
+     */
+    DefaultRolloutFactory(Solver *solver, long maxNSteps, long nRollouts = 1);
     virtual ~DefaultRolloutFactory() = default;
     _NO_COPY_OR_MOVE(DefaultRolloutFactory);
 
@@ -55,6 +171,10 @@ private:
     Solver *solver_;
     /** The maximum number of steps to take in a rollout. */
     long maxNSteps_;
+    /** The number of rollouts to run for each history. */
+    long nRollouts_;
+    /** The pool used to run the rollouts, if there is more than one per history. */
+    RolloutWorkerPool *pool_;
 };
 
 } /* namespace solver */
@@ -4,21 +4,34 @@
  */
 #include "solver/search/steppers/nn_rollout.hpp"
 
+#include <limits>
+#include <mutex>
+#include <vector>
+
 #include "solver/BeliefNode.hpp"
 #include "solver/BeliefTree.hpp"
 #include "solver/HistoryEntry.hpp"
 #include "solver/HistorySequence.hpp"
 #include "solver/Solver.hpp"
 
+#include "solver/abstract-problem/Model.hpp"
+
 #include "solver/mappings/actions/ActionMapping.hpp"
 
 namespace solver {
+namespace {
+/** The maximum number of pairs of particles to sample when comparing two beliefs. */
+long const MAX_SAMPLED_PAIRS = 1000;
+} /* namespace */
 
 NnRolloutFactory::NnRolloutFactory(Solver *solver, long maxNnComparisons, double maxNnDistance) :
             solver_(solver),
             maxNnComparisons_(maxNnComparisons),
             maxNnDistance_(maxNnDistance),
-            nnMap_() {
+            nnMap_(),
+            randGen_((*solver->getModel()->getRandomGenerator())()),
+            index_(solver),
+            mutex_() {
 }
 
 BeliefNode* NnRolloutFactory::findNeighbor(BeliefNode *belief) {
@@ -27,25 +40,47 @@ BeliefNode* NnRolloutFactory::findNeighbor(BeliefNode *belief) {
         return nullptr;
     }
 
-    // Initially there is no minimum distance, unless we've already stored a neighbor.
+    std::lock_guard<std::mutex> lock(mutex_);
+    BeliefTree *tree = solver_->getPolicy();
+    std::vector<double> mean;
+    bool isEmbedded = belief->getStateVectorMoments(mean) >= 0;
+
+    // Initially there is no minimum distance, unless we've already stored a neighbor that is
+    // still in the tree.
     double minDist = std::numeric_limits<double>::infinity();
-    BeliefNode *nearestBelief = nnMap_[belief].neighbor;
-    if (nearestBelief != nullptr) {
-        minDist = belief->distL1Independent(nearestBelief);
+    BeliefNode *nearestBelief = nullptr;
+    NnData &nnData = nnMap_[belief];
+    if (nnData.neighbor != nullptr && tree->getNode(nnData.neighborId) == nnData.neighbor) {
+        nearestBelief = nnData.neighbor;
+        if (isEmbedded) {
+            minDist = BeliefEmbeddingIndex::getDistance(belief, nearestBelief);
+        } else {
+            minDist = getSampledDistance(belief, nearestBelief);
+        }
     }
 
-    long numTried = 0;
-    for (BeliefNode *otherBelief : solver_->getPolicy()->getNodes()) {
-        // Obviously we don't want the belief itself.
-        if (belief == otherBelief) {
-            continue;
+    if (isEmbedded) {
+        double distance;
+        BeliefNode *otherBelief = index_.findNearest(belief, maxNnComparisons_, distance);
+        if (otherBelief != nullptr && distance < minDist) {
+            minDist = distance;
+            nearestBelief = otherBelief;
         }
-
-        if (numTried >= maxNnComparisons_) {
-            // Stop if we reach the maximum # of comparisons.
-            break;
-        } else {
-            double distance = belief->distL1Independent(otherBelief);
+    } else {
+        long numTried = 0;
+        long nNodes = tree->getNumberOfNodes();
+        // Stop if we reach the maximum # of comparisons.
+        for (long id = 0; id < nNodes && numTried < maxNnComparisons_; id++) {
+            BeliefNode *otherBelief = tree->getNode(id);
+            // The tree may have shrunk since the nodes were counted.
+            if (otherBelief == nullptr) {
+                break;
+            }
+            // Obviously we don't want the belief itself.
+            if (belief == otherBelief) {
+                continue;
+            }
+            double distance = getSampledDistance(belief, otherBelief);
             if (distance < minDist) {
                 minDist = distance;
                 nearestBelief = otherBelief;
@@ -55,15 +90,24 @@ BeliefNode* NnRolloutFactory::findNeighbor(BeliefNode *belief) {
     }
 
     // If it's not near enough, we've failed.
-    if (minDist > maxNnDistance_) {
+    if (nearestBelief == nullptr || minDist > maxNnDistance_) {
         return nullptr;
     }
 
     // Otherwise update the mapping with the new neighbor.
-    nnMap_[belief].neighbor = nearestBelief;
+    nnData.neighbor = nearestBelief;
+    nnData.neighborId = nearestBelief->getId();
     return nearestBelief;
 }
 
+double NnRolloutFactory::getSampledDistance(BeliefNode *belief, BeliefNode *otherBelief) {
+    // Other threads may be changing the particles of either node.
+    std::unique_lock<std::mutex> lock(belief->getMutex(), std::defer_lock);
+    std::unique_lock<std::mutex> otherLock(otherBelief->getMutex(), std::defer_lock);
+    std::lock(lock, otherLock);
+    return belief->distL1Sampled(otherBelief, maxNnDistance_ / 10, MAX_SAMPLED_PAIRS, randGen_);
+}
+
 std::unique_ptr<StepGenerator> NnRolloutFactory::createGenerator(SearchStatus &status,
         HistoryEntry const *entry, State const */*state*/, HistoricalData const */*data*/) {
     // Find a neighbor, and use it to make a new generator.
@@ -93,6 +137,11 @@ Model::StepResult NnRolloutGenerator::getStep(HistoryEntry const */*entry*/, Sta
 
     // Generate a step using the recommended action from the neighboring node.
     std::unique_ptr<Action> action = currentNeighborNode_->getRecommendedAction();
+    if (action == nullptr) {
+        // The neighbor hasn't tried any actions yet, so it has nothing to recommend.
+        status_ = SearchStatus::OUT_OF_STEPS;
+        return Model::StepResult { };
+    }
     Model::StepResult result = model_->generateStep(*state, *action);
 
     // getChild() will return nullptr if the child doesn't yet exist => this will be the last step.
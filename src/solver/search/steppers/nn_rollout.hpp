@@ -7,8 +7,13 @@
 #ifndef SOLVER_NN_ROLLOUT_HPP_
 #define SOLVER_NN_ROLLOUT_HPP_
 
+#include <mutex>
 #include <unordered_map>
 
+#include "global.hpp"
+
+#include "solver/indexing/BeliefEmbeddingIndex.hpp"
+
 #include "solver/search/SearchStatus.hpp"
 #include "solver/search/search_interface.hpp"
 
@@ -17,18 +22,24 @@ namespace solver {
 struct NnData {
     /** The closest neighbor found so far for this node. */
     BeliefNode *neighbor = nullptr;
+    /** The ID of the neighbor when it was found, used to check that it is still in the tree. */
+    long neighborId = -1;
 };
 
 /** A factory class for creating individual instances of the NN-based rollout strategy.
  *
  * This class also keeps track of a mapping of nodes to near neighbors for those nodes, which
  * can then be used by the individual NNRolloutGenerator instances.
+ *
+ * If the states are VectorStates, neighbors are found using a BeliefEmbeddingIndex, and the
+ * distances are as defined there; otherwise, the beliefs are compared one by one using
+ * BeliefNode::distL1Sampled(), to within a tenth of the maximum distance for a near neighbor.
  */
 class NnRolloutFactory: public StepGeneratorFactory {
 public:
     /** Creates a new NnRolloutFactory associated with the given solver, and with the given
-     * max # of NN comparisons to do, and the given maximum distance to be considered a "near"
-     * neighbor.
+     * max # of NN comparisons to do (or, when the index is used, the number of candidates it
+     * returns), and the given maximum distance to be considered a "near" neighbor.
      */
     NnRolloutFactory(Solver *solver, long maxNnComparisons, double maxNnDistance);
     virtual ~NnRolloutFactory() = default;
@@ -41,6 +52,9 @@ public:
             HistoryEntry const *entry, State const *state, HistoricalData const *data) override;
 
 private:
+    /** Returns the sampled distance between the two given beliefs. */
+    double getSampledDistance(BeliefNode *belief, BeliefNode *otherBelief);
+
     /** The associated solver. */
     Solver *solver_;
     /** The maximum number of NN comparisons to try for a new rollout. */
@@ -49,6 +63,12 @@ private:
     double maxNnDistance_;
     /** A mapping from belief nodes to data about their near neighbors .*/
     std::unordered_map<BeliefNode *, NnData> nnMap_;
+    /** The random number generator used to sample pairs of particles when comparing beliefs. */
+    RandomGenerator randGen_;
+    /** The index used to find neighbors for beliefs over vector states. */
+    BeliefEmbeddingIndex index_;
+    /** Guards the neighbor mapping and the index, which are shared by all searching threads. */
+    std::mutex mutex_;
 };
 
 /** Implementation of an NN-based StepGenerator instance. */
@@ -10,16 +10,16 @@
 #include "solver/HistorySequence.hpp"
 #include "solver/Solver.hpp"
 
-#include "solver/search/action-choosers/choosers.hpp"
-
 #include "solver/mappings/actions/ActionMapping.hpp"
+#include "solver/mappings/actions/ActionMappingEntry.hpp"
 
 namespace solver {
 UcbStepGenerator::UcbStepGenerator(SearchStatus &status, Solver *solver,
-        double explorationCoefficient) :
+        double explorationCoefficient, double virtualLoss) :
             StepGenerator(status),
             model_(solver->getModel()),
             explorationCoefficient_(explorationCoefficient),
+            virtualLoss_(virtualLoss),
             choseUnvisitedAction_(false) {
     status_ = SearchStatus::INITIAL;
 }
@@ -37,13 +37,31 @@ Model::StepResult UcbStepGenerator::getStep(HistoryEntry const *entry, State con
     BeliefNode *currentNode = entry->getAssociatedBeliefNode();
     ActionMapping *mapping = currentNode->getMapping();
 
-    std::unique_ptr<Action> action = mapping->getNextActionToTry();
-    if (action != nullptr) {
-        // If there are unvisited actions, we take one, and we're finished with UCB search.
-        choseUnvisitedAction_ = true;
-    } else {
-        // Use UCB to get the best action.
-        action = choosers::ucb_action(currentNode, explorationCoefficient_);
+    // The action is borrowed from the mapping entry if possible, and copied only if not.
+    std::unique_ptr<Action> ownedAction;
+    Action const *action = nullptr;
+    {
+        // Other search threads may be updating this node.
+        std::lock_guard<std::mutex> lock(currentNode->getMutex());
+        // Claiming the action under the lock means no other thread can try it at the same time.
+        ownedAction = mapping->getNextActionToTry();
+        if (ownedAction != nullptr) {
+            // If there are unvisited actions, we take one, and we're finished with UCB search.
+            choseUnvisitedAction_ = true;
+        } else {
+            // Use UCB to get the best action.
+            ActionMappingEntry const *bestEntry = mapping->getUcbEntry(explorationCoefficient_,
+                    virtualLoss_);
+            if (bestEntry != nullptr) {
+                action = bestEntry->peekAction();
+                if (action == nullptr) {
+                    ownedAction = bestEntry->getAction();
+                }
+            }
+        }
+    }
+    if (ownedAction != nullptr) {
+        action = ownedAction.get();
     }
 
     // NO action -> error!
@@ -53,17 +71,20 @@ Model::StepResult UcbStepGenerator::getStep(HistoryEntry const *entry, State con
         return Model::StepResult { };
     }
 
-    // Use the model to generate the step.
+    // Use the model to generate the step; this copies the action into the history.
     return model_->generateStep(*state, *action);
 }
 
-UcbStepGeneratorFactory::UcbStepGeneratorFactory(Solver *solver, double explorationCoefficient) :
+UcbStepGeneratorFactory::UcbStepGeneratorFactory(Solver *solver, double explorationCoefficient,
+        double virtualLoss) :
             solver_(solver),
-            explorationCoefficient_(explorationCoefficient) {
+            explorationCoefficient_(explorationCoefficient),
+            virtualLoss_(virtualLoss) {
 }
 
 std::unique_ptr<StepGenerator> UcbStepGeneratorFactory::createGenerator(SearchStatus &status,
         HistoryEntry const */*entry*/, State const */*state*/, HistoricalData const */*data*/) {
-    return std::make_unique<UcbStepGenerator>(status, solver_, explorationCoefficient_);
+    return std::make_unique<UcbStepGenerator>(status, solver_, explorationCoefficient_,
+            virtualLoss_);
 }
 } /* namespace solver */
@@ -19,9 +19,10 @@ namespace solver {
 class UcbStepGenerator : public StepGenerator {
 public:
     /** Creates a new UcbStepGenerator associated with the given solver, and using the given
-     * value for the UCB exploration coefficient.
+     * values for the UCB exploration coefficient and the virtual loss.
      */
-    UcbStepGenerator(SearchStatus &status, Solver *solver, double explorationCoefficient);
+    UcbStepGenerator(SearchStatus &status, Solver *solver, double explorationCoefficient,
+            double virtualLoss);
     ~UcbStepGenerator() = default;
     _NO_COPY_OR_MOVE(UcbStepGenerator);
 
@@ -33,6 +34,8 @@ private:
     Model *model_;
     /** The exploration coefficient for UCB. */
     double explorationCoefficient_;
+    /** The value penalty for each virtual loss, for tree-parallel search. */
+    double virtualLoss_;
 
     /** True iff the last action selected hadn't been tried before. */
     bool choseUnvisitedAction_;
@@ -42,9 +45,10 @@ private:
 class UcbStepGeneratorFactory: public StepGeneratorFactory {
 public:
     /** Creates a new factory associated with the given solver, and with the given UCB exploration
-     * coefficient.
+     * coefficient and virtual loss.
      */
-    UcbStepGeneratorFactory(Solver *solver, double explorationCoefficient);
+    UcbStepGeneratorFactory(Solver *solver, double explorationCoefficient,
+            double virtualLoss = 0);
     virtual ~UcbStepGeneratorFactory() = default;
     _NO_COPY_OR_MOVE(UcbStepGeneratorFactory);
 
@@ -55,6 +59,8 @@ private:
     Solver *solver_;
     /** The exploration coefficient for UCB. */
     double explorationCoefficient_;
+    /** The value penalty for each virtual loss, for tree-parallel search. */
+    double virtualLoss_;
 };
 
 } /* namespace solver */
@@ -75,6 +75,12 @@ public:
      * output stream.
      */
     virtual void save(std::ostream &os) {
+        // The reclaimer changes the indices of the nodes and histories.
+        solver_->finishReclaiming();
+        // Only the statistics backed by the saved histories can be restored on loading.
+        solver_->removeMergedStatistics();
+        // The changes accumulated below the backup tolerance aren't saved.
+        solver_->flushBackup();
         save(*(solver_->statePool_), os);
         save(*(solver_->histories_), os);
         saveActionPool(*(solver_->actionPool_), os);
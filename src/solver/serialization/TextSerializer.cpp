@@ -118,9 +118,9 @@ void TextSerializer::load(StateInfo &info, std::istream &is) {
 
 void TextSerializer::save(StatePool const &pool, std::ostream &os) {
     os << "STATESPOOL-BEGIN" << std::endl;
-    os << "numStates: " << pool.stateInfoMap_.size() << std::endl;
-    for (std::unique_ptr<StateInfo> const &stateInfo : pool.statesByIndex_) {
-        save(*stateInfo, os);
+    os << "numStates: " << pool.getNumberOfStates() << std::endl;
+    for (long id = 0; id < pool.getNumberOfStates(); id++) {
+        save(*pool.getInfoById(id), os);
         os << std::endl;
     }
     os << "STATESPOOL-END" << std::endl;
@@ -207,9 +207,9 @@ void TextSerializer::load(HistoryEntry &entry, std::istream &is) {
 
 void TextSerializer::save(HistorySequence const &seq, std::ostream &os) {
     os << "HistorySequence " << seq.id_;
-    os << " - length " << seq.entrySequence_.size() << std::endl;
-    for (std::unique_ptr<HistoryEntry> const &entry : seq.entrySequence_) {
-        save(*entry, os);
+    os << " - length " << seq.getLength() << std::endl;
+    for (long i = 0; i < seq.getLength(); i++) {
+        save(*seq.getEntry(i), os);
         os << std::endl;
     }
 }
@@ -223,12 +223,10 @@ void TextSerializer::load(HistorySequence &seq, std::istream &is) {
     sstr >> tmpStr >> seq.id_ >> tmpStr >> tmpStr >> seqLength;
     for (int i = 0; i < seqLength; i++) {
         std::getline(is, line);
-        std::unique_ptr<HistoryEntry> entry(std::make_unique<HistoryEntry>());
+        HistoryEntry *entry = seq.addEntry();
         sstr.clear();
         sstr.str(line);
         load(*entry, sstr);
-        entry->owningSequence_ = &seq;
-        seq.entrySequence_.push_back(std::move(entry));
     }
 }
 
@@ -258,9 +256,7 @@ void TextSerializer::load(Histories &histories, std::istream &is) {
     std::getline(is, line);
 
     for (int i = 0; i < numHistories; i++) {
-        std::unique_ptr<HistorySequence> sequence(std::make_unique<HistorySequence>());
-        load(*sequence, is);
-        histories.sequencesById_.push_back(std::move(sequence));
+        load(*histories.createSequence(), is);
     }
     std::getline(is, line);
     while (line.find("HISTORIES-END") == std::string::npos) {